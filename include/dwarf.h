@@ -272,10 +272,12 @@ dwarf_stackable_reg_state_t;
 typedef struct dwarf_reg_cache_entry
   {
     unw_word_t ip;                        /* ip this rs is for */
-    unsigned short coll_chain;  /* used for hash collisions */
-    unsigned short hint;              /* hint for next rs to try (or -1) */
+    uint32_t coll_chain;        /* used for hash collisions */
+    uint32_t hint;              /* hint for next rs to try (or -1) */
     unsigned short valid : 1;         /* optional machine-dependent signal info */
     unsigned short signal_frame : 1;  /* optional machine-dependent signal info */
+    unsigned char referenced;   /* used since the clock hand last passed?
+                                   (a byte of its own: lockless readers set it) */
   }
 dwarf_reg_cache_entry_t;
 
@@ -289,6 +291,7 @@ typedef struct dwarf_cie_info
     unw_word_t data_align;      /* data-alignment factor */
     unw_word_t ret_addr_column; /* column of return-address register */
     unw_word_t handler;         /* address of personality-routine */
+    unw_word_t cie_addr;        /* CIE address, 0 in .debug_frame */
     uint16_t abi;
     uint16_t tag;
     uint8_t fde_encoding;
@@ -328,8 +331,8 @@ typedef struct dwarf_cursor
     unsigned int pi_is_dynamic :1; /* proc_info found via dynamic proc info? */
     unw_proc_info_t pi;         /* info about current procedure */
 
-    short hint; /* faster lookup of the rs cache */
-    short prev_rs;
+    uint32_t hint; /* faster lookup of the rs cache */
+    uint32_t prev_rs;
   }
 dwarf_cursor_t;
 
@@ -339,31 +342,65 @@ dwarf_cursor_t;
 #define DWARF_DEFAULT_LOG_UNW_HASH_SIZE (DWARF_DEFAULT_LOG_UNW_CACHE_SIZE + 1)
 #define DWARF_DEFAULT_UNW_HASH_SIZE     (1 << DWARF_DEFAULT_LOG_UNW_HASH_SIZE)
 
-typedef unsigned char unw_hash_index_t;
+/* Largest rs-cache accepted by unw_set_cache_size().  */
+#define DWARF_MAX_LOG_UNW_CACHE_SIZE    20
+
+typedef uint32_t unw_hash_index_t;
 
 struct dwarf_rs_cache
   {
     pthread_mutex_t lock;
-    unsigned short rr_head;    /* index of least-recently allocated rs */
+    uint32_t clock_hand;       /* next rs considered for replacement */
 
     unsigned short log_size;
     unsigned short prev_log_size;
 
     /* hash table that maps instruction pointer to rs index: */
-    unsigned short *hash;
+    uint32_t *hash;
 
     _Atomic uint32_t generation;        /* generation number */
+    _Atomic uint32_t seq;       /* odd while the tables are being updated */
 
     /* rs cache: */
     dwarf_reg_state_t *buckets;
     dwarf_reg_cache_entry_t *links;
 
+    /* replaced tables kept mapped for lockless readers: */
+    struct dwarf_rs_retired *retired;
+
     /* default memory, loaded in BSS segment */
-    unsigned short default_hash[DWARF_DEFAULT_UNW_HASH_SIZE];
+    uint32_t default_hash[DWARF_DEFAULT_UNW_HASH_SIZE];
     dwarf_reg_state_t default_buckets[DWARF_DEFAULT_UNW_CACHE_SIZE];
     dwarf_reg_cache_entry_t default_links[DWARF_DEFAULT_UNW_CACHE_SIZE];
   };
 
+/* Parsed CIEs of an address space, so that the FDEs sharing a CIE
+   need not decode it again.  Along with the CIE fields, an entry keeps
+   the register state after the CIE's initial instructions once
+   setup_fde() has computed it.  The cache is direct-mapped: a hash of
+   the CIE address selects the only entry that may hold the CIE, and a
+   new CIE replaces whatever that entry held.  See Gfde.c for the
+   locking.  */
+
+#define DWARF_LOG_CIE_CACHE_SIZE        4
+#define DWARF_CIE_CACHE_SIZE            (1 << DWARF_LOG_CIE_CACHE_SIZE)
+
+struct dwarf_cie_cache_entry
+  {
+    _Atomic uint32_t seq;       /* odd while the entry is being updated */
+    uint32_t generation;        /* cache_generation when it was filled */
+    unw_word_t cie_addr;        /* 0 if the entry is unused */
+    dwarf_cie_info_t dci;       /* the CIE fields, no FDE fields */
+    unw_word_t args_size;       /* args_size after initial instructions */
+    dwarf_reg_state_t rs_initial; /* reg-state after initial instructions */
+    uint8_t have_rs;            /* args_size and rs_initial are set */
+  };
+
+struct dwarf_cie_cache
+  {
+    struct dwarf_cie_cache_entry entries[DWARF_CIE_CACHE_SIZE];
+  };
+
 /* A list of descriptors for loaded .debug_frame sections.  */
 
 struct unw_debug_frame_list
@@ -381,6 +418,48 @@ struct unw_debug_frame_list
     struct unw_debug_frame_list *next;
   };
 
+/* A compact unwind table: the CFI of one object, compiled into rows
+   sorted by address.  Each row gives the register state from its start
+   up to the start of the next row.  Rows flagged
+   DWARF_COMPACT_UNCOMPILED stand for code without unwind info or with
+   rules that do not fit a row; lookups there take the normal path.  */
+
+#define DWARF_COMPACT_UNCOMPILED        0x1
+#define DWARF_COMPACT_SIGNAL_FRAME      0x2
+
+struct dwarf_compact_row
+  {
+    uint32_t start;             /* start address, relative to the table */
+    int32_t cfa_offset;         /* CFA = [cfa_reg] + cfa_offset */
+    uint8_t cfa_reg;
+    uint8_t ret_addr_column;
+    uint8_t flags;              /* DWARF_COMPACT_* */
+    uint8_t nsaved;             /* number of saved-register rules */
+    uint32_t saved;             /* index of the first rule in saved[] */
+  };
+
+/* A rule for a column that is not DWARF_WHERE_SAME with value 0.  */
+struct dwarf_compact_saved
+  {
+    uint8_t column;
+    uint8_t where;              /* dwarf_where_t */
+    int32_t val;
+  };
+
+struct dwarf_compact_table
+  {
+    _Atomic (struct dwarf_compact_table *) next;
+    /* The next flushed list, on the address space's retired_compact_tables.  */
+    struct dwarf_compact_table *retired;
+    /* The start (inclusive) and end (exclusive) of the described region.  */
+    unw_word_t start;
+    unw_word_t end;
+    size_t mem_size;
+    size_t row_count;
+    struct dwarf_compact_saved *saved;
+    struct dwarf_compact_row rows[];
+  };
+
 /* Convenience macros: */
 #define dwarf_init                      UNW_ARCH_OBJ (dwarf_init)
 #define dwarf_callback                  UNW_OBJ (dwarf_callback)
@@ -401,6 +480,11 @@ struct unw_debug_frame_list
 #define dwarf_read_encoded_pointer      UNW_OBJ (dwarf_read_encoded_pointer)
 #define dwarf_step                      UNW_OBJ (dwarf_step)
 #define dwarf_flush_rs_cache            UNW_OBJ (dwarf_flush_rs_cache)
+#define dwarf_cie_cache_get_rs          UNW_OBJ (dwarf_cie_cache_get_rs)
+#define dwarf_cie_cache_put_rs          UNW_OBJ (dwarf_cie_cache_put_rs)
+#define dwarf_reg_states_table_iterate  UNW_OBJ (dwarf_reg_states_table_iterate)
+#define dwarf_compact_table_add         UNW_OBJ (dwarf_compact_table_add)
+#define dwarf_compact_table_lookup      UNW_OBJ (dwarf_compact_table_lookup)
 
 extern int dwarf_init (void);
 #ifndef UNW_REMOTE_ONLY
@@ -450,6 +534,20 @@ extern int dwarf_read_encoded_pointer (unw_addr_space_t as,
                                        const unw_proc_info_t *pi,
                                        unw_word_t *valp, void *arg);
 extern int dwarf_step (struct dwarf_cursor *c);
-extern int dwarf_flush_rs_cache (struct dwarf_rs_cache *cache);
+extern int dwarf_flush_rs_cache (struct dwarf_rs_cache *cache,
+                                 unsigned short log_size, int shared);
+extern int dwarf_cie_cache_get_rs (unw_addr_space_t as, unw_word_t cie_addr,
+                                   dwarf_state_record_t *sr);
+extern void dwarf_cie_cache_put_rs (unw_addr_space_t as, unw_word_t cie_addr,
+                                    const dwarf_state_record_t *sr);
+extern int dwarf_reg_states_table_iterate (struct dwarf_cursor *c,
+                                           unw_reg_states_callback cb,
+                                           void *token);
+#ifndef UNW_REMOTE_ONLY
+extern void dwarf_compact_table_add (unw_addr_space_t as, unw_dyn_info_t *di,
+                                     void *arg);
+extern int dwarf_compact_table_lookup (struct dwarf_cursor *c,
+                                       dwarf_state_record_t *sr);
+#endif /* !UNW_REMOTE_ONLY */
 
 #endif /* dwarf_h */
@@ -42,6 +42,7 @@ extern void _UCD_destroy(struct UCD_info *);
 
 extern int _UCD_get_num_threads(struct UCD_info *);
 extern void _UCD_select_thread(struct UCD_info *, int);
+extern struct UCD_info *_UCD_create_for_thread(struct UCD_info *, int);
 extern pid_t _UCD_get_pid(struct UCD_info *);
 extern int _UCD_get_cursig(struct UCD_info *);
 
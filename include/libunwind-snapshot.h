@@ -0,0 +1,75 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef libunwind_snapshot_h
+#define libunwind_snapshot_h
+
+#include <libunwind.h>
+
+#if defined(__cplusplus) || defined(c_plusplus)
+extern "C" {
+#endif
+
+/* Helper routines which make it easy to use libunwind on samples
+   captured from another process, such as those recorded by
+   "perf record --call-graph=dwarf": the registers of a thread, a copy
+   of the top of its stack, and the mappings of the process.  Code and
+   unwind info are read from the files named by the mappings.  They're
+   available only if UNW_REMOTE_ONLY is _not_ defined and they aren't
+   really part of the libunwind API.  They are implemented in a archive
+   library called libunwind-snapshot.a.  */
+
+struct USN_info;
+
+extern struct USN_info *_USN_create (void);
+extern void _USN_destroy (struct USN_info *);
+
+extern int _USN_add_mapping (struct USN_info *, unw_word_t, unw_word_t,
+                             unw_word_t, const char *, const void *, size_t);
+extern int _USN_set_sample (struct USN_info *, const unw_word_t *, unsigned int,
+                            unw_word_t, const void *, size_t);
+
+extern int _USN_find_proc_info (unw_addr_space_t, unw_word_t,
+                                unw_proc_info_t *, int, void *);
+extern void _USN_put_unwind_info (unw_addr_space_t, unw_proc_info_t *, void *);
+extern int _USN_get_dyn_info_list_addr (unw_addr_space_t, unw_word_t *,
+                                        void *);
+extern int _USN_access_mem (unw_addr_space_t, unw_word_t, unw_word_t *, int,
+                            void *);
+extern int _USN_access_reg (unw_addr_space_t, unw_regnum_t, unw_word_t *,
+                            int, void *);
+extern int _USN_access_fpreg (unw_addr_space_t, unw_regnum_t, unw_fpreg_t *,
+                              int, void *);
+extern int _USN_get_proc_name (unw_addr_space_t, unw_word_t, char *, size_t,
+                               unw_word_t *, void *);
+extern int _USN_get_elf_filename (unw_addr_space_t, unw_word_t, char *, size_t,
+                                  unw_word_t *, void *);
+extern int _USN_resume (unw_addr_space_t, unw_cursor_t *, void *);
+extern unw_accessors_t _USN_accessors;
+
+
+#if defined(__cplusplus) || defined(c_plusplus)
+}
+#endif
+
+#endif /* libunwind_snapshot_h */
@@ -301,8 +301,54 @@ extern int unwi_dyn_validate_cache (unw_addr_space_t as, void *arg);
 extern unw_dyn_info_list_t _U_dyn_info_list;
 extern pthread_mutex_t _U_dyn_info_list_lock;
 
+/* Lock-free index of _U_dyn_info_list for local lookups (mi/dyn-index.c). */
+
+#define unwi_dyn_index_insert   UNWI_ARCH_OBJ(dyn_index_insert)
+#define unwi_dyn_index_remove   UNWI_ARCH_OBJ(dyn_index_remove)
+#define unwi_dyn_index_find     UNWI_ARCH_OBJ(dyn_index_find)
+
+extern void unwi_dyn_index_insert (unw_dyn_info_t *di);
+extern void unwi_dyn_index_remove (unw_dyn_info_t *di);
+extern int unwi_dyn_index_find (unw_word_t ip, unw_dyn_info_t **dip);
+
 #define unw_address_is_valid UNWI_ARCH_OBJ(address_is_valid)
 HIDDEN bool unw_address_is_valid(unw_word_t, size_t);
+#define unw_address_validator_flush UNWI_ARCH_OBJ(address_validator_flush)
+HIDDEN void unw_address_validator_flush(unw_addr_space_t);
+
+/* Counters reported by unw_get_stats().  Each address space keeps them
+   in a few stripes of one cache line each.  A thread adds to the stripe
+   picked by its stack address, so concurrent threads rarely share a
+   line, and counting needs neither a lock nor thread-local state.  */
+
+enum unwi_stat
+  {
+    UNWI_STAT_RS_CACHE_HIT,
+    UNWI_STAT_RS_CACHE_MISS,
+    UNWI_STAT_COMPACT_TABLE_HIT,
+    UNWI_STAT_TRACE_CACHE_EXPAND,
+    UNWI_STAT_PHDR_WALK,
+    UNWI_STAT_VALIDATE_SYSCALL,
+    UNWI_STAT_ELF_MAP,
+    UNWI_STAT_MDI_DECOMPRESS,
+    UNWI_STAT_COUNT
+  };
+
+#define UNWI_STATS_STRIPES      8
+#define UNWI_STATS_STACK_SHIFT  23      /* default thread stacks are 8 MiB */
+
+/* Address spaces come from malloc(), so a stripe cannot be aligned to a
+   cache line, but it is one line long.  */
+#define UNWI_STATS_STRIPE_LEN   (64 / sizeof (unsigned long))
+
+struct unwi_stats
+  {
+    struct
+      {
+        _Atomic unsigned long count[UNWI_STATS_STRIPE_LEN];
+      }
+    stripe[UNWI_STATS_STRIPES];
+  };
 
 
 #if defined(UNW_DEBUG)
@@ -400,6 +446,114 @@ static inline void invalidate_edi (struct elf_dyn_info *edi)
 #endif
 }
 
+/* Does EDI hold unwind tables covering IP?  */
+static inline int edi_covers (const struct elf_dyn_info *edi, unw_word_t ip)
+{
+  return (edi->di_cache.format != -1
+          && ip >= edi->di_cache.start_ip && ip < edi->di_cache.end_ip)
+#if UNW_TARGET_ARM
+      || (edi->di_arm.format != -1
+          && ip >= edi->di_arm.start_ip && ip < edi->di_arm.end_ip)
+#endif
+      || (edi->di_debug.format != -1
+          && ip >= edi->di_debug.start_ip && ip < edi->di_debug.end_ip);
+}
+
+static inline int edi_is_valid (const struct elf_dyn_info *edi)
+{
+  return edi->di_cache.format != -1
+#if UNW_TARGET_ARM
+      || edi->di_arm.format != -1
+#endif
+      || edi->di_debug.format != -1;
+}
+
+/* The unwind tables of recently used objects other than the current
+   one, most recently used first, so that remote address spaces need not
+   map and parse an object again each time the IP moves to another one.  */
+#define EDI_CACHE_SIZE  16
+
+struct elf_dyn_info_cache
+  {
+    unsigned int count;
+    struct elf_dyn_info edi[EDI_CACHE_SIZE];
+  };
+
+/* Release EDI.  OWNS_IMAGE tells whether EDI->ei was mapped for it.  */
+static inline void release_edi (struct elf_dyn_info *edi, int owns_image)
+{
+  if (!owns_image)
+    edi->ei.image = NULL;
+  invalidate_edi (edi);
+}
+
+/* Make the cached tables covering IP current, keeping the current ones
+   in the cache.  Returns 1 if found, 0 otherwise.  */
+static inline int edi_cache_lookup (struct elf_dyn_info_cache *cache,
+                                    struct elf_dyn_info *edi, unw_word_t ip,
+                                    int owns_image)
+{
+  struct elf_dyn_info found;
+  unsigned int i;
+
+  for (i = 0; i < cache->count; ++i)
+    if (edi_covers (&cache->edi[i], ip))
+      break;
+  if (i == cache->count)
+    return 0;
+
+  found = cache->edi[i];
+#if UNW_TARGET_IA64
+  found.ktab = edi->ktab;       /* the kernel table stays current */
+#endif
+  if (edi_is_valid (edi))
+    {
+      memmove (&cache->edi[1], &cache->edi[0], i * sizeof (cache->edi[0]));
+      cache->edi[0] = *edi;
+    }
+  else
+    {
+      release_edi (edi, owns_image);
+      memmove (&cache->edi[i], &cache->edi[i + 1],
+               (cache->count - i - 1) * sizeof (cache->edi[0]));
+      --cache->count;
+    }
+  *edi = found;
+  return 1;
+}
+
+/* Move the current tables into the cache, evicting the least recently
+   used ones if it is full, and leave *EDI empty.  */
+static inline void edi_cache_save (struct elf_dyn_info_cache *cache,
+                                   struct elf_dyn_info *edi, int owns_image)
+{
+  if (!edi_is_valid (edi))
+    {
+      release_edi (edi, owns_image);
+      return;
+    }
+  if (cache->count == EDI_CACHE_SIZE)
+    release_edi (&cache->edi[--cache->count], owns_image);
+  memmove (&cache->edi[1], &cache->edi[0],
+           cache->count * sizeof (cache->edi[0]));
+  cache->edi[0] = *edi;
+  ++cache->count;
+
+  /* The image now belongs to the cached copy.  */
+  edi->ei.image = NULL;
+  invalidate_edi (edi);
+#if UNW_TARGET_IA64
+  edi->ktab = cache->edi[0].ktab;
+#endif
+}
+
+static inline void edi_cache_flush (struct elf_dyn_info_cache *cache,
+                                    int owns_image)
+{
+  while (cache->count > 0)
+    release_edi (&cache->edi[--cache->count], owns_image);
+}
+
 
 /* Provide a place holder for architecture to override for fast access
    to memory when known not to need to validate and know the access
@@ -438,4 +592,21 @@ static inline void invalidate_edi (struct elf_dyn_info *edi)
 
 #define UNW_ALIGN(x,a) (((size_t)(x) + (size_t)(a) - 1) & ~((size_t)(a) - 1))
 
+/* Count one STAT event in AS.  Async-signal-safe.  */
+static inline void
+unwi_stats_inc (unw_addr_space_t as, enum unwi_stat stat)
+{
+#ifdef CONFIG_STATS
+  char probe;
+  size_t stripe = ((uintptr_t) &probe >> UNWI_STATS_STACK_SHIFT)
+                  % UNWI_STATS_STRIPES;
+
+  atomic_fetch_add_explicit (&as->stats.stripe[stripe].count[stat], 1,
+                             memory_order_relaxed);
+#else
+  (void) as;
+  (void) stat;
+#endif
+}
+
 #endif /* libunwind_i_h */
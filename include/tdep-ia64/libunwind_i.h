@@ -102,6 +102,7 @@ struct unw_addr_space
 #endif
     unw_caching_policy_t caching_policy;
     _Atomic uint32_t cache_generation;
+    _Atomic uint32_t init_generation;   /* bumped by unw_init_remote() */
     unw_word_t dyn_generation;
     unw_word_t dyn_info_list_addr;      /* (cached) dyn_info_list_addr */
 #ifndef UNW_REMOTE_ONLY
@@ -109,6 +110,10 @@ struct unw_addr_space
 #endif
 
     struct ia64_script_cache global_cache;
+    _Atomic (struct unw_symbol_table *) symbol_tables; /* (cached) symbol indexes */
+    _Atomic unsigned long symbol_table_readers; /* lookups in symbol_tables */
+    struct unw_symbol_table *retired_symbol_tables; /* flushed, not yet freed */
+    struct unwi_stats stats;          /* see unw_get_stats() */
    };
 
 /* Note: The ABI numbers in the ABI-markers (.unwabi directive) are
@@ -57,11 +57,20 @@ struct unw_addr_space
 #endif
   unw_caching_policy_t caching_policy;
   _Atomic uint32_t cache_generation;
+  _Atomic uint32_t init_generation;   /* bumped by unw_init_remote() */
   unw_word_t dyn_generation;    /* see dyn-common.h */
   unw_word_t dyn_info_list_addr;        /* (cached) dyn_info_list_addr */
   struct dwarf_rs_cache global_cache;
+  struct dwarf_cie_cache cie_cache;   /* (cached) parsed CIEs */
   struct unw_debug_frame_list *debug_frames;
+  _Atomic (struct unw_symbol_table *) symbol_tables; /* (cached) symbol indexes */
+  _Atomic unsigned long symbol_table_readers; /* lookups in symbol_tables */
+  struct unw_symbol_table *retired_symbol_tables; /* flushed, not yet freed */
+  _Atomic (struct dwarf_compact_table *) compact_tables; /* (cached) compact unwind tables */
+  _Atomic unsigned long compact_table_readers; /* lookups in compact_tables */
+  struct dwarf_compact_table *retired_compact_tables; /* flushed, not yet freed */
   int validate;
+  struct unwi_stats stats;          /* see unw_get_stats() */
 };
 
 struct MAY_ALIAS cursor
@@ -47,9 +47,23 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include "mempool.h"
 #include "dwarf.h"
 
+typedef enum
+  {
+    UNW_RISCV_FRAME_STANDARD = -2,     /* regular fp, sp +/- offset */
+    UNW_RISCV_FRAME_SIGRETURN = -1,    /* special sigreturn frame */
+    UNW_RISCV_FRAME_OTHER = 0          /* not cacheable (special or unrecognised) */
+  }
+unw_tdep_frame_type_t;
+
 typedef struct
   {
-    /* no riscv-specific fast trace */
+    uint64_t virtual_address;
+    int64_t frame_type     : 2;  /* unw_tdep_frame_type_t classification */
+    int64_t last_frame     : 1;  /* non-zero if last frame in chain */
+    int64_t cfa_reg_sp     : 1;  /* cfa dwarf base register is sp vs. fp */
+    int64_t cfa_reg_offset : 30; /* cfa is at this offset from base register value */
+    int64_t fp_cfa_offset  : 30; /* fp saved at this offset from cfa (-1 = not saved) */
+    int64_t ra_cfa_offset  : 30; /* ra saved at this offset from cfa (-1 = not saved) */
   }
 unw_tdep_frame_t;
 
@@ -65,10 +79,19 @@ struct unw_addr_space
 #endif
     unw_caching_policy_t caching_policy;
     _Atomic uint32_t cache_generation;
+    _Atomic uint32_t init_generation;   /* bumped by unw_init_remote() */
     unw_word_t dyn_generation;          /* see dyn-common.h */
     unw_word_t dyn_info_list_addr;      /* (cached) dyn_info_list_addr */
     struct dwarf_rs_cache global_cache;
+    struct dwarf_cie_cache cie_cache;   /* (cached) parsed CIEs */
     struct unw_debug_frame_list *debug_frames;
+    _Atomic (struct unw_symbol_table *) symbol_tables; /* (cached) symbol indexes */
+    _Atomic unsigned long symbol_table_readers; /* lookups in symbol_tables */
+    struct unw_symbol_table *retired_symbol_tables; /* flushed, not yet freed */
+    _Atomic (struct dwarf_compact_table *) compact_tables; /* (cached) compact unwind tables */
+    _Atomic unsigned long compact_table_readers; /* lookups in compact_tables */
+    struct dwarf_compact_table *retired_compact_tables; /* flushed, not yet freed */
+    struct unwi_stats stats;          /* see unw_get_stats() */
 };
 
 #define tdep_big_endian(as)             ((as)->big_endian)
@@ -76,6 +99,9 @@ struct unw_addr_space
 struct MAY_ALIAS cursor
   {
     struct dwarf_cursor dwarf;          /* must be first */
+
+    unw_tdep_frame_t frame_info;        /* quick tracing assist info */
+
     enum
       {
         RISCV_SCF_NONE, // 0
@@ -284,8 +310,8 @@ dwarf_put (struct dwarf_cursor *c, dwarf_loc_t loc, unw_word_t val)
 #define tdep_fetch_frame(c,ip,n)        do {} while(0)
 #define tdep_cache_frame(c)             0
 #define tdep_reuse_frame(c,frame)       do {} while(0)
-#define tdep_stash_frame(c,rs)          do {} while(0)
-#define tdep_trace(cur,addr,n)          (-UNW_ENOINFO)
+#define tdep_stash_frame                UNW_OBJ(tdep_stash_frame)
+#define tdep_trace                      UNW_OBJ(tdep_trace)
 
 #ifdef UNW_LOCAL_ONLY
 # define tdep_find_proc_info(c,ip,n)                            \
@@ -321,5 +347,8 @@ extern int tdep_access_reg (struct cursor *c, unw_regnum_t reg,
                             unw_word_t *valp, int write);
 extern int tdep_access_fpreg (struct cursor *c, unw_regnum_t reg,
                               unw_fpreg_t *valp, int write);
+extern int tdep_trace (unw_cursor_t *cursor, void **addresses, int *n);
+extern void tdep_stash_frame (struct dwarf_cursor *c,
+                              struct dwarf_reg_state *rs);
 
 #endif /* RISCV_LIBUNWIND_I_H */
@@ -39,6 +39,26 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include "mempool.h"
 #include "dwarf.h"
 
+typedef enum
+  {
+    UNW_S390X_FRAME_STANDARD = -2,      /* regular r11, r15 +/- offset */
+    UNW_S390X_FRAME_SIGRETURN = -1,     /* special rt_sigreturn frame */
+    UNW_S390X_FRAME_OTHER = 0           /* not cacheable (special or unrecognised) */
+  }
+unw_tdep_frame_type_t;
+
+typedef struct
+  {
+    uint64_t virtual_address;
+    int64_t frame_type     : 2;  /* unw_tdep_frame_type_t classification */
+    int64_t last_frame     : 1;  /* non-zero if last frame in chain */
+    int64_t cfa_reg_sp     : 1;  /* cfa dwarf base register is r15 vs. r11 */
+    int64_t cfa_reg_offset : 30; /* cfa is at this offset from base register value */
+    int64_t fp_cfa_offset  : 30; /* r11 saved at this offset from cfa (-1 = not saved) */
+    int64_t ra_cfa_offset  : 30; /* r14 saved at this offset from cfa (-1 = not saved) */
+  }
+unw_tdep_frame_t;
+
 struct unw_addr_space
   {
     struct unw_accessors acc;
@@ -47,16 +67,27 @@ struct unw_addr_space
 #endif
     unw_caching_policy_t caching_policy;
     _Atomic uint32_t cache_generation;
+    _Atomic uint32_t init_generation;   /* bumped by unw_init_remote() */
     unw_word_t dyn_generation;          /* see dyn-common.h */
     unw_word_t dyn_info_list_addr;      /* (cached) dyn_info_list_addr */
     struct dwarf_rs_cache global_cache;
+    struct dwarf_cie_cache cie_cache;   /* (cached) parsed CIEs */
     struct unw_debug_frame_list *debug_frames;
+    _Atomic (struct unw_symbol_table *) symbol_tables; /* (cached) symbol indexes */
+    _Atomic unsigned long symbol_table_readers; /* lookups in symbol_tables */
+    struct unw_symbol_table *retired_symbol_tables; /* flushed, not yet freed */
+    _Atomic (struct dwarf_compact_table *) compact_tables; /* (cached) compact unwind tables */
+    _Atomic unsigned long compact_table_readers; /* lookups in compact_tables */
+    struct dwarf_compact_table *retired_compact_tables; /* flushed, not yet freed */
+    struct unwi_stats stats;          /* see unw_get_stats() */
    };
 
 struct MAY_ALIAS cursor
   {
     struct dwarf_cursor dwarf;          /* must be first */
 
+    unw_tdep_frame_t frame_info;        /* quick tracing assist info */
+
     /* Format of sigcontext structure and address at which it is
        stored: */
     enum
@@ -218,8 +249,8 @@ dwarf_put (struct dwarf_cursor *c, dwarf_loc_t loc, unw_word_t val)
 #define tdep_fetch_frame(c,ip,n)        do {} while(0)
 #define tdep_cache_frame(c)             0
 #define tdep_reuse_frame(c,rs)          do {} while(0)
-#define tdep_stash_frame(cs,rs)         do {} while(0)
-#define tdep_trace(cur,addr,n)          (-UNW_ENOINFO)
+#define tdep_stash_frame                UNW_OBJ(tdep_stash_frame)
+#define tdep_trace                      UNW_OBJ(tdep_trace)
 #define tdep_uc_addr                    UNW_OBJ(uc_addr)
 
 #ifdef UNW_LOCAL_ONLY
@@ -257,5 +288,8 @@ extern int tdep_access_reg (struct cursor *c, unw_regnum_t reg,
                             unw_word_t *valp, int write);
 extern int tdep_access_fpreg (struct cursor *c, unw_regnum_t reg,
                               unw_fpreg_t *valp, int write);
+extern int tdep_trace (unw_cursor_t *cursor, void **addresses, int *n);
+extern void tdep_stash_frame (struct dwarf_cursor *c,
+                              struct dwarf_reg_state *rs);
 
 #endif /* S390X_LIBUNWIND_I_H */
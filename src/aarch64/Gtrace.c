@@ -25,6 +25,7 @@ OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 
 #include "unwind_i.h"
+#include "trace_shared.h"
 #include "ucontext_i.h"
 #include <signal.h>
 #include <limits.h>
@@ -42,6 +43,7 @@ typedef struct
   unw_tdep_frame_t *frames;
   size_t log_size;
   size_t used;
+  uint32_t generation;  /* cache generation the frames belong to */
   size_t dtor_count;  /* Counts how many times our destructor has already
                          been called. */
 } unw_trace_cache_t;
@@ -105,6 +107,11 @@ static unw_trace_cache_t *
 trace_cache_create (void)
 {
   unw_trace_cache_t *cache;
+  size_t log_size = HASH_MIN_BITS;
+
+  /* In front of the shared cache only a small table is needed. */
+  if (trace_cache_get_mode () & TRACE_CACHE_SHARED)
+    log_size = TRACE_L1_BITS;
 
   if (tls_cache_destroyed)
   {
@@ -121,28 +128,44 @@ trace_cache_create (void)
     return NULL;
   }
 
-  if (! (cache->frames = trace_cache_buckets(1ULL << HASH_MIN_BITS)))
+  if (! (cache->frames = trace_cache_buckets(1ULL << log_size)))
   {
     Debug(5, "failed to allocate buckets\n");
     mempool_free(&trace_cache_pool, cache);
     return NULL;
   }
 
-  cache->log_size = HASH_MIN_BITS;
+  cache->log_size = log_size;
   cache->used = 0;
+  cache->generation = trace_cache_generation ();
   cache->dtor_count = 0;
   tls_cache_destroyed = 0;  /* Paranoia: should already be 0. */
   Debug(5, "allocated cache %p\n", cache);
   return cache;
 }
 
+/* Empty the hash table in the frame cache, keeping its size.  */
+static void
+trace_cache_reset (unw_trace_cache_t *cache)
+{
+  size_t i, size = (1ULL << cache->log_size);
+
+  for (i = 0; i < size; ++i)
+    cache->frames[i] = empty_frame;
+  cache->used = 0;
+  cache->generation = trace_cache_generation ();
+}
+
 /* Expand the hash table in the frame cache if possible. This always
-   quadruples the hash size, and clears all previous frame entries. */
+   quadruples the hash size, and clears all previous frame entries.
+   A table in front of the shared cache is only cleared. */
 static int
 trace_cache_expand (unw_trace_cache_t *cache)
 {
   size_t old_size = (1ULL << cache->log_size);
-  size_t new_log_size = cache->log_size + 2;
+  size_t new_log_size = cache->log_size;
+  if (! (trace_cache_get_mode () & TRACE_CACHE_SHARED))
+    new_log_size += 2;
   unw_tdep_frame_t *new_frames = trace_cache_buckets (1ULL << new_log_size);
 
   if (unlikely(! new_frames))
@@ -156,6 +179,7 @@ trace_cache_expand (unw_trace_cache_t *cache)
   cache->frames = new_frames;
   cache->log_size = new_log_size;
   cache->used = 0;
+  unwi_stats_inc (unw_local_addr_space, UNWI_STAT_TRACE_CACHE_EXPAND);
   return 0;
 }
 
@@ -347,7 +371,7 @@ trace_lookup (unw_cursor_t *cursor,
   if (! addr)
     ++cache->used;
 
-  return trace_init_addr (frame, cursor, cfa, pc, fp, sp);
+  return trace_cache_fill (frame, cursor, cfa, pc, fp, sp);
 }
 
 /* Fast stack backtrace for AArch64.
@@ -357,8 +381,9 @@ trace_lookup (unw_cursor_t *cursor,
    BUFFER with the call tree from CURSOR upwards for at most SIZE
    stack levels. The first frame, backtrace itself, is omitted. When
    called, SIZE should give the maximum number of entries that can be
-   stored into BUFFER. Uses an internal thread-specific cache to
-   accelerate queries.
+   stored into BUFFER. Uses an internal thread-specific cache, a
+   process-wide one or both (see UNW_TRACE_CACHE in trace_shared.h)
+   to accelerate queries.
 
    The caller should fall back to a unw_step() loop if this function
    fails by returning -UNW_ESTOPUNWIND, meaning the routine hit a
@@ -418,7 +443,8 @@ tdep_trace (unw_cursor_t *cursor, void **buffer, int *size)
 {
   struct cursor *c = (struct cursor *) cursor;
   struct dwarf_cursor *d = &c->dwarf;
-  unw_trace_cache_t *cache;
+  unw_trace_cache_t *cache = NULL;
+  unw_tdep_frame_t scratch;
   unw_word_t fp, sp, pc, cfa, lr = 0;
   int maxdepth = 0;
   int depth = 0;
@@ -440,8 +466,9 @@ tdep_trace (unw_cursor_t *cursor, void **buffer, int *size)
   ACCESS_MEM_FAST(ret, 0, d, DWARF_GET_LOC(d->loc[UNW_AARCH64_X29]), fp);
   assert(ret == 0);
 
-  /* Get frame cache. */
-  if (unlikely(! (cache = trace_cache_get())))
+  /* Get frame cache, unless only the shared cache is used. */
+  int mode = trace_cache_get_mode ();
+  if ((mode & TRACE_CACHE_THREAD) && unlikely(! (cache = trace_cache_get())))
   {
     Debug (1, "returning %d, cannot get trace cache\n", -UNW_ENOMEM);
     *size = 0;
@@ -449,6 +476,10 @@ tdep_trace (unw_cursor_t *cursor, void **buffer, int *size)
     return -UNW_ENOMEM;
   }
 
+  /* Forget frames classified before the last unw_flush_cache().  */
+  if (cache && unlikely (cache->generation != trace_cache_generation ()))
+    trace_cache_reset (cache);
+
   /* Trace the stack upwards, starting from current RIP.  Adjust
      the RIP address for previous/next instruction as the main
      unwinding logic would also do.  We undo this before calling
@@ -464,7 +495,9 @@ tdep_trace (unw_cursor_t *cursor, void **buffer, int *size)
        decide this frame cannot be handled in fast trace mode.  We
        cache negative results too to prevent unnecessary dwarf parsing
        for common failures. */
-    unw_tdep_frame_t *f = trace_lookup (cursor, cache, cfa, pc, fp, sp);
+    unw_tdep_frame_t *f = (mode & TRACE_CACHE_THREAD)
+      ? trace_lookup (cursor, cache, cfa, pc, fp, sp)
+      : trace_shared_lookup (cursor, &scratch, cfa, pc, fp, sp);
 
     /* If we don't have information for this frame, give up. */
     if (unlikely(! f))
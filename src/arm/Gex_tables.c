@@ -578,6 +578,7 @@ arm_find_proc_info2 (unw_addr_space_t as, unw_word_t ip,
       cb_data.di.format = -1;
       intrmask_t saved_mask2;
       SIGPROCMASK (SIG_SETMASK, &unwi_full_mask, &saved_mask2);
+      unwi_stats_inc (as, UNWI_STAT_PHDR_WALK);
       as->iterate_phdr_function (arm_phdr_cb, &cb_data);
       SIGPROCMASK (SIG_SETMASK, &saved_mask2, NULL);
       if (cb_data.di.format != -1)
@@ -605,6 +606,7 @@ arm_find_proc_info2 (unw_addr_space_t as, unw_word_t ip,
       cb_data.di.format = -1;
 
       SIGPROCMASK (SIG_SETMASK, &unwi_full_mask, &saved_mask);
+      unwi_stats_inc (as, UNWI_STAT_PHDR_WALK);
       ret = as->iterate_phdr_function (arm_phdr_cb, &cb_data);
       SIGPROCMASK (SIG_SETMASK, &saved_mask, NULL);
 
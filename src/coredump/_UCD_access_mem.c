@@ -24,6 +24,77 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include "_UCD_internal.h"
 #include "ucd_file_table.h"
 
+static void
+map_segment (struct UCD_info *ui, coredump_phdr_t *phdr)
+{
+  uoff_t delta, size;
+  uint8_t *base;
+
+  /* Truncated corefiles are common: never map beyond the end of the
+     file, or a read from the mapping would raise SIGBUS.  */
+  if (phdr->p_offset >= (uoff_t) ui->coredump_size)
+    return;
+  size = phdr->p_filesz;
+  if (size > (uoff_t) ui->coredump_size - phdr->p_offset)
+    size = (uoff_t) ui->coredump_size - phdr->p_offset;
+  if (size == 0)
+    return;
+
+  delta = phdr->p_offset & (unw_page_size - 1);
+  if (size + delta > SIZE_MAX)
+    return;
+  base = mi_mmap (NULL, size + delta, PROT_READ, MAP_PRIVATE,
+                  ui->coredump_fd, phdr->p_offset - delta);
+  if (base == MAP_FAILED)
+    {
+      Debug (0, "error %d in mmap(\"%s\", %lld): %s\n",
+             errno, ui->coredump_filename, (long long) phdr->p_offset,
+             strerror (errno));
+      return;
+    }
+
+  /* A stack walk touches a few words here and there.  */
+  madvise (base, size + delta, MADV_RANDOM);
+
+  phdr->p_image = base + delta;
+  phdr->p_image_size = size;
+}
+
+/* Map the part of the corefile that holds PHDR's contents, the first
+   time it is needed.  Returns NULL if the segment has no contents in
+   the corefile or cannot be mapped, in which case it is read with
+   pread(2) instead.  The segments are shared by all handles of the
+   core, so only the first attempt takes the lock.  */
+uint8_t *
+_UCD_map_segment (struct UCD_info *ui, coredump_phdr_t *phdr)
+{
+  if (!atomic_load (&phdr->p_image_tried))
+    {
+      mutex_lock (&ui->core->lock);
+      if (!phdr->p_image_tried)
+        {
+          map_segment (ui, phdr);
+          atomic_store (&phdr->p_image_tried, 1);
+        }
+      mutex_unlock (&ui->core->lock);
+    }
+  return phdr->p_image;
+}
+
+void
+_UCD_unmap_segment (coredump_phdr_t *phdr)
+{
+  size_t delta;
+
+  if (!phdr->p_image)
+    return;
+
+  delta = phdr->p_offset & (unw_page_size - 1);
+  mi_munmap (phdr->p_image - delta, phdr->p_image_size + delta);
+  phdr->p_image = NULL;
+  phdr->p_image_size = 0;
+}
+
 int
 _UCD_access_mem (unw_addr_space_t  as UNUSED,
                  unw_word_t        addr,
@@ -41,12 +112,10 @@ _UCD_access_mem (unw_addr_space_t  as UNUSED,
 
   unw_word_t addr_last = addr + sizeof (*val) - 1;
 
-  unsigned i;
+  coredump_phdr_t *phdr = _UCD_find_phdr (ui, addr);
 
-  for (i = 0; i < ui->phdrs_count; i++)
+  if (phdr && addr_last - phdr->p_vaddr < phdr->p_memsz)
     {
-      coredump_phdr_t *phdr = &ui->phdrs[i];
-
       /* First check the (in-memory) backup file image. */
       if (phdr->p_backing_file_index != ucd_file_no_index)
         {
@@ -54,14 +123,14 @@ _UCD_access_mem (unw_addr_space_t  as UNUSED,
 
           if (ucd_file == NULL)
             {
-              Debug (0, "invalid backing file index for phdr[%d]\n", i);
+              Debug (0, "invalid backing file index for phdr[%d]\n",
+                     (int) (phdr - ui->phdrs));
               return -UNW_EINVAL;
             }
 
           off_t image_offset = phdr->p_mapoff + (addr - phdr->p_vaddr);
 
-          if (phdr->p_vaddr <= addr && addr_last < phdr->p_vaddr + phdr->p_memsz
-              && (uintptr_t) image_offset + sizeof (*val) <= ucd_file->size)
+          if ((uintptr_t) image_offset + sizeof (*val) <= ucd_file->size)
             {
               memcpy (val, ucd_file->image + image_offset, sizeof (*val));
               Debug (16, "%#010llx <- [addr:%#010llx file:%s]\n",
@@ -73,24 +142,12 @@ _UCD_access_mem (unw_addr_space_t  as UNUSED,
         }
 
       /* Next, check the on-disk corefile. */
-      if (phdr->p_vaddr <= addr && addr_last < phdr->p_vaddr + phdr->p_memsz)
-        {
-          off_t fileofs = phdr->p_offset + (addr - phdr->p_vaddr);
-
-          if (lseek (ui->coredump_fd, fileofs, SEEK_SET) != fileofs)
-            {
-              Debug (0, "error %d in lseek(\"%s\", %lld): %s\n",
-                     errno,  ui->coredump_filename, (long long)fileofs, strerror (errno));
-              return -UNW_EINVAL;
-            }
-
-          if (read (ui->coredump_fd, val, sizeof (*val)) != sizeof (*val))
-            {
-              Debug (0, "error %d in read(\"%s\", %lld): %s\n",
-                     errno,  ui->coredump_filename, (long long)sizeof (*val), strerror (errno));
-              return -UNW_EINVAL;
-            }
+      off_t fileofs = phdr->p_offset + (addr - phdr->p_vaddr);
+      uint8_t *image = _UCD_map_segment (ui, phdr);
 
+      if (image && addr_last - phdr->p_vaddr < phdr->p_image_size)
+        {
+          memcpy (val, image + (addr - phdr->p_vaddr), sizeof (*val));
           Debug (16, "0x%llx <- [addr:0x%llx fileofs:0x%llx file:%s]\n",
                  (unsigned long long) (*val),
                  (unsigned long long)addr,
@@ -98,6 +155,22 @@ _UCD_access_mem (unw_addr_space_t  as UNUSED,
                  ui->coredump_filename);
           return UNW_ESUCCESS;
         }
+
+      /* pread() leaves the file offset alone, which other handles of
+         the core may be using at the same time.  */
+      if (pread (ui->coredump_fd, val, sizeof (*val), fileofs) != sizeof (*val))
+        {
+          Debug (0, "error %d in pread(\"%s\", %lld): %s\n",
+                 errno,  ui->coredump_filename, (long long)fileofs, strerror (errno));
+          return -UNW_EINVAL;
+        }
+
+      Debug (16, "0x%llx <- [addr:0x%llx fileofs:0x%llx file:%s]\n",
+             (unsigned long long) (*val),
+             (unsigned long long)addr,
+             (unsigned long long)fileofs,
+             ui->coredump_filename);
+      return UNW_ESUCCESS;
     }
 
   Debug (0, "addr %#010llx is unmapped\n", (unsigned long long)addr);
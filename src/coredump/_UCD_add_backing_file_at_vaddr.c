@@ -46,22 +46,20 @@ _UCD_add_backing_file_at_vaddr(struct UCD_info *ui,
                                unsigned long    vaddr,
                                const char      *path)
 {
-  for (unsigned p = 0; p < ui->phdrs_count; ++p)
+  coredump_phdr_t *phdr = _UCD_find_phdr (ui, vaddr);
+  if (phdr && phdr->p_type == PT_LOAD)
     {
-      coredump_phdr_t *phdr = &ui->phdrs[p];
-      if (phdr->p_type == PT_LOAD
-          && (uoff_t)vaddr >= phdr->p_vaddr
-          && (uoff_t)vaddr <  phdr->p_vaddr + phdr->p_memsz)
-        {
-          /* Skip phdrs already populated by NT_FILE. */
-          if (phdr->p_backing_file_index != ucd_file_no_index)
-            return UNW_ESUCCESS;
-          ucd_file_index_t idx = ucd_file_table_insert (&ui->ucd_file_table, path);
-          if (idx == ucd_file_no_index)
-            return -UNW_ENOMEM;
-          phdr->p_backing_file_index = idx;
-          return UNW_ESUCCESS;
-        }
+      /* Skip phdrs already populated by NT_FILE. */
+      if (phdr->p_backing_file_index != ucd_file_no_index)
+        return UNW_ESUCCESS;
+      mutex_lock (&ui->core->lock);
+      ucd_file_index_t idx = ucd_file_table_insert (&ui->core->ucd_file_table,
+                                                    path);
+      mutex_unlock (&ui->core->lock);
+      if (idx == ucd_file_no_index)
+        return -UNW_ENOMEM;
+      phdr->p_backing_file_index = idx;
+      return UNW_ESUCCESS;
     }
   return -UNW_ENOINFO;
 }
@@ -37,10 +37,27 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 # include <sys/elf.h>
 #endif
 #include <sys/procfs.h> /* struct elf_prstatus */
+#include <sys/stat.h>
 
 #include "_UCD_internal.h"
 
 
+/* Set up the members every handle of CORE has for itself.  */
+static void
+init_handle(struct UCD_info *ui, struct UCD_info *core)
+{
+  ui->core = core;
+  ui->edi.di_cache.format = -1;
+  ui->edi.di_debug.format = -1;
+#if UNW_TARGET_ARM
+  ui->edi.di_arm.format = -1;
+#endif
+#if UNW_TARGET_IA64
+  ui->edi.ktab.format = -1;
+#endif
+}
+
+
 struct UCD_info *
 _UCD_create(const char *filename)
 {
@@ -56,17 +73,18 @@ _UCD_create(const char *filename)
   mi_init ();
 
   struct UCD_info *ui = memset(malloc(sizeof(*ui)), 0, sizeof(*ui));
-  ui->edi.di_cache.format = -1;
-  ui->edi.di_debug.format = -1;
-#if UNW_TARGET_IA64
-  ui->edi.ktab.format = -1;
-#endif
+  init_handle(ui, ui);
+  mutex_init(&ui->lock);
 
   int fd = ui->coredump_fd = open(filename, O_RDONLY);
   if (fd < 0)
     goto err;
   ui->coredump_filename = strdup(filename);
 
+  struct stat st;
+  if (fstat(fd, &st) == 0)
+    ui->coredump_size = st.st_size;
+
   /* No sane ELF32 file is going to be smaller then ELF64 _header_,
    * so let's just read 64-bit sized one.
    */
@@ -174,7 +192,11 @@ _UCD_create(const char *filename)
         }
     }
 
-    int ret = _UCD_get_threadinfo(ui, phdrs, size);
+    int ret = _UCD_index_phdrs(ui);
+    if (ret != UNW_ESUCCESS)
+      goto err;
+
+    ret = _UCD_get_threadinfo(ui, phdrs, size);
     if (ret != UNW_ESUCCESS) {
 		Debug(0, "failure retrieving thread info from core file\n");
 		goto err;
@@ -242,6 +264,58 @@ void _UCD_select_thread(struct UCD_info *ui, int n)
   }
 }
 
+/**
+ * Make a handle for unwinding thread @n of the core behind @ui.
+ *
+ * The new handle shares the corefile, its segments, backing files and
+ * unwind tables with @ui, but has its own current thread and cache of
+ * recently used tables, so it can be used by one thread while other
+ * handles of the same core are used by others.  It must be destroyed
+ * with _UCD_destroy() before @ui is.  Backing files must be added to
+ * @ui before the first handle is made.
+ *
+ * @param[in] ui  UCD info created by _UCD_create()
+ * @param[in] n   index of the thread, as for _UCD_select_thread()
+ * @return the new handle, or NULL if @n is out of range or out of memory
+ */
+struct UCD_info *_UCD_create_for_thread(struct UCD_info *ui, int n)
+{
+  struct UCD_info *tui;
+
+  if (n < 0 || n >= ui->n_threads)
+    return NULL;
+
+  tui = calloc(1, sizeof(*tui));
+  if (!tui)
+    {
+      Debug(0, "error %d from calloc(): %s\n", errno, strerror(errno));
+      return NULL;
+    }
+
+  struct UCD_info *core = ui->core;
+  init_handle(tui, core);
+
+  /* Only what never changes once the core is read is shared; the lock
+     keeps a backing file from being added halfway through the copy.  */
+  mutex_lock(&core->lock);
+  tui->big_endian = core->big_endian;
+  tui->coredump_fd = core->coredump_fd;
+  tui->coredump_size = core->coredump_size;
+  tui->coredump_filename = core->coredump_filename;
+  tui->phdrs = core->phdrs;
+  tui->phdrs_count = core->phdrs_count;
+  tui->sorted_phdrs = core->sorted_phdrs;
+  tui->sorted_phdrs_count = core->sorted_phdrs_count;
+  tui->cover_end = core->cover_end;
+  tui->ucd_file_table = core->ucd_file_table;
+  tui->n_threads = core->n_threads;
+  tui->threads = core->threads;
+  mutex_unlock(&core->lock);
+
+  _UCD_select_thread(tui, n);
+  return tui;
+}
+
 pid_t _UCD_get_pid(struct UCD_info *ui)
 {
 #if defined(HAVE_PROCFS_STATUS)
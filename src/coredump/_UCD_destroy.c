@@ -29,14 +29,31 @@ _UCD_destroy (struct UCD_info *ui)
   if (!ui)
     return;
 
+  /* A handle made by _UCD_create_for_thread() owns only its caches.  */
+  if (ui->core != ui)
+    {
+      release_edi (&ui->edi, 0);
+      edi_cache_flush (&ui->edi_cache, 0);
+      free (ui);
+      return;
+    }
+
   if (ui->coredump_fd >= 0)
     close(ui->coredump_fd);
   free(ui->coredump_filename);
 
   invalidate_edi (&ui->edi);
+  edi_cache_flush (&ui->edi_cache, 0);
 
   ucd_file_table_dispose(&ui->ucd_file_table);
 
+  for (unsigned i = 0; ui->phdrs && i < ui->phdrs_count; i++)
+    {
+      _UCD_unmap_segment(&ui->phdrs[i]);
+      free(ui->phdrs[i].p_edi);
+    }
+  free(ui->sorted_phdrs);
+  free(ui->cover_end);
   free(ui->phdrs);
   free(ui->note_phdr);
   free(ui->threads);
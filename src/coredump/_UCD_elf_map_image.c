@@ -59,11 +59,24 @@ CD_elf_map_image(struct UCD_info *ui, coredump_phdr_t *phdr)
       ucd_file_t *ucd_file = ucd_file_table_at(&ui->ucd_file_table, phdr->p_backing_file_index);
       if (ucd_file == NULL)
         return NULL;
-      /* addr, length, prot, flags, fd, fd_offset */
-      ei->image = ucd_file_map (ucd_file);
+      /* The backing files are shared by all handles of the core. */
+      ei->image = ucd_file->image;
+      if (ei->image == NULL)
+        {
+          mutex_lock(&ui->core->lock);
+          ei->image = ucd_file_map (ucd_file);
+          mutex_unlock(&ui->core->lock);
+        }
       if (ei->image == NULL)
         return NULL;
       ei->size = ucd_file->size;
+      if (!elf_w(valid_object)(ei))
+        {
+          ei->image = NULL;
+          ei->size = 0;
+          return NULL;
+        }
+      return phdr;
     }
 
   /* Check ELF header for sanity */
@@ -81,15 +94,8 @@ CD_elf_map_image(struct UCD_info *ui, coredump_phdr_t *phdr)
 HIDDEN coredump_phdr_t *
 _UCD_get_elf_image(struct UCD_info *ui, unw_word_t ip)
 {
-  unsigned i;
-  for (i = 0; i < ui->phdrs_count; i++)
-    {
-      coredump_phdr_t *phdr = &ui->phdrs[i];
-      if (phdr->p_vaddr <= ip && ip < phdr->p_vaddr + phdr->p_memsz)
-        {
-          phdr = CD_elf_map_image(ui, phdr);
-          return phdr;
-        }
-    }
-  return NULL;
+  coredump_phdr_t *phdr = _UCD_find_phdr(ui, ip);
+  if (phdr)
+    phdr = CD_elf_map_image(ui, phdr);
+  return phdr;
 }
@@ -0,0 +1,142 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_UCD_internal.h"
+
+static int
+compare_phdrs (const void *a, const void *b)
+{
+  const coredump_phdr_t *pa = *(coredump_phdr_t * const *) a;
+  const coredump_phdr_t *pb = *(coredump_phdr_t * const *) b;
+
+  if (pa->p_vaddr != pb->p_vaddr)
+    return pa->p_vaddr < pb->p_vaddr ? -1 : 1;
+  /* Keep the program header order for segments at the same address. */
+  return pa < pb ? -1 : pa > pb;
+}
+
+/**
+ * Build the address-sorted index of the segments in @ui->phdrs that
+ * _UCD_find_phdr() searches.
+ *
+ * @param[in] ui  UCD info whose program headers have been read
+ * @return UNW_ESUCCESS on success, -UNW_ENOMEM if out of memory
+ */
+int
+_UCD_index_phdrs (struct UCD_info *ui)
+{
+  unsigned i, n = 0;
+  uoff_t cover_end = 0;
+
+  ui->sorted_phdrs = calloc (ui->phdrs_count, sizeof (ui->sorted_phdrs[0]));
+  ui->cover_end = calloc (ui->phdrs_count, sizeof (ui->cover_end[0]));
+  if (ui->phdrs_count > 0 && (!ui->sorted_phdrs || !ui->cover_end))
+    return -UNW_ENOMEM;
+
+  for (i = 0; i < ui->phdrs_count; i++)
+    if (ui->phdrs[i].p_memsz > 0)
+      ui->sorted_phdrs[n++] = &ui->phdrs[i];
+
+  qsort (ui->sorted_phdrs, n, sizeof (ui->sorted_phdrs[0]), compare_phdrs);
+  ui->sorted_phdrs_count = n;
+
+  /* Segments may overlap or enclose one another, so a segment starting
+     below an address can cover it even when later ones do not.  */
+  for (i = 0; i < n; i++)
+    {
+      coredump_phdr_t *phdr = ui->sorted_phdrs[i];
+
+      if (phdr->p_vaddr + phdr->p_memsz > cover_end)
+        cover_end = phdr->p_vaddr + phdr->p_memsz;
+      ui->cover_end[i] = cover_end;
+    }
+  ui->last_phdr = NULL;
+  return UNW_ESUCCESS;
+}
+
+/* Tell whether sorted_phdrs[I] shares no address with another segment,
+   so that it is the answer for every address it covers.  */
+static int
+phdr_is_alone (struct UCD_info *ui, unsigned i)
+{
+  coredump_phdr_t *phdr = ui->sorted_phdrs[i];
+
+  if (i > 0 && ui->cover_end[i - 1] > phdr->p_vaddr)
+    return 0;
+  if (i + 1 < ui->sorted_phdrs_count
+      && ui->sorted_phdrs[i + 1]->p_vaddr - phdr->p_vaddr < phdr->p_memsz)
+    return 0;
+  return 1;
+}
+
+/**
+ * Find the segment that contains @addr.
+ *
+ * If several segments contain it, the one first in program header
+ * order is returned.  A stack walk reads mostly from the same few
+ * segments, so the segment found last is tried before searching the
+ * index, as long as no other segment overlaps it.
+ *
+ * @param[in] ui    UCD info created by _UCD_create()
+ * @param[in] addr  address in the crashed process
+ * @return the program header of the segment, or NULL if @addr is unmapped
+ */
+coredump_phdr_t *
+_UCD_find_phdr (struct UCD_info *ui, unw_word_t addr)
+{
+  coredump_phdr_t *phdr = ui->last_phdr, *found = NULL;
+  unsigned lo, hi, mid, i, at = 0;
+
+  if (phdr && phdr->p_vaddr <= addr && addr - phdr->p_vaddr < phdr->p_memsz)
+    return phdr;
+
+  /* Find the last segment starting at or below ADDR.  */
+  lo = 0;
+  hi = ui->sorted_phdrs_count;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (ui->sorted_phdrs[mid]->p_vaddr <= addr)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  /* Of it and the segments before it that still reach ADDR, take the
+     first in header order.  */
+  for (i = lo; i > 0 && ui->cover_end[i - 1] > addr; i--)
+    {
+      phdr = ui->sorted_phdrs[i - 1];
+      if (addr - phdr->p_vaddr < phdr->p_memsz && (!found || phdr < found))
+        {
+          found = phdr;
+          at = i - 1;
+        }
+    }
+  if (!found)
+    return NULL;
+
+  if (phdr_is_alone (ui, at))
+    ui->last_phdr = found;
+  return found;
+}
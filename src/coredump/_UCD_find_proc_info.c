@@ -29,10 +29,60 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 
 #include "_UCD_internal.h"
 
+/* Find the unwind tables of the object mapped at PHDR, once for all
+   handles of the core.  Returns NULL if it has none.  */
+static struct elf_dyn_info *
+get_shared_tables (struct UCD_info *ui, unw_addr_space_t as,
+                   coredump_phdr_t *phdr, unw_word_t ip)
+{
+  struct elf_dyn_info *edi;
+  int state;
+
+  if ((state = atomic_load (&phdr->p_edi_state)) != UCD_EDI_UNTRIED)
+    return state == UCD_EDI_OK ? phdr->p_edi : NULL;
+
+  mutex_lock (&ui->core->lock);
+  if (phdr->p_edi_state == UCD_EDI_UNTRIED)
+    {
+      state = UCD_EDI_FAILED;
+      ucd_file_t *ucd_file = ucd_file_table_at (&ui->ucd_file_table,
+                                                phdr->p_backing_file_index);
+      if (ucd_file == NULL || ucd_file->image == NULL)
+        Debug (0, "no backing file for index %d\n", phdr->p_backing_file_index);
+      else if ((edi = calloc (1, sizeof (*edi))) == NULL)
+        Debug (0, "error %d from calloc(): %s\n", errno, strerror (errno));
+      else
+        {
+          invalidate_edi (edi);
+          edi->ei.image = ucd_file->image;
+          edi->ei.size = ucd_file->size;
+
+          /* segbase: where it is mapped in virtual memory; mapoff: file
+             offset of this mapping (from NT_FILE), needed to correctly
+             compute load_base for PIE binaries */
+          if (tdep_find_unwind_table (edi, as, ucd_file->filename,
+                                      phdr->p_vaddr, phdr->p_mapoff, ip) < 0
+              || !edi_is_valid (edi))
+            {
+              Debug (1, "tdep_find_unwind_table failed\n");
+              free (edi);
+            }
+          else
+            {
+              phdr->p_edi = edi;
+              state = UCD_EDI_OK;
+            }
+        }
+      atomic_store (&phdr->p_edi_state, state);
+    }
+  mutex_unlock (&ui->core->lock);
+  return phdr->p_edi;
+}
+
 static int
 get_unwind_info(struct UCD_info *ui, unw_addr_space_t as, unw_word_t ip)
 {
-  unsigned long segbase, mapoff;
+  struct elf_dyn_info *edi;
 
 #if UNW_TARGET_IA64 && defined(__linux__)
   if (!ui->edi.ktab.start_ip && _Uia64_get_kernel_table (&ui->edi.ktab) < 0)
@@ -42,20 +92,13 @@ get_unwind_info(struct UCD_info *ui, unw_addr_space_t as, unw_word_t ip)
     return 0;
 #endif
 
-  if ((ui->edi.di_cache.format != -1
-       && ip >= ui->edi.di_cache.start_ip && ip < ui->edi.di_cache.end_ip)
-#if UNW_TARGET_ARM
-      || (ui->edi.di_debug.format != -1
-       && ip >= ui->edi.di_arm.start_ip && ip < ui->edi.di_arm.end_ip)
-#endif
-      || (ui->edi.di_debug.format != -1
-       && ip >= ui->edi.di_debug.start_ip && ip < ui->edi.di_debug.end_ip))
+  if (edi_covers (&ui->edi, ip)
+      || edi_cache_lookup (&ui->edi_cache, &ui->edi, ip, 0))
     return 0;
 
-  /* The invalidate_edi call unmaps memory it doesn't own, so just null it out
-     instead. */
-  ui->edi.ei.image = NULL;
-  invalidate_edi (&ui->edi);
+  /* The images belong to ucd_file_table, so the cache must not unmap
+     them. */
+  edi_cache_save (&ui->edi_cache, &ui->edi, 0);
 
   /* Used to be tdep_get_elf_image() in ptrace unwinding code */
   coredump_phdr_t *phdr = _UCD_get_elf_image(ui, ip);
@@ -65,26 +108,21 @@ get_unwind_info(struct UCD_info *ui, unw_addr_space_t as, unw_word_t ip)
       return -UNW_ENOINFO;
     }
 
-  ucd_file_t *ucd_file = ucd_file_table_at(&ui->ucd_file_table, phdr->p_backing_file_index);
-  if (ucd_file == NULL)
+  if (!(edi = get_shared_tables (ui, as, phdr, ip)))
     {
-      Debug(0, "no backing file for index %d\n", phdr->p_backing_file_index);
+      Debug(1, "returns error: no unwind tables\n");
       return -UNW_ENOINFO;
     }
 
-  /* segbase: where it is mapped in virtual memory */
-  segbase = phdr->p_vaddr;
-  /* mapoff: file offset of this mapping (from NT_FILE), needed to correctly
-   * compute load_base for PIE binaries */
-  mapoff  = phdr->p_mapoff;
-
-  /* Here, SEGBASE is the starting-address of the (mmap'ped) segment
-     which covers the IP we're looking for.  */
-  if (tdep_find_unwind_table(&ui->edi, as, ucd_file->filename, segbase, mapoff, ip) < 0)
-    {
-      Debug(1, "returns error: tdep_find_unwind_table failed\n");
-      return -UNW_ENOINFO;
-    }
+  /* Take a private copy, to be trimmed below and cached by this
+     handle.  */
+#if UNW_TARGET_IA64
+  struct elf_dyn_info found = *edi;
+  found.ktab = ui->edi.ktab;
+  ui->edi = found;
+#else
+  ui->edi = *edi;
+#endif
 
   /* This can happen in corner cases where dynamically generated
      code falls into the same page that contains the data-segment
@@ -105,25 +105,20 @@ _handle_nt_file_note (uint8_t *desc, void *arg)
 
       size_t len = strlen (strings);
 
-      for (unsigned p = 0; p < ui->phdrs_count; ++p)
+      coredump_phdr_t *phdr = _UCD_find_phdr (ui, entry.start);
+      if (phdr && phdr->p_type == PT_LOAD
+          && entry.end <= phdr->p_vaddr + phdr->p_memsz)
         {
-          if (ui->phdrs[p].p_type == PT_LOAD
-              && entry.start >= ui->phdrs[p].p_vaddr
-              && entry.end <= ui->phdrs[p].p_vaddr + ui->phdrs[p].p_memsz)
+          if (len > 0 && !_path_ends_with(strings, len, deleted, deleted_len))
             {
-              if (len > 0 && !_path_ends_with(strings, len, deleted, deleted_len))
-                {
-                  ui->phdrs[p].p_backing_file_index = ucd_file_table_insert (&ui->ucd_file_table, strings);
-                  /* NT_FILE offset is in pages; convert to bytes */
-                  ui->phdrs[p].p_mapoff = entry.offset * hdr.pagesz;
-                  Debug (3, "adding '%s' at index %d (mapoff=0x%lx)\n", strings, ui->phdrs[p].p_backing_file_index, (unsigned long)ui->phdrs[p].p_mapoff);
-                }
-              else
-                {
-                  Debug (3, "ignoring path: '%s', due to (deleted) or len == 0\n", strings);
-                }
-
-              break;
+              phdr->p_backing_file_index = ucd_file_table_insert (&ui->ucd_file_table, strings);
+              /* NT_FILE offset is in pages; convert to bytes */
+              phdr->p_mapoff = entry.offset * hdr.pagesz;
+              Debug (3, "adding '%s' at index %d (mapoff=0x%lx)\n", strings, phdr->p_backing_file_index, (unsigned long)phdr->p_mapoff);
+            }
+          else
+            {
+              Debug (3, "ignoring path: '%s', due to (deleted) or len == 0\n", strings);
             }
         }
 
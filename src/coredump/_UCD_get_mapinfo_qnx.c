@@ -70,28 +70,23 @@ _handle_nt_file_note (uint8_t *desc, void *arg)
   for (size_t i = 0; i < link_count; ++i)
   	{
 	  const struct qnx_link_map *map = &linkmap[i];
-      for (size_t p = 0; p < ui->phdrs_count; ++p)
-		{
-		  coredump_phdr_t *phdr = &ui->phdrs[p];
-		  if (phdr->p_type == PT_LOAD 
-		  	  && linkmap[i].l_addr >= phdr->p_vaddr
-		  	  && linkmap[i].l_addr < phdr->p_vaddr + phdr->p_memsz)
-		  	{
-		  	  char libpath[MAP_PATH_MAX];
-		  	  if ((0 == strncmp(strtab + linkmap[i].l_name, "PIE", 3))
-		  	      || (0 == strncmp(strtab + linkmap[i].l_name, "EXE", 3)))
-		  	    {
-		  	      snprintf (libpath, MAP_PATH_MAX, "%s", strtab + map->l_path);
-				}
-		  	  else
-		  	    {
-		  	      snprintf (libpath, MAP_PATH_MAX, "%s%s", strtab + map->l_path, strtab + map->l_name);
-				}
-		  	  phdr->p_backing_file_index = ucd_file_table_insert (&ui->ucd_file_table, libpath);
-		  	  Debug(2, "added '%s' at index %d for phdr %zu\n", libpath, phdr->p_backing_file_index, p);
-		  	  break;
-		  	}
-		}
+      coredump_phdr_t *phdr = _UCD_find_phdr (ui, linkmap[i].l_addr);
+      if (phdr && phdr->p_type == PT_LOAD)
+        {
+          char libpath[MAP_PATH_MAX];
+          if ((0 == strncmp(strtab + linkmap[i].l_name, "PIE", 3))
+              || (0 == strncmp(strtab + linkmap[i].l_name, "EXE", 3)))
+            {
+              snprintf (libpath, MAP_PATH_MAX, "%s", strtab + map->l_path);
+            }
+          else
+            {
+              snprintf (libpath, MAP_PATH_MAX, "%s%s", strtab + map->l_path, strtab + map->l_name);
+            }
+          phdr->p_backing_file_index = ucd_file_table_insert (&ui->ucd_file_table, libpath);
+          Debug(2, "added '%s' at index %d for phdr %zu\n", libpath, phdr->p_backing_file_index,
+                (size_t) (phdr - ui->phdrs));
+        }
 	}
 
   return UNW_ESUCCESS;
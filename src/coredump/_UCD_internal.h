@@ -38,6 +38,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include <asm/ptrace.h> /* struct user_regs_struct on s390x */
 #endif
 #include <errno.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <limits.h>
 #include <stdio.h>
@@ -72,10 +73,19 @@ struct coredump_phdr
     uoff_t           p_align;
     ucd_file_index_t p_backing_file_index;
     uoff_t           p_mapoff;   /* file offset of this mapping (from NT_FILE) */
+    uint8_t         *p_image;    /* corefile contents of the segment, mmap'ed on demand */
+    size_t           p_image_size; /* bytes available at p_image */
+    _Atomic int      p_image_tried; /* bool: was mapping the segment attempted? */
+    _Atomic int      p_edi_state; /* UCD_EDI_* for p_edi */
+    struct elf_dyn_info *p_edi;  /* unwind tables of the object, found on demand */
   };
 
 typedef struct coredump_phdr coredump_phdr_t;
 
+#define UCD_EDI_UNTRIED 0
+#define UCD_EDI_OK      1
+#define UCD_EDI_FAILED  2
+
 #if defined(HAVE_STRUCT_ELF_PRSTATUS)
 typedef struct elf_prstatus UCD_proc_status_t;
 #elif defined(HAVE_STRUCT_PRSTATUS)
@@ -98,13 +108,27 @@ struct UCD_thread_info
 #endif
   };
 
+/* The corefile, its segments, backing files and the unwind tables
+   found in them are owned by the handle made by _UCD_create() and
+   shared with the handles made from it by _UCD_create_for_thread().
+   Whatever is mapped or found on demand is set up under the lock of
+   the owner and not changed afterwards, so handles of the same core
+   can be used by different threads at the same time.  The remaining
+   members belong to each handle.  */
 struct UCD_info
   {
+    struct UCD_info        *core;              /* owner of the shared state */
+    pthread_mutex_t         lock;              /* guards on-demand setup, owner only */
     int                     big_endian;        /* bool */
     int                     coredump_fd;
+    off_t                   coredump_size;
     char                   *coredump_filename; /* for error meesages only */
     coredump_phdr_t        *phdrs;             /* array, allocated */
     unsigned                phdrs_count;
+    coredump_phdr_t       **sorted_phdrs;      /* non-empty phdrs by p_vaddr, allocated */
+    unsigned                sorted_phdrs_count;
+    uoff_t                 *cover_end;         /* highest end of sorted_phdrs[0..i], allocated */
+    coredump_phdr_t        *last_phdr;         /* last hit of _UCD_find_phdr() */
     ucd_file_table_t        ucd_file_table;
     void                   *note_phdr;         /* allocated or NULL */
     UCD_proc_status_t      *prstatus;          /* points inside note_phdr */
@@ -114,6 +138,7 @@ struct UCD_info
     int                     n_threads;
     struct UCD_thread_info *threads;
     struct elf_dyn_info     edi;
+    struct elf_dyn_info_cache edi_cache;       /* tables of other objects */
   };
 
 
@@ -122,6 +147,12 @@ typedef int (*note_visitor_t)(uint32_t, uint32_t, uint32_t, char *, uint8_t *, v
 
 coredump_phdr_t * _UCD_get_elf_image(struct UCD_info *ui, unw_word_t ip);
 
+int _UCD_index_phdrs(struct UCD_info *ui);
+coredump_phdr_t *_UCD_find_phdr(struct UCD_info *ui, unw_word_t addr);
+
+uint8_t *_UCD_map_segment(struct UCD_info *ui, coredump_phdr_t *phdr);
+void _UCD_unmap_segment(coredump_phdr_t *phdr);
+
 int _UCD_elf_read_segment(struct UCD_info *ui, coredump_phdr_t *phdr, uint8_t **segment, size_t *segment_size);
 int _UCD_elf_visit_notes(uint8_t *segment, size_t segment_size, note_visitor_t visit, void *arg);
 int _UCD_get_threadinfo(struct UCD_info *ui, coredump_phdr_t *phdrs, unsigned phdr_size);
@@ -114,12 +114,17 @@ _ucd_file_open (ucd_file_t *ucd_file)
 
 /**
  * Memory-maps a UCD file
+ *
+ * Called with the lock of the core held; the image is published last,
+ * as _UCD_access_mem() looks at it without the lock.
  */
 uint8_t *
 ucd_file_map (ucd_file_t *ucd_file)
 {
-  if (ucd_file->image != NULL)
-    return ucd_file->image;
+  uint8_t *image = ucd_file->image;
+
+  if (image != NULL)
+    return image;
 
   if (ucd_file->fd == -1)
     _ucd_file_open (ucd_file);
@@ -127,14 +132,14 @@ ucd_file_map (ucd_file_t *ucd_file)
   if (ucd_file->fd == -1)
     return NULL;
 
-  ucd_file->image = mi_mmap(NULL, ucd_file->size, PROT_READ, MAP_PRIVATE, ucd_file->fd, 0);
-  if (ucd_file->image == MAP_FAILED)
+  image = mi_mmap(NULL, ucd_file->size, PROT_READ, MAP_PRIVATE, ucd_file->fd, 0);
+  if (image == MAP_FAILED)
     {
       Debug(0, "error in mmap(%s)\n", ucd_file->filename);
-      ucd_file->image = NULL;
       return NULL;
     }
-  return ucd_file->image;
+  ucd_file->image = image;
+  return image;
 }
 
 
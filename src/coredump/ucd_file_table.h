@@ -46,7 +46,7 @@ struct ucd_file_s
     char const *filename;  /**< Name of the file */
     int         fd;        /**< File descriptor of the file if open, -1 otherwise */
     off_t       size;      /**< File size in bytyes */
-    uint8_t    *image;     /**< Memory-mapped file image */
+    uint8_t *_Atomic image; /**< Memory-mapped file image, set once */
   };
 
 typedef struct ucd_file_s ucd_file_t;
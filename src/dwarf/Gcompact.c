@@ -0,0 +1,483 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* Compact unwind tables.  When enabled with the environment variable
+   UNW_COMPACT_UNWIND_TABLES, the first lookup of an IP in a loaded
+   object runs the CFI program of every FDE listed in the object's
+   .eh_frame_hdr and records the resulting register states as rows
+   sorted by address (see struct dwarf_compact_table).  From then on,
+   find_reg_state() gets the state for an IP in that object from a
+   binary search over the rows: no FDE lookup, no CIE/FDE parsing and
+   no rs-cache.  Tables are immutable once published and are appended
+   to the address space with a compare-and-swap, so lookups need no
+   lock.  They are only built for the local address space and are
+   discarded by unw_flush_cache(), which retires them until no lookup
+   counted in the address space's compact_table_readers can still be
+   walking them.  */
+
+#include "dwarf_i.h"
+#include "libunwind_i.h"
+#include "Gfind_proc_info_i.h"
+#include <stdlib.h>
+
+#ifndef UNW_REMOTE_ONLY
+
+struct compact_builder
+  {
+    unw_word_t start;                   /* start of the described region */
+    struct dwarf_compact_row *rows;
+    size_t row_count, row_max;
+    struct dwarf_compact_saved *saved;
+    size_t saved_count, saved_max;
+    unw_word_t fde_end;                 /* end of the FDE being compiled */
+    uint8_t fde_flags;                  /* flags for all its rows */
+    int failed;                         /* out of memory */
+  };
+
+static int
+compact_tables_enabled (void)
+{
+  static atomic_int enabled = -1;
+  int ret = atomic_load_explicit (&enabled, memory_order_relaxed);
+
+  if (ret < 0)
+    {
+      const char *str = getenv ("UNW_COMPACT_UNWIND_TABLES");
+
+      ret = str && atoi (str) != 0;
+      atomic_store_explicit (&enabled, ret, memory_order_relaxed);
+    }
+  return ret;
+}
+
+/* Make room for NEEDED elements in the scratch array *MEM, which holds
+   COUNT elements and has room for *MAX.  */
+static int
+compact_grow (void **mem, size_t count, size_t needed, size_t *max,
+              size_t elem_size)
+{
+  size_t new_max;
+  void *new_mem;
+
+  if (needed <= *max)
+    return 0;
+
+  new_max = *max ? *max : unw_page_size / elem_size;
+  while (new_max < needed)
+    new_max *= 2;
+  GET_MEMORY (new_mem, new_max * elem_size);
+  if (!new_mem)
+    return -UNW_ENOMEM;
+  if (*mem)
+    {
+      memcpy (new_mem, *mem, count * elem_size);
+      mi_munmap (*mem, *max * elem_size);
+    }
+  *mem = new_mem;
+  *max = new_max;
+  return 0;
+}
+
+static int
+compact_same_state (struct compact_builder *b, const struct dwarf_compact_row *r,
+                    const struct dwarf_compact_saved *saved)
+{
+  const struct dwarf_compact_row *last = &b->rows[b->row_count - 1];
+
+  if (last->flags != r->flags)
+    return 0;
+  if (r->flags & DWARF_COMPACT_UNCOMPILED)
+    return 1;
+  return (last->cfa_reg == r->cfa_reg
+          && last->cfa_offset == r->cfa_offset
+          && last->ret_addr_column == r->ret_addr_column
+          && last->nsaved == r->nsaved
+          && memcmp (&b->saved[last->saved], saved,
+                     r->nsaved * sizeof (*saved)) == 0);
+}
+
+/* Append the row R starting at IP, with the NSAVED rules SAVED.  A row
+   that repeats the state of the previous one is dropped, and a run of
+   rules that repeats the previous row's is shared.  */
+static void
+compact_push (struct compact_builder *b, unw_word_t ip,
+              struct dwarf_compact_row *r, const struct dwarf_compact_saved *saved)
+{
+  const struct dwarf_compact_row *last;
+
+  if (b->failed)
+    return;
+
+  r->start = ip - b->start;
+  r->saved = b->saved_count;
+  if (b->row_count > 0)
+    {
+      last = &b->rows[b->row_count - 1];
+      if (compact_same_state (b, r, saved))
+        return;
+      if (r->nsaved > 0 && last->nsaved == r->nsaved
+          && memcmp (&b->saved[last->saved], saved,
+                     r->nsaved * sizeof (*saved)) == 0)
+        r->saved = last->saved;
+    }
+
+  if (r->saved == b->saved_count && r->nsaved > 0)
+    {
+      if (compact_grow ((void **) &b->saved, b->saved_count,
+                        b->saved_count + r->nsaved, &b->saved_max,
+                        sizeof (b->saved[0])) < 0)
+        {
+          b->failed = 1;
+          return;
+        }
+      memcpy (&b->saved[b->saved_count], saved, r->nsaved * sizeof (*saved));
+      b->saved_count += r->nsaved;
+    }
+
+  if (compact_grow ((void **) &b->rows, b->row_count, b->row_count + 1,
+                    &b->row_max, sizeof (b->rows[0])) < 0)
+    {
+      b->failed = 1;
+      return;
+    }
+  b->rows[b->row_count++] = *r;
+}
+
+static void
+compact_push_uncompiled (struct compact_builder *b, unw_word_t ip)
+{
+  struct dwarf_compact_row r;
+
+  memset (&r, 0, sizeof (r));
+  r.flags = DWARF_COMPACT_UNCOMPILED;
+  compact_push (b, ip, &r, NULL);
+}
+
+static inline int
+compact_fits (unw_word_t val)
+{
+  unw_sword_t sval = (unw_sword_t) val;
+
+  return sval >= INT32_MIN && sval <= INT32_MAX;
+}
+
+/* unw_reg_states_callback for the rows of one FDE.  */
+static int
+compact_add_state (void *token, void *reg_states_data,
+                   size_t reg_states_data_size UNUSED,
+                   unw_word_t start_ip, unw_word_t end_ip UNUSED)
+{
+  struct compact_builder *b = token;
+  dwarf_reg_state_t *rs = reg_states_data;
+  struct dwarf_compact_saved saved[DWARF_NUM_PRESERVED_REGS];
+  struct dwarf_compact_row r;
+  unsigned int i, n = 0;
+
+  /* Ignore what the iterator reports beyond the end of the FDE.  */
+  if (start_ip >= b->fde_end)
+    return 0;
+
+  memset (&r, 0, sizeof (r));
+  r.flags = b->fde_flags;
+  if (rs->reg.where[DWARF_CFA_REG_COLUMN] != DWARF_WHERE_REG
+      || rs->reg.val[DWARF_CFA_REG_COLUMN] > UINT8_MAX
+      || !compact_fits (rs->reg.val[DWARF_CFA_OFF_COLUMN])
+      || rs->ret_addr_column > UINT8_MAX)
+    goto uncompiled;
+  r.cfa_reg = rs->reg.val[DWARF_CFA_REG_COLUMN];
+  r.cfa_offset = (int32_t) rs->reg.val[DWARF_CFA_OFF_COLUMN];
+  r.ret_addr_column = rs->ret_addr_column;
+
+  for (i = 0; i < DWARF_NUM_PRESERVED_REGS; ++i)
+    {
+      if (rs->reg.where[i] == DWARF_WHERE_SAME && rs->reg.val[i] == 0)
+        continue;
+      /* Expressions live in the CFI; they would have to be evaluated
+         from there anyway.  */
+      if (rs->reg.where[i] == DWARF_WHERE_EXPR
+          || rs->reg.where[i] == DWARF_WHERE_VAL_EXPR
+          || !compact_fits (rs->reg.val[i])
+          || n == UINT8_MAX)
+        goto uncompiled;
+      memset (&saved[n], 0, sizeof (saved[n]));
+      saved[n].column = i;
+      saved[n].where = rs->reg.where[i];
+      saved[n].val = (int32_t) rs->reg.val[i];
+      ++n;
+    }
+  r.nsaved = n;
+  compact_push (b, start_ip, &r, saved);
+  return 0;
+
+ uncompiled:
+  compact_push_uncompiled (b, start_ip);
+  return 0;
+}
+
+/* Compile the FDE at FDE_ADDR.  */
+static void
+compact_add_fde (struct compact_builder *b, unw_addr_space_t as,
+                 unw_accessors_t *a, unw_word_t fde_addr, unw_word_t segbase,
+                 unw_word_t end, void *arg)
+{
+  struct dwarf_cursor c;
+  struct dwarf_cie_info *dci;
+  size_t row_count;
+  int ret;
+
+  memset (&c, 0, sizeof (c));
+  if (dwarf_extract_proc_info_from_fde (as, a, &fde_addr, &c.pi, segbase,
+                                        1, 0, arg) < 0)
+    return;
+  dci = c.pi.unwind_info;
+
+  if (c.pi.start_ip < b->start || c.pi.start_ip >= c.pi.end_ip
+      || c.pi.end_ip > end
+      || (b->row_count > 0
+          && c.pi.start_ip - b->start < b->rows[b->row_count - 1].start))
+    goto out;
+
+  /* The end of the previous FDE may be where this one starts.  */
+  if (b->row_count > 0
+      && b->rows[b->row_count - 1].start == c.pi.start_ip - b->start
+      && (b->rows[b->row_count - 1].flags & DWARF_COMPACT_UNCOMPILED))
+    b->row_count--;
+  row_count = b->row_count;
+
+  c.as = as;
+  c.as_arg = arg;
+  c.pi_valid = 1;
+  b->fde_end = c.pi.end_ip;
+  b->fde_flags = dci->signal_frame ? DWARF_COMPACT_SIGNAL_FRAME : 0;
+  ret = dwarf_reg_states_table_iterate (&c, compact_add_state, b);
+  if (ret < 0)
+    {
+      Debug (4, "could not compile FDE for 0x%lx-0x%lx (%d)\n",
+             (long) c.pi.start_ip, (long) c.pi.end_ip, ret);
+      b->row_count = row_count;
+      compact_push_uncompiled (b, c.pi.start_ip);
+    }
+  compact_push_uncompiled (b, c.pi.end_ip);
+
+ out:
+  mempool_free (&dwarf_cie_info_pool, dci);
+}
+
+static struct dwarf_compact_table *
+compact_find_table (struct dwarf_compact_table *t, unw_word_t ip)
+{
+  for (; t; t = atomic_load_explicit (&t->next, memory_order_acquire))
+    if (ip >= t->start && ip < t->end)
+      return t;
+  return NULL;
+}
+
+/* Build the table for the .eh_frame_hdr search table DI.  The table
+   is empty if it cannot be built, so that this is only tried once.  */
+static struct dwarf_compact_table *
+compact_build (unw_addr_space_t as, unw_dyn_info_t *di, void *arg)
+{
+  unw_accessors_t *a = unw_get_accessors_int (as);
+  struct compact_builder b;
+  struct dwarf_compact_table *t;
+  size_t i, entry_count, mem_size;
+
+  memset (&b, 0, sizeof (b));
+  b.start = di->start_ip;
+
+  if (di->end_ip - di->start_ip <= UINT32_MAX)
+    {
+      if (di->format == UNW_INFO_FORMAT_REMOTE_TABLE_64)
+        {
+          const struct table_entry64 *e
+            = (const struct table_entry64 *) (uintptr_t) di->u.rti.table_data;
+
+          entry_count = di->u.rti.table_len * sizeof (unw_word_t) / sizeof (*e);
+          for (i = 0; i < entry_count && !b.failed; ++i)
+            compact_add_fde (&b, as, a, e[i].fde_offset + di->u.rti.segbase,
+                             di->u.rti.segbase, di->end_ip, arg);
+        }
+      else
+        {
+          const struct table_entry *e
+            = (const struct table_entry *) (uintptr_t) di->u.rti.table_data;
+
+          entry_count = di->u.rti.table_len * sizeof (unw_word_t) / sizeof (*e);
+          for (i = 0; i < entry_count && !b.failed; ++i)
+            compact_add_fde (&b, as, a, e[i].fde_offset + di->u.rti.segbase,
+                             di->u.rti.segbase, di->end_ip, arg);
+        }
+    }
+  if (b.failed)
+    b.row_count = b.saved_count = 0;
+
+  mem_size = UNW_ALIGN (sizeof (*t) + b.row_count * sizeof (t->rows[0])
+                        + b.saved_count * sizeof (t->saved[0]),
+                        unw_page_size);
+  GET_MEMORY (t, mem_size);
+  if (t)
+    {
+      atomic_init (&t->next, NULL);
+      t->start = di->start_ip;
+      t->end = di->end_ip;
+      t->mem_size = mem_size;
+      t->row_count = b.row_count;
+      t->saved = (struct dwarf_compact_saved *) &t->rows[b.row_count];
+      memcpy (t->rows, b.rows, b.row_count * sizeof (t->rows[0]));
+      memcpy (t->saved, b.saved, b.saved_count * sizeof (t->saved[0]));
+      Debug (4, "compiled 0x%lx-0x%lx into %zu rows, %zu rules\n",
+             (long) t->start, (long) t->end, b.row_count, b.saved_count);
+    }
+
+  if (b.rows)
+    mi_munmap (b.rows, b.row_max * sizeof (b.rows[0]));
+  if (b.saved)
+    mi_munmap (b.saved, b.saved_max * sizeof (b.saved[0]));
+  return t;
+}
+
+HIDDEN void
+dwarf_compact_table_add (unw_addr_space_t as, unw_dyn_info_t *di, void *arg)
+{
+  _Atomic (struct dwarf_compact_table *) *tail;
+  struct dwarf_compact_table *t, *expected;
+
+  if (as != unw_local_addr_space
+      || as->caching_policy == UNW_CACHE_NONE
+      || (di->format != UNW_INFO_FORMAT_REMOTE_TABLE
+          && di->format != UNW_INFO_FORMAT_REMOTE_TABLE_64)
+      || !compact_tables_enabled ())
+    return;
+
+  atomic_fetch_add (&as->compact_table_readers, 1);
+  if (compact_find_table (atomic_load (&as->compact_tables), di->start_ip)
+      || !(t = compact_build (as, di, arg)))
+    goto out;
+
+  /* Append, so that the objects touched first, which tend to be the
+     busiest, are also found first.  A table appended to a list that
+     was flushed meanwhile is freed with that list.  */
+  tail = &as->compact_tables;
+  for (;;)
+    {
+      expected = NULL;
+      if (atomic_compare_exchange_strong (tail, &expected, t))
+        break;
+      if (expected->start < t->end && t->start < expected->end)
+        {
+          /* Another thread got there first.  */
+          mi_munmap (t, t->mem_size);
+          break;
+        }
+      tail = &expected->next;
+    }
+
+ out:
+  atomic_fetch_sub (&as->compact_table_readers, 1);
+}
+
+static int
+compact_lookup (struct dwarf_cursor *c, dwarf_state_record_t *sr)
+{
+  struct dwarf_compact_table *t;
+  const struct dwarf_compact_row *r;
+  const struct dwarf_compact_saved *s;
+  unw_word_t ip = c->ip;
+  size_t lo, hi, mid;
+  uint32_t offset;
+  int signal_frame;
+  unsigned int i;
+
+  t = atomic_load_explicit (&c->as->compact_tables, memory_order_acquire);
+  if (!t)
+    return 0;
+
+  /* Same adjustment as in fetch_proc_info().  */
+  if (c->use_prev_instr)
+    {
+#if defined(__arm__)
+      ip &= ~(unw_word_t)0x1;
+#endif
+      --ip;
+    }
+
+  if (!(t = compact_find_table (t, ip)))
+    return 0;
+
+  /* Find the last row starting at or below IP.  */
+  offset = ip - t->start;
+  lo = 0;
+  hi = t->row_count;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (t->rows[mid].start <= offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  if (lo == 0)
+    return 0;
+  r = &t->rows[lo - 1];
+  if (r->flags & DWARF_COMPACT_UNCOMPILED)
+    return 0;
+
+  memset (sr->rs_current.reg.where, DWARF_WHERE_SAME,
+          sizeof (sr->rs_current.reg.where));
+  memset (sr->rs_current.reg.val, 0, sizeof (sr->rs_current.reg.val));
+  sr->rs_current.ret_addr_column = r->ret_addr_column;
+  sr->rs_current.reg.where[DWARF_CFA_REG_COLUMN] = DWARF_WHERE_REG;
+  sr->rs_current.reg.val[DWARF_CFA_REG_COLUMN] = r->cfa_reg;
+  sr->rs_current.reg.val[DWARF_CFA_OFF_COLUMN] = (unw_word_t) r->cfa_offset;
+  for (i = 0, s = &t->saved[r->saved]; i < r->nsaved; ++i, ++s)
+    {
+      sr->rs_current.reg.where[s->column] = s->where;
+      sr->rs_current.reg.val[s->column] = (unw_word_t) (unw_sword_t) s->val;
+    }
+
+  signal_frame = (r->flags & DWARF_COMPACT_SIGNAL_FRAME) != 0;
+  c->use_prev_instr = ! signal_frame;
+  tdep_reuse_frame (c, signal_frame);
+  return 1;
+}
+
+/* Look up the register state for C->ip.  Returns 1 after filling in
+   SR and updating the cursor as find_reg_state() would, or 0 if there
+   is no compiled row for it.  */
+HIDDEN int
+dwarf_compact_table_lookup (struct dwarf_cursor *c, dwarf_state_record_t *sr)
+{
+  unw_addr_space_t as = c->as;
+  int ret;
+
+  if (!atomic_load_explicit (&as->compact_tables, memory_order_relaxed)
+      || as->caching_policy == UNW_CACHE_NONE)
+    return 0;
+
+  atomic_fetch_add (&as->compact_table_readers, 1);
+  ret = compact_lookup (c, sr);
+  atomic_fetch_sub (&as->compact_table_readers, 1);
+  return ret;
+}
+
+#endif /* !UNW_REMOTE_ONLY */
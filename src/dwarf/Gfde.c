@@ -37,6 +37,134 @@ is_cie_id (unw_word_t val, int is_debug_frame)
     return (val == 0);
 }
 
+/* The CIE cache (struct dwarf_cie_cache), direct-mapped by a hash of
+   the CIE address.  It is filled and read without a lock: a writer
+   claims an entry by making its sequence number odd, and simply skips
+   the update if another writer holds it, so the cache can be used from
+   signal handlers and by several threads at once.  Readers copy the
+   entry and check that the sequence number did not change meanwhile.
+   Entries of an earlier cache generation are ignored, so
+   unw_flush_cache() empties the cache.  CIEs in .debug_frame are not
+   cached: they live in buffers that may be freed and reused for
+   another object.  */
+
+static inline struct dwarf_cie_cache_entry *
+cie_cache_entry (unw_addr_space_t as, unw_word_t cie_addr)
+{
+  uint64_t h = ((uint64_t) cie_addr >> 2) * 0x9e3779b97f4a7c15ULL;
+
+  return &as->cie_cache.entries[h >> (64 - DWARF_LOG_CIE_CACHE_SIZE)];
+}
+
+static inline uint32_t
+cie_cache_generation (unw_addr_space_t as)
+{
+  return atomic_load_explicit (&as->cache_generation, memory_order_relaxed);
+}
+
+/* Look up the CIE at CIE_ADDR.  Copies its fields to *DCI and, if SR
+   is not NULL, the state after its initial instructions to *SR.
+   Returns 1 on a hit, 0 otherwise.  */
+static int
+cie_cache_read (unw_addr_space_t as, unw_word_t cie_addr,
+                struct dwarf_cie_info *dci, dwarf_state_record_t *sr)
+{
+  struct dwarf_cie_cache_entry *e = cie_cache_entry (as, cie_addr);
+  uint32_t seq;
+
+  if (as->caching_policy == UNW_CACHE_NONE)
+    return 0;
+
+  seq = atomic_load_explicit (&e->seq, memory_order_acquire);
+  if ((seq & 1) || e->cie_addr != cie_addr
+      || e->generation != cie_cache_generation (as))
+    return 0;
+
+  if (dci)
+    memcpy (dci, &e->dci, sizeof (*dci));
+  if (sr)
+    {
+      if (!e->have_rs)
+        return 0;
+      sr->args_size = e->args_size;
+      memcpy (&sr->rs_initial, &e->rs_initial, sizeof (sr->rs_initial));
+    }
+  atomic_thread_fence (memory_order_acquire);
+  return atomic_load_explicit (&e->seq, memory_order_relaxed) == seq;
+}
+
+static struct dwarf_cie_cache_entry *
+cie_cache_write_begin (unw_addr_space_t as, unw_word_t cie_addr)
+{
+  struct dwarf_cie_cache_entry *e = cie_cache_entry (as, cie_addr);
+  uint32_t seq;
+
+  if (as->caching_policy == UNW_CACHE_NONE)
+    return NULL;
+
+  seq = atomic_load_explicit (&e->seq, memory_order_relaxed);
+  if ((seq & 1)
+      || !atomic_compare_exchange_strong_explicit (&e->seq, &seq, seq + 1,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed))
+    return NULL;
+  atomic_thread_fence (memory_order_release);
+  return e;
+}
+
+static inline void
+cie_cache_write_end (struct dwarf_cie_cache_entry *e)
+{
+  atomic_fetch_add_explicit (&e->seq, 1, memory_order_release);
+}
+
+static void
+cie_cache_put (unw_addr_space_t as, unw_word_t cie_addr,
+               const struct dwarf_cie_info *dci)
+{
+  struct dwarf_cie_cache_entry *e = cie_cache_write_begin (as, cie_addr);
+
+  if (!e)
+    return;
+  e->cie_addr = cie_addr;
+  e->generation = cie_cache_generation (as);
+  memcpy (&e->dci, dci, sizeof (e->dci));
+  e->have_rs = 0;
+  cie_cache_write_end (e);
+}
+
+/* Get the register state after the initial instructions of the CIE at
+   CIE_ADDR, as stored by dwarf_cie_cache_put_rs().  Returns 1 and sets
+   SR->rs_initial, SR->rs_current and SR->args_size on a hit.  */
+HIDDEN int
+dwarf_cie_cache_get_rs (unw_addr_space_t as, unw_word_t cie_addr,
+                        dwarf_state_record_t *sr)
+{
+  if (!cie_cache_read (as, cie_addr, NULL, sr))
+    return 0;
+  memcpy (&sr->rs_current, &sr->rs_initial, sizeof (sr->rs_current));
+  return 1;
+}
+
+/* Remember SR as the state after the initial instructions of the CIE
+   at CIE_ADDR, if that CIE is still cached.  */
+HIDDEN void
+dwarf_cie_cache_put_rs (unw_addr_space_t as, unw_word_t cie_addr,
+                        const dwarf_state_record_t *sr)
+{
+  struct dwarf_cie_cache_entry *e = cie_cache_write_begin (as, cie_addr);
+
+  if (!e)
+    return;
+  if (e->cie_addr == cie_addr && e->generation == cie_cache_generation (as))
+    {
+      e->args_size = sr->args_size;
+      memcpy (&e->rs_initial, &sr->rs_initial, sizeof (e->rs_initial));
+      e->have_rs = 1;
+    }
+  cie_cache_write_end (e);
+}
+
 /* Note: we don't need to keep track of more than the first four
    characters of the augmentation string, because we (a) ignore any
    augmentation string contents once we find an unrecognized character
@@ -311,8 +439,20 @@ dwarf_extract_proc_info_from_fde (unw_addr_space_t as, unw_accessors_t *a,
 
   Debug (15, "looking for CIE at address %lx\n", (long) cie_addr);
 
-  if ((ret = parse_cie (as, a, cie_addr, pi, &dci, is_debug_frame, arg)) < 0)
-    return ret;
+  if (is_debug_frame)
+    {
+      if ((ret = parse_cie (as, a, cie_addr, pi, &dci, is_debug_frame,
+                            arg)) < 0)
+        return ret;
+    }
+  else if (!cie_cache_read (as, cie_addr, &dci, NULL))
+    {
+      if ((ret = parse_cie (as, a, cie_addr, pi, &dci, is_debug_frame,
+                            arg)) < 0)
+        return ret;
+      dci.cie_addr = cie_addr;
+      cie_cache_put (as, cie_addr, &dci);
+    }
 
   /* IP-range has same encoding as FDE pointers, except that it's
      always an absolute value: */
@@ -37,6 +37,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include <zlib.h>
 #endif /* HAVE_ZLIB */
 
+#ifdef HAVE__DL_FIND_OBJECT
+#include <dlfcn.h>
+#endif
+
 /* table_entry, table_entry64, lookup, and lookup64 are defined in the
    shared header so they can be reused by unit tests.  The struct
    definitions are needed here before UNW_REMOTE_ONLY is checked.  */
@@ -268,6 +272,7 @@ locate_debug_info (unw_addr_space_t as, unw_word_t addr, const char *dlname,
 
   if (!err)
     {
+      unwi_stats_inc (as, UNWI_STAT_ELF_MAP);
       GET_MEMORY (fdesc, sizeof (struct unw_debug_frame_list));
       if (!fdesc)
         {
@@ -763,6 +768,363 @@ dwarf_callback (struct dl_phdr_info *info, size_t size, void *ptr)
   return found;
 }
 
+#ifdef HAVE_DL_PHDR_INFO_COUNTERS
+
+/* Snapshot of the objects reported by dl_iterate_phdr(), so that an IP
+   can be mapped to its object by a binary search instead of a walk
+   over every loaded object.  A snapshot is immutable once published
+   and stays valid for as long as the loader's dlpi_adds/dlpi_subs
+   counters do not change.  Reading the counters takes the loader's
+   lock, so where _dl_find_object() is available a lookup first asks
+   it, without any lock, for the link map containing the IP; if the
+   snapshot has the object under the same link map and load address,
+   it cannot have been unloaded since and the counters are not read.
+   Snapshots that have been replaced are only unmapped once no lookup
+   is in progress.  */
+
+struct dwarf_object
+  {
+    Elf_W(Addr) addr;                   /* dlpi_addr */
+    const char *name;                   /* dlpi_name */
+    const Elf_W(Phdr) *phdr;            /* dlpi_phdr */
+    Elf_W(Half) phnum;                  /* dlpi_phnum */
+#ifdef HAVE__DL_FIND_OBJECT
+    const struct link_map *link_map;    /* from _dl_find_object() */
+#endif
+  };
+
+struct dwarf_object_range
+  {
+    unw_word_t start;                   /* start of a PT_LOAD segment */
+    unw_word_t end;                     /* end of the segment */
+    size_t object;                      /* index into objects[] */
+  };
+
+struct dwarf_object_map
+  {
+    struct dwarf_object_map *next;      /* link on the retired list */
+    unsigned long long adds;            /* dlpi_adds at snapshot time */
+    unsigned long long subs;            /* dlpi_subs at snapshot time */
+    size_t mem_size;
+    size_t object_count;
+    size_t range_count;
+    struct dwarf_object *objects;
+    struct dwarf_object_range ranges[];
+  };
+
+struct dwarf_object_map_data
+  {
+    struct dwarf_object_map *map;       /* NULL while counting */
+    size_t object_count;
+    size_t range_count;
+    unsigned long long adds;
+    unsigned long long subs;
+    int valid;                          /* were the counters seen? */
+  };
+
+static _Atomic (struct dwarf_object_map *) dwarf_object_map;
+static _Atomic (struct dwarf_object_map *) dwarf_retired_object_maps;
+static atomic_int dwarf_object_map_readers;
+static atomic_flag dwarf_object_map_busy = ATOMIC_FLAG_INIT;
+
+static int
+object_map_has_counters (struct dl_phdr_info *info, size_t size)
+{
+  return size >= offsetof (struct dl_phdr_info, dlpi_subs)
+                 + sizeof (info->dlpi_subs);
+}
+
+/* Record the loader's add/remove counters.  One object is enough.  */
+static int
+object_map_probe_callback (struct dl_phdr_info *info, size_t size, void *ptr)
+{
+  struct dwarf_object_map_data *data = ptr;
+
+  if (!object_map_has_counters (info, size))
+    return -1;
+
+  data->adds = info->dlpi_adds;
+  data->subs = info->dlpi_subs;
+  data->valid = 1;
+  return 1;
+}
+
+/* Count the objects and their PT_LOAD segments or, if DATA->map is
+   set, fill them into the map.  */
+static int
+object_map_fill_callback (struct dl_phdr_info *info, size_t size, void *ptr)
+{
+  struct dwarf_object_map_data *data = ptr;
+  struct dwarf_object_map *map = data->map;
+  struct dwarf_object *obj = NULL;
+  const Elf_W(Phdr) *phdr;
+  long n;
+
+  if (!object_map_has_counters (info, size))
+    return -1;
+
+  if (!data->valid)
+    {
+      data->adds = info->dlpi_adds;
+      data->subs = info->dlpi_subs;
+      data->valid = 1;
+    }
+  else if (data->adds != info->dlpi_adds || data->subs != info->dlpi_subs)
+    return -1;
+
+  if (map)
+    {
+      if (data->object_count >= map->object_count)
+        return -1;
+      obj = &map->objects[data->object_count];
+      obj->addr = info->dlpi_addr;
+      obj->name = info->dlpi_name;
+      obj->phdr = info->dlpi_phdr;
+      obj->phnum = info->dlpi_phnum;
+#ifdef HAVE__DL_FIND_OBJECT
+      obj->link_map = NULL;
+#endif
+    }
+
+  for (phdr = info->dlpi_phdr, n = info->dlpi_phnum; --n >= 0; phdr++)
+    {
+      if (phdr->p_type != PT_LOAD || phdr->p_memsz == 0)
+        continue;
+
+      if (map)
+        {
+          struct dwarf_object_range *r;
+
+          if (data->range_count >= map->range_count)
+            return -1;
+          r = &map->ranges[data->range_count];
+          r->start = info->dlpi_addr + phdr->p_vaddr;
+          r->end = r->start + phdr->p_memsz;
+          r->object = data->object_count;
+#ifdef HAVE__DL_FIND_OBJECT
+          if (!obj->link_map)
+            {
+              struct dl_find_object dlfo;
+
+              if (_dl_find_object ((void *) r->start, &dlfo) == 0)
+                obj->link_map = dlfo.dlfo_link_map;
+            }
+#endif
+        }
+      data->range_count++;
+    }
+
+  data->object_count++;
+  return 0;
+}
+
+static void
+object_map_sift_down (struct dwarf_object_range *r, size_t i, size_t n)
+{
+  struct dwarf_object_range tmp;
+  size_t child;
+
+  while ((child = 2 * i + 1) < n)
+    {
+      if (child + 1 < n && r[child + 1].start > r[child].start)
+        child++;
+      if (r[i].start >= r[child].start)
+        break;
+      tmp = r[i];
+      r[i] = r[child];
+      r[child] = tmp;
+      i = child;
+    }
+}
+
+/* Sort the segments by start address.  This runs from within the
+   unwinder, so qsort() and its allocations are best avoided.  */
+static void
+object_map_sort (struct dwarf_object_range *r, size_t n)
+{
+  struct dwarf_object_range tmp;
+  size_t i;
+
+  for (i = n / 2; i-- > 0; )
+    object_map_sift_down (r, i, n);
+  for (i = n; i-- > 1; )
+    {
+      tmp = r[0];
+      r[0] = r[i];
+      r[i] = tmp;
+      object_map_sift_down (r, 0, i);
+    }
+}
+
+static void
+object_map_free (struct dwarf_object_map *map)
+{
+  struct dwarf_object_map *next;
+
+  for (; map; map = next)
+    {
+      next = map->next;
+      mi_munmap (map, map->mem_size);
+    }
+}
+
+/* Take a fresh snapshot and publish it.  Must be called from within a
+   lookup, i.e. with dwarf_object_map_readers raised by one.  Returns
+   NULL if the loader does not provide the counters or the object list
+   changed while it was being copied.  */
+static struct dwarf_object_map *
+object_map_build (void)
+{
+  struct dwarf_object_map_data data;
+  struct dwarf_object_map *map, *old;
+  size_t mem_size;
+
+  memset (&data, 0, sizeof (data));
+  unwi_stats_inc (unw_local_addr_space, UNWI_STAT_PHDR_WALK);
+  if (dl_iterate_phdr (object_map_fill_callback, &data) != 0 || !data.valid)
+    return NULL;
+
+  mem_size = UNW_ALIGN (sizeof (*map)
+                        + data.range_count * sizeof (map->ranges[0])
+                        + data.object_count * sizeof (map->objects[0]),
+                        unw_page_size);
+  GET_MEMORY (map, mem_size);
+  if (!map)
+    return NULL;
+
+  map->next = NULL;
+  map->adds = data.adds;
+  map->subs = data.subs;
+  map->mem_size = mem_size;
+  map->object_count = data.object_count;
+  map->range_count = data.range_count;
+  map->objects = (struct dwarf_object *) &map->ranges[data.range_count];
+
+  memset (&data, 0, sizeof (data));
+  data.map = map;
+  unwi_stats_inc (unw_local_addr_space, UNWI_STAT_PHDR_WALK);
+  if (dl_iterate_phdr (object_map_fill_callback, &data) != 0
+      || data.adds != map->adds || data.subs != map->subs
+      || data.object_count != map->object_count
+      || data.range_count != map->range_count)
+    {
+      mi_munmap (map, mem_size);
+      return NULL;
+    }
+
+  object_map_sort (map->ranges, map->range_count);
+
+  Debug (14, "snapshot of %zu objects, %zu segments (adds=%llu, subs=%llu)\n",
+         map->object_count, map->range_count, map->adds, map->subs);
+
+  old = atomic_exchange (&dwarf_object_map, map);
+  if (old)
+    {
+      old->next = atomic_load (&dwarf_retired_object_maps);
+      atomic_store (&dwarf_retired_object_maps, old);
+    }
+
+  /* A lookup that starts from here on can only see the new map, so the
+     retired ones can go if the caller's lookup is the only one left.  */
+  if (atomic_load (&dwarf_object_map_readers) == 1)
+    object_map_free (atomic_exchange (&dwarf_retired_object_maps, NULL));
+
+  return map;
+}
+
+/* Find the object containing IP in MAP, or NULL.  */
+static const struct dwarf_object *
+object_map_lookup (const struct dwarf_object_map *map, unw_word_t ip)
+{
+  size_t lo, hi, mid;
+
+  /* Find the last segment starting at or below IP.  */
+  lo = 0;
+  hi = map->range_count;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (map->ranges[mid].start <= ip)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (lo > 0 && ip < map->ranges[lo - 1].end)
+    return &map->objects[map->ranges[lo - 1].object];
+  return NULL;
+}
+
+/* Find the object containing IP in the current snapshot and describe
+   it in INFO.  Returns 1 if found, 0 if no loaded object contains IP
+   and -1 if no up-to-date snapshot is available.  */
+static int
+dwarf_find_object (unw_word_t ip, struct dl_phdr_info *info)
+{
+  struct dwarf_object_map_data data;
+  struct dwarf_object_map *map;
+  const struct dwarf_object *obj = NULL;
+  int ret = -1;
+
+  atomic_fetch_add (&dwarf_object_map_readers, 1);
+
+  map = atomic_load (&dwarf_object_map);
+#ifdef HAVE__DL_FIND_OBJECT
+  if (map)
+    {
+      struct dl_find_object dlfo;
+
+      obj = object_map_lookup (map, ip);
+      if (obj
+          && (_dl_find_object ((void *) ip, &dlfo) != 0
+              || obj->link_map != dlfo.dlfo_link_map
+              || obj->addr != dlfo.dlfo_link_map->l_addr))
+        obj = NULL;
+    }
+  if (!obj)
+#endif
+    {
+      memset (&data, 0, sizeof (data));
+      dl_iterate_phdr (object_map_probe_callback, &data);
+      if (!data.valid)
+        goto out;
+
+      if (!map || map->adds != data.adds || map->subs != data.subs)
+        {
+          map = NULL;
+          /* Only one thread rebuilds; everybody else walks the objects
+             the slow way in the meantime.  */
+          if (!atomic_flag_test_and_set (&dwarf_object_map_busy))
+            {
+              map = object_map_build ();
+              atomic_flag_clear (&dwarf_object_map_busy);
+            }
+          if (!map || map->adds != data.adds || map->subs != data.subs)
+            goto out;
+        }
+      obj = object_map_lookup (map, ip);
+    }
+
+  ret = 0;
+  if (obj)
+    {
+      memset (info, 0, sizeof (*info));
+      info->dlpi_addr = obj->addr;
+      info->dlpi_name = obj->name;
+      info->dlpi_phdr = obj->phdr;
+      info->dlpi_phnum = obj->phnum;
+      info->dlpi_adds = map->adds;
+      info->dlpi_subs = map->subs;
+      ret = 1;
+    }
+
+ out:
+  atomic_fetch_sub (&dwarf_object_map_readers, 1);
+  return ret;
+}
+
+#endif /* HAVE_DL_PHDR_INFO_COUNTERS */
+
 HIDDEN int
 dwarf_find_proc_info (unw_addr_space_t as, unw_word_t ip,
                       unw_proc_info_t *pi, int need_unwind_info, void *arg)
@@ -781,7 +1143,26 @@ dwarf_find_proc_info (unw_addr_space_t as, unw_word_t ip,
   cb_data.di_debug.format = -1;
 
   SIGPROCMASK (SIG_SETMASK, &unwi_full_mask, &saved_mask);
-  ret = as->iterate_phdr_function (dwarf_callback, &cb_data);
+#ifdef HAVE_DL_PHDR_INFO_COUNTERS
+  /* The snapshot is only used for the loader's own object list; a
+     custom iterate_phdr function may report something else.  */
+  if (as->iterate_phdr_function == dl_iterate_phdr
+      && as->caching_policy != UNW_CACHE_NONE)
+    {
+      struct dl_phdr_info info;
+
+      ret = dwarf_find_object (ip, &info);
+      if (ret > 0)
+        ret = dwarf_callback (&info, sizeof (info), &cb_data);
+    }
+  else
+    ret = -1;
+  if (ret < 0)
+#endif
+    {
+      unwi_stats_inc (as, UNWI_STAT_PHDR_WALK);
+      ret = as->iterate_phdr_function (dwarf_callback, &cb_data);
+    }
   SIGPROCMASK (SIG_SETMASK, &saved_mask, NULL);
 
   if (ret > 0)
@@ -795,6 +1176,8 @@ dwarf_find_proc_info (unw_addr_space_t as, unw_word_t ip,
         {
 	ret = dwarf_search_unwind_table_int (as, ip, &cb_data.di,
 					     pi, need_unwind_info, arg);
+	  /* Compile the object's CFI on its first lookup, if enabled.  */
+	  dwarf_compact_table_add (as, &cb_data.di, arg);
         }
       else
 	ret = -UNW_ENOINFO;
@@ -31,8 +31,8 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #define alloc_reg_state()       (mempool_alloc (&dwarf_reg_state_pool))
 #define free_reg_state(rs)      (mempool_free (&dwarf_reg_state_pool, rs))
 
-#define DWARF_UNW_CACHE_SIZE(log_size)   (1 << log_size)
-#define DWARF_UNW_HASH_SIZE(log_size)    (1 << (log_size + 1))
+#define DWARF_UNW_CACHE_SIZE(log_size)   (1U << (log_size))
+#define DWARF_UNW_HASH_SIZE(log_size)    (1U << ((log_size) + 1))
 
 static inline int
 read_regnum (unw_addr_space_t as, unw_accessors_t *a, unw_word_t *addr,
@@ -518,11 +518,17 @@ put_unwind_info (struct dwarf_cursor *c, unw_proc_info_t *pi)
 static inline int
 setup_fde (struct dwarf_cursor *c, dwarf_state_record_t *sr)
 {
+  struct dwarf_cie_info *dci = c->pi.unwind_info;
   int i, ret;
 
   assert (c->pi_valid);
 
   memset (sr, 0, sizeof (*sr));
+
+  /* FDEs sharing a CIE start from the same state.  */
+  if (dci->cie_addr && dwarf_cie_cache_get_rs (c->as, dci->cie_addr, sr))
+    return 0;
+
   for (i = 0; i < DWARF_NUM_PRESERVED_REGS + 2; ++i)
     set_reg (sr, i, DWARF_WHERE_SAME, 0);
 
@@ -534,7 +540,6 @@ setup_fde (struct dwarf_cursor *c, dwarf_state_record_t *sr)
   set_reg (sr, TDEP_DWARF_SP, DWARF_WHERE_CFA, 0);
 #endif
 
-  struct dwarf_cie_info *dci = c->pi.unwind_info;
   sr->rs_current.ret_addr_column  = dci->ret_addr_column;
   unw_word_t addr = dci->cie_instr_start;
   unw_word_t curr_ip = 0;
@@ -547,6 +552,8 @@ setup_fde (struct dwarf_cursor *c, dwarf_state_record_t *sr)
     return ret;
 
   memcpy (&sr->rs_initial, &sr->rs_current, sizeof (sr->rs_initial));
+  if (dci->cie_addr)
+    dwarf_cie_cache_put_rs (c->as, dci->cie_addr, sr);
   return 0;
 }
 
@@ -569,55 +576,229 @@ parse_fde (struct dwarf_cursor *c, unw_word_t ip, dwarf_state_record_t *sr)
   return 0;
 }
 
-HIDDEN int
-dwarf_flush_rs_cache (struct dwarf_rs_cache *cache)
+/* Writers bracket every change to the tables of an rs-cache with these,
+   so that a lockless reader (see rs_lookup_lockless()) can tell that it
+   raced with one: the sequence number is odd while an update is in
+   progress.  Writers are serialized by the cache lock.  */
+static inline void
+rs_cache_write_begin (struct dwarf_rs_cache *cache)
 {
-  int i;
-
-  if (cache->log_size == DWARF_DEFAULT_LOG_UNW_CACHE_SIZE
-      || !cache->hash) {
-    cache->hash = cache->default_hash;
-    cache->buckets = cache->default_buckets;
-    cache->links = cache->default_links;
-    cache->log_size = DWARF_DEFAULT_LOG_UNW_CACHE_SIZE;
-  } else {
-    if (cache->hash && cache->hash != cache->default_hash)
-      mi_munmap(cache->hash, DWARF_UNW_HASH_SIZE(cache->prev_log_size)
-                              * sizeof (cache->hash[0]));
-    if (cache->buckets && cache->buckets != cache->default_buckets)
-      mi_munmap(cache->buckets, DWARF_UNW_CACHE_SIZE(cache->prev_log_size)
-                              * sizeof (cache->buckets[0]));
-    if (cache->links && cache->links != cache->default_links)
-      mi_munmap(cache->links, DWARF_UNW_CACHE_SIZE(cache->prev_log_size)
-                              * sizeof (cache->links[0]));
-    GET_MEMORY(cache->hash, DWARF_UNW_HASH_SIZE(cache->log_size)
-                             * sizeof (cache->hash[0]));
-    GET_MEMORY(cache->buckets, DWARF_UNW_CACHE_SIZE(cache->log_size)
-                                * sizeof (cache->buckets[0]));
-    GET_MEMORY(cache->links, DWARF_UNW_CACHE_SIZE(cache->log_size)
-                                * sizeof (cache->links[0]));
-    if (!cache->hash || !cache->buckets || !cache->links)
+  uint32_t seq = atomic_load_explicit (&cache->seq, memory_order_relaxed);
+  atomic_store_explicit (&cache->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence (memory_order_release);
+}
+
+static inline void
+rs_cache_write_end (struct dwarf_rs_cache *cache)
+{
+  uint32_t seq = atomic_load_explicit (&cache->seq, memory_order_relaxed);
+  atomic_store_explicit (&cache->seq, seq + 1, memory_order_release);
+}
+
+/* Tables replaced in a cache with lockless readers are never unmapped,
+   since a reader may still be walking them.  They are kept on a list
+   threaded through their buckets, with their memory handed back to the
+   kernel, and are reused when the cache returns to their size.  This
+   bounds the address space held to one set of tables per size.  */
+struct dwarf_rs_retired
+  {
+    struct dwarf_rs_retired *next;
+    unsigned short log_size;
+    unw_hash_index_t *hash;
+    dwarf_reg_cache_entry_t *links;
+  };
+
+static void
+rs_cache_retire (struct dwarf_rs_cache *cache)
+{
+  unsigned short log_size = cache->prev_log_size;
+  struct dwarf_rs_retired *r = (struct dwarf_rs_retired *) cache->buckets;
+
+#ifdef MADV_DONTNEED
+  madvise (cache->hash, DWARF_UNW_HASH_SIZE(log_size) * sizeof (cache->hash[0]),
+           MADV_DONTNEED);
+  madvise (cache->buckets, DWARF_UNW_CACHE_SIZE(log_size)
+                           * sizeof (cache->buckets[0]), MADV_DONTNEED);
+  madvise (cache->links, DWARF_UNW_CACHE_SIZE(log_size)
+                         * sizeof (cache->links[0]), MADV_DONTNEED);
+#endif
+  r->log_size = log_size;
+  r->hash = cache->hash;
+  r->links = cache->links;
+  r->next = cache->retired;
+  cache->retired = r;
+}
+
+static int
+rs_cache_unretire (struct dwarf_rs_cache *cache, unsigned short log_size)
+{
+  struct dwarf_rs_retired **pr, *r;
+
+  for (pr = &cache->retired; (r = *pr) != NULL; pr = &r->next)
+    if (r->log_size == log_size)
       {
-        Debug (1, "Unable to allocate cache memory");
-        return -UNW_ENOMEM;
+        *pr = r->next;
+        cache->hash = r->hash;
+        cache->links = r->links;
+        cache->buckets = (dwarf_reg_state_t *) r;
+        return 1;
       }
-    cache->prev_log_size = cache->log_size;
-  }
+  return 0;
+}
 
-  cache->rr_head = 0;
+/* Empty CACHE and size it to hold DWARF_UNW_CACHE_SIZE(LOG_SIZE) entries.
+   SHARED is nonzero for a cache that may have lockless readers.  */
+HIDDEN int
+dwarf_flush_rs_cache (struct dwarf_rs_cache *cache, unsigned short log_size,
+                      int shared)
+{
+  int have_tables = cache->hash && cache->hash != cache->default_hash;
+  uint32_t i;
+  int ret = 0;
+
+  rs_cache_write_begin (cache);
+
+  if (have_tables ? log_size != cache->prev_log_size
+                  : log_size != DWARF_DEFAULT_LOG_UNW_CACHE_SIZE)
+    {
+      if (have_tables && shared)
+        rs_cache_retire (cache);
+      else if (have_tables)
+        {
+          mi_munmap(cache->hash, DWARF_UNW_HASH_SIZE(cache->prev_log_size)
+                                  * sizeof (cache->hash[0]));
+          mi_munmap(cache->buckets, DWARF_UNW_CACHE_SIZE(cache->prev_log_size)
+                                     * sizeof (cache->buckets[0]));
+          mi_munmap(cache->links, DWARF_UNW_CACHE_SIZE(cache->prev_log_size)
+                                   * sizeof (cache->links[0]));
+        }
+      have_tables = 0;
+
+      if (log_size != DWARF_DEFAULT_LOG_UNW_CACHE_SIZE
+          && rs_cache_unretire (cache, log_size))
+        {
+          cache->prev_log_size = log_size;
+          have_tables = 1;
+        }
+      else if (log_size != DWARF_DEFAULT_LOG_UNW_CACHE_SIZE)
+        {
+          unw_hash_index_t *hash;
+          dwarf_reg_state_t *buckets;
+          dwarf_reg_cache_entry_t *links;
+
+          GET_MEMORY(hash, DWARF_UNW_HASH_SIZE(log_size) * sizeof (hash[0]));
+          GET_MEMORY(buckets, DWARF_UNW_CACHE_SIZE(log_size)
+                               * sizeof (buckets[0]));
+          GET_MEMORY(links, DWARF_UNW_CACHE_SIZE(log_size)
+                             * sizeof (links[0]));
+          if (hash && buckets && links)
+            {
+              cache->hash = hash;
+              cache->buckets = buckets;
+              cache->links = links;
+              cache->prev_log_size = log_size;
+              have_tables = 1;
+            }
+          else
+            {
+              /* Keep a usable cache: fall back to the static default
+                 storage.  Nobody has seen these tables yet. */
+              Debug (1, "Unable to allocate cache memory");
+              if (hash)
+                mi_munmap(hash, DWARF_UNW_HASH_SIZE(log_size) * sizeof (hash[0]));
+              if (buckets)
+                mi_munmap(buckets, DWARF_UNW_CACHE_SIZE(log_size)
+                                    * sizeof (buckets[0]));
+              if (links)
+                mi_munmap(links, DWARF_UNW_CACHE_SIZE(log_size)
+                                  * sizeof (links[0]));
+              log_size = DWARF_DEFAULT_LOG_UNW_CACHE_SIZE;
+              ret = -UNW_ENOMEM;
+            }
+        }
+    }
+
+  if (!have_tables)
+    {
+      cache->hash = cache->default_hash;
+      cache->buckets = cache->default_buckets;
+      cache->links = cache->default_links;
+    }
+  cache->log_size = log_size;
+  cache->clock_hand = 0;
 
   for (i = 0; i < DWARF_UNW_CACHE_SIZE(cache->log_size); ++i)
     {
       cache->links[i].coll_chain = -1;
       cache->links[i].ip = 0;
       cache->links[i].valid = 0;
+      cache->links[i].referenced = 0;
     }
   for (i = 0; i< DWARF_UNW_HASH_SIZE(cache->log_size); ++i)
     cache->hash[i] = -1;
 
-  return 0;
+  rs_cache_write_end (cache);
+  return ret;
 }
 
+#if defined(HAVE___CACHE_PER_THREAD) && HAVE___CACHE_PER_THREAD
+#pragma weak pthread_once
+#pragma weak pthread_key_create
+#pragma weak pthread_setspecific
+
+static thread_local struct dwarf_rs_cache tls_cache __attribute__((tls_model("initial-exec")));
+static thread_local int tls_cache_tracked;
+static thread_local int tls_cache_destroyed;
+static thread_local size_t tls_cache_dtor_count; /* Counts how many times our
+                                                    destructor has already
+                                                    been called. */
+static pthread_once_t tls_cache_once = PTHREAD_ONCE_INIT;
+static sig_atomic_t tls_cache_once_happen;
+static pthread_key_t tls_cache_key;
+
+/* Release the out-of-line storage of a thread's rs-cache.  The static
+   default storage stays usable for any unwinding done by destructors
+   running after us. */
+static void
+tls_cache_free (void *arg)
+{
+  struct dwarf_rs_cache *cache = arg;
+  if (++tls_cache_dtor_count < PTHREAD_DESTRUCTOR_ITERATIONS)
+  {
+    /* Not yet our turn to get destroyed. Re-install ourselves into the key. */
+    pthread_setspecific(tls_cache_key, cache);
+    Debug(5, "delayed freeing rs-cache %p (%zx to go)\n", cache,
+          PTHREAD_DESTRUCTOR_ITERATIONS - tls_cache_dtor_count);
+    return;
+  }
+  tls_cache_destroyed = 1;
+  tls_cache_tracked = 0;
+  dwarf_flush_rs_cache (cache, DWARF_DEFAULT_LOG_UNW_CACHE_SIZE, 0);
+  Debug(5, "freed rs-cache %p\n", cache);
+}
+
+static void
+tls_cache_init_once (void)
+{
+  if (pthread_key_create (&tls_cache_key, &tls_cache_free) == 0)
+    tls_cache_once_happen = 1;
+}
+
+/* Arrange for the out-of-line storage of the current thread's cache
+   to be released when the thread exits. */
+static void
+tls_cache_track (struct dwarf_rs_cache *cache)
+{
+  if (tls_cache_tracked || pthread_once == NULL)
+    return;
+  pthread_once (&tls_cache_once, &tls_cache_init_once);
+  if (!tls_cache_once_happen)
+    return;
+  pthread_setspecific (tls_cache_key, cache);
+  tls_cache_tracked = 1;
+}
+#endif
+
 static inline struct dwarf_rs_cache *
 get_rs_cache (unw_addr_space_t as, intrmask_t *saved_maskp)
 {
@@ -630,7 +811,6 @@ get_rs_cache (unw_addr_space_t as, intrmask_t *saved_maskp)
 #if defined(HAVE___CACHE_PER_THREAD) && HAVE___CACHE_PER_THREAD
   if (likely (caching == UNW_CACHE_PER_THREAD))
     {
-      static thread_local struct dwarf_rs_cache tls_cache __attribute__((tls_model("initial-exec")));
       Debug (16, "using TLS cache\n");
       cache = &tls_cache;
     }
@@ -646,10 +826,26 @@ get_rs_cache (unw_addr_space_t as, intrmask_t *saved_maskp)
   if ((atomic_load (&as->cache_generation) != atomic_load (&cache->generation))
        || !cache->hash)
     {
-      /* cache_size is only set in the global_cache, copy it over before flushing */
-      cache->log_size = as->global_cache.log_size;
-      if (dwarf_flush_rs_cache (cache) < 0)
-        return NULL;
+      /* cache_size is only set in the global_cache, and only meaningful
+         once that has been set up */
+      unsigned short log_size = as->global_cache.hash
+                                ? as->global_cache.log_size
+                                : DWARF_DEFAULT_LOG_UNW_CACHE_SIZE;
+      int shared = 1;
+#if defined(HAVE___CACHE_PER_THREAD) && HAVE___CACHE_PER_THREAD
+      if (cache == &tls_cache)
+        {
+          shared = 0;
+          /* An exiting thread would have no chance to free a new table. */
+          if (tls_cache_destroyed)
+            log_size = DWARF_DEFAULT_LOG_UNW_CACHE_SIZE;
+          else if (log_size != DWARF_DEFAULT_LOG_UNW_CACHE_SIZE)
+            tls_cache_track (cache);
+        }
+#endif
+      /* On allocation failure the cache falls back to its default
+         storage, which is still usable. */
+      dwarf_flush_rs_cache (cache, log_size, shared);
       atomic_store (&cache->generation, atomic_load (&as->cache_generation));
     }
 
@@ -673,25 +869,33 @@ hash (unw_word_t ip, unsigned short log_size)
   /* based on (sqrt(5)/2-1)*2^64 */
 # define magic  ((unw_word_t) 0x9e3779b97f4a7c16ULL)
 
+  /* Multiplicative hashing: the top log_size + 1 bits of the product
+     select the bucket.  */
   return (unw_hash_index_t) (ip * magic >> ((sizeof(unw_word_t) * 8) - (log_size + 1)));
 }
 
 static inline long
-cache_match (struct dwarf_rs_cache *cache, unsigned short index, unw_word_t ip)
+cache_match (struct dwarf_rs_cache *cache, uint32_t index, unw_word_t ip)
 {
-  return (cache->links[index].valid && (ip == cache->links[index].ip));
+  if (cache->links[index].valid && (ip == cache->links[index].ip))
+    {
+      cache->links[index].referenced = 1;
+      return 1;
+    }
+  return 0;
 }
 
 static dwarf_reg_state_t *
 rs_lookup (struct dwarf_rs_cache *cache, struct dwarf_cursor *c)
 {
-  unsigned short index;
+  uint32_t index;
   unw_word_t ip = c->ip;
 
   if (c->hint > 0)
     {
       index = c->hint - 1;
-      if (cache_match (cache, index, ip))
+      if (index < DWARF_UNW_CACHE_SIZE(cache->log_size)
+          && cache_match (cache, index, ip))
 	return &cache->buckets[index];
     }
 
@@ -705,19 +909,109 @@ rs_lookup (struct dwarf_rs_cache *cache, struct dwarf_cursor *c)
   return NULL;
 }
 
+/* Look up C->ip in the global cache of C->as without taking its lock.
+   Returns 1 after copying the register state into SR and updating the
+   cursor as find_reg_state() would, or 0 if the entry is not cached or
+   a writer got in the way; the caller then falls back to the locked
+   path.  Apart from the "referenced" byte of a hit, which only steers
+   replacement, nothing shared is written.  */
+static int
+rs_lookup_lockless (struct dwarf_cursor *c, dwarf_state_record_t *sr)
+{
+  struct dwarf_rs_cache *cache = &c->as->global_cache;
+  dwarf_reg_cache_entry_t *links;
+  dwarf_reg_state_t *buckets;
+  unw_hash_index_t *hash_table;
+  uint32_t seq, size, index, n, hint;
+  unsigned short log_size;
+  unw_word_t ip = c->ip;
+  int signal_frame;
+
+  seq = atomic_load_explicit (&cache->seq, memory_order_acquire);
+  if (seq & 1)
+    return 0;
+  if (atomic_load_explicit (&cache->generation, memory_order_relaxed)
+      != atomic_load_explicit (&c->as->cache_generation, memory_order_relaxed))
+    return 0;
+
+  /* The tables and their size must come from the same update.  Tables
+     replaced later stay mapped, so they are safe to walk.  */
+  log_size = cache->log_size;
+  hash_table = cache->hash;
+  buckets = cache->buckets;
+  links = cache->links;
+  atomic_thread_fence (memory_order_acquire);
+  if (atomic_load_explicit (&cache->seq, memory_order_relaxed) != seq
+      || !hash_table)
+    return 0;
+
+  size = DWARF_UNW_CACHE_SIZE(log_size);
+  index = c->hint - 1;
+  if (c->hint == 0 || index >= size
+      || !links[index].valid || links[index].ip != ip)
+    {
+      /* Bound the walk: a concurrent writer may relink the chains.  */
+      for (index = hash_table[hash (ip, log_size)], n = 0;
+           index < size && n < size;
+           index = links[index].coll_chain, ++n)
+        if (links[index].valid && links[index].ip == ip)
+          break;
+      if (index >= size || n >= size)
+        return 0;
+    }
+
+  memcpy (&sr->rs_current, &buckets[index], sizeof (sr->rs_current));
+  signal_frame = links[index].signal_frame;
+  hint = links[index].hint;
+  atomic_thread_fence (memory_order_acquire);
+  if (atomic_load_explicit (&cache->seq, memory_order_relaxed) != seq)
+    return 0;
+
+  if (!links[index].referenced)
+    links[index].referenced = 1;
+  c->use_prev_instr = ! signal_frame;
+  c->hint = hint;
+  c->prev_rs = index;
+  tdep_reuse_frame (c, signal_frame);
+  return 1;
+}
+
+/* Pick the rs to replace with the CLOCK algorithm: an rs that has been
+   looked up since the hand last passed it gets a second chance, so
+   frequently used entries survive a stream of one-off IPs.  */
+static inline uint32_t
+rs_victim (struct dwarf_rs_cache *cache)
+{
+  uint32_t mask = DWARF_UNW_CACHE_SIZE(cache->log_size) - 1;
+  uint32_t head, n;
+
+  for (n = 0; n <= mask; ++n)
+    {
+      head = cache->clock_hand;
+      cache->clock_hand = (head + 1) & mask;
+      if (!cache->links[head].referenced)
+        return head;
+      cache->links[head].referenced = 0;
+    }
+
+  /* Everything was referenced; the hand is back where it started.  */
+  head = cache->clock_hand;
+  cache->clock_hand = (head + 1) & mask;
+  return head;
+}
+
 static inline dwarf_reg_state_t *
 rs_new (struct dwarf_rs_cache *cache, struct dwarf_cursor * c)
 {
   unw_hash_index_t index;
-  unsigned short head;
+  uint32_t head;
 
-  head = cache->rr_head;
-  cache->rr_head = (head + 1) & (DWARF_UNW_CACHE_SIZE(cache->log_size) - 1);
+  head = rs_victim (cache);
 
   /* remove the old rs from the hash table (if it's there): */
   if (cache->links[head].ip)
     {
-      unsigned short *pindex;
+      uint32_t *pindex;
       for (pindex = &cache->hash[hash (cache->links[head].ip, cache->log_size)];
 	   *pindex < DWARF_UNW_CACHE_SIZE(cache->log_size);
 	   pindex = &cache->links[*pindex].coll_chain)
@@ -737,6 +1031,7 @@ rs_new (struct dwarf_rs_cache *cache, struct dwarf_cursor * c)
 
   cache->links[head].ip = c->ip;
   cache->links[head].valid = 1;
+  cache->links[head].referenced = 0;
   cache->links[head].signal_frame = tdep_cache_frame(c) ? 1 : 0;
   return cache->buckets + head;
 }
@@ -986,11 +1281,31 @@ find_reg_state (struct dwarf_cursor *c, dwarf_state_record_t *sr)
   int ret = 0;
   intrmask_t saved_mask;
 
+#ifndef UNW_REMOTE_ONLY
+  /* Objects with a compact unwind table need neither a CFI program
+     run nor the rs-cache.  */
+  if (dwarf_compact_table_lookup (c, sr))
+    {
+      unwi_stats_inc (c->as, UNWI_STAT_COMPACT_TABLE_HIT);
+      return 0;
+    }
+#endif
+
+  /* Hits in the global cache need neither its lock nor a change of the
+     signal mask.  */
+  if (c->as->caching_policy == UNW_CACHE_GLOBAL
+      && rs_lookup_lockless (c, sr))
+    {
+      unwi_stats_inc (c->as, UNWI_STAT_RS_CACHE_HIT);
+      return 0;
+    }
+
   if ((cache = get_rs_cache(c->as, &saved_mask)) &&
       (rs = rs_lookup(cache, c)))
     {
+      unwi_stats_inc (c->as, UNWI_STAT_RS_CACHE_HIT);
       /* update hint; no locking needed: single-word writes are atomic */
-      unsigned short index = (unsigned short) (rs - cache->buckets);
+      uint32_t index = (uint32_t) (rs - cache->buckets);
       c->use_prev_instr = ! cache->links[index].signal_frame;
       memcpy (&sr->rs_current, rs, sizeof (*rs));
     }
@@ -1007,6 +1322,7 @@ find_reg_state (struct dwarf_cursor *c, dwarf_state_record_t *sr)
 
       assert (!cache);
 
+      unwi_stats_inc (c->as, UNWI_STAT_RS_CACHE_MISS);
       ret = fetch_proc_info (c, c->ip);
       int next_use_prev_instr = c->use_prev_instr;
       if (ret >= 0)
@@ -1035,21 +1351,25 @@ find_reg_state (struct dwarf_cursor *c, dwarf_state_record_t *sr)
 	    }
 	  else
 	    {
+	      rs_cache_write_begin (cache);
 	      rs = rs_new (cache, c);
 	      cache->links[rs - cache->buckets].hint = 0;
 	      memcpy (rs, &sr->rs_current, sizeof(*rs));
+	      rs_cache_write_end (cache);
 	    }
 	}
     }
 
-  unsigned short index = -1;
+  uint32_t index = -1;
   if (cache)
     {
       if (rs)
 	{
-	  index = (unsigned short) (rs - cache->buckets);
+	  index = (uint32_t) (rs - cache->buckets);
 	  c->hint = cache->links[index].hint;
-	  cache->links[c->prev_rs].hint = index + 1;
+	  /* prev_rs may come from a cache of a different size.  */
+	  if (c->prev_rs < DWARF_UNW_CACHE_SIZE(cache->log_size))
+	    cache->links[c->prev_rs].hint = index + 1;
 	  c->prev_rs = index;
 	}
       if (ret >= 0)
@@ -1109,7 +1429,7 @@ dwarf_reg_states_dynamic_iterate(struct dwarf_cursor     *c UNUSED,
   return -UNW_ENOINFO;
 }
 
-static int
+HIDDEN int
 dwarf_reg_states_table_iterate(struct dwarf_cursor *c,
 			       unw_reg_states_callback cb,
 			       void *token)
@@ -131,6 +131,76 @@ elf_w (string_table) (const struct elf_image *ei, int section)
   return ei->image + str_shdr->sh_offset;
 }
 
+/**
+ * Locates the GNU build-id note of an ELF image
+ * @param[in]  ei    The ELF image
+ * @param[out] id    Set to point at the build-id bytes within the image
+ * @param[out] len   Set to the number of build-id bytes
+ *
+ * @returns 0 if a non-empty build-id was found, -1 otherwise
+ */
+static int
+elf_w (find_build_id) (const struct elf_image *ei, const uint8_t **id, size_t *len)
+{
+/*
+ * build-id is only available on GNU plaforms. So on non-GNU platforms this
+ * function just returns fail (-1).
+ */
+#if defined(ELF_NOTE_GNU) && defined(NT_GNU_BUILD_ID)
+  const Elf_W (Ehdr) *ehdr = ei->image;
+  const Elf_W (Phdr) *phdr;
+  unsigned i;
+
+  if (!elf_w (valid_object) (ei))
+    return -1;
+
+  phdr = (Elf_W (Phdr) *) ((uint8_t *) ehdr + ehdr->e_phoff);
+
+  for (i = 0; i < ehdr->e_phnum; ++i, phdr = (const Elf_W (Phdr) *) (((const uint8_t *) phdr) + ehdr->e_phentsize))
+    {
+      const uint8_t *notes;
+      const uint8_t *notes_end;
+
+      /* The build-id is in a note section */
+      if (phdr->p_type != PT_NOTE)
+        continue;
+
+      notes = elf_w (get_program_segment) (ei, phdr, &notes_end);
+
+      while(notes < notes_end)
+        {
+          /* See "man 5 elf" for notes about alignment in Nhdr */
+          const Elf_W(Nhdr) *nhdr = (const Elf_W(Nhdr) *) notes;
+          const Elf_W(Word) namesz = nhdr->n_namesz;
+          const Elf_W(Word) descsz = nhdr->n_descsz;
+          const Elf_W(Word) nameasz = UNW_ALIGN(namesz, 4); /* Aligned size */
+          const char *name = (const char *) (nhdr + 1);
+          const uint8_t *desc = (const uint8_t *) name + nameasz;
+
+          notes += sizeof(*nhdr) + nameasz + UNW_ALIGN(descsz, 4);
+
+          if ((namesz != sizeof(ELF_NOTE_GNU)) ||  /* Spec says must be "GNU" with a NULL */
+              (nhdr->n_type != NT_GNU_BUILD_ID) || /* Spec says must be NT_GNU_BUILD_ID   */
+              (strcmp(name, ELF_NOTE_GNU) != 0))   /* Must be "GNU" with NULL termination */
+            continue;
+
+          if (descsz == 0)
+            return -1;
+
+          *id = desc;
+          *len = descsz;
+          return 0;
+        }
+    }
+#else
+  (void) ei;
+  (void) id;
+  (void) len;
+#endif /* defined(ELF_NOTE_GNU) */
+
+  return -1;
+}
+
 static Elf_W (Off)
 dynamic_va_to_file_offset (Elf_W (Addr) va, Elf_W (Phdr) *phdr, size_t phnum)
 {
@@ -247,10 +317,10 @@ elf_w (lookup_symbol_from_dynamic) (unw_addr_space_t                    as UNUSE
 }
 
 static int
-elf_w (lookup_symbol_closeness) (unw_addr_space_t                    as UNUSED,
-                                 const struct symbol_lookup_context *context,
-                                 symtab_lookup_function_t            symtab_lookup,
-                                 void                               *data)
+elf_w (lookup_symbol_in_sections) (unw_addr_space_t                    as UNUSED,
+                                   const struct symbol_lookup_context *context,
+                                   symtab_lookup_function_t            symtab_lookup,
+                                   void                               *data)
 {
   struct elf_image *ei = context->ei;
   Elf_W (Addr) load_offset = context->load_offset;
@@ -262,9 +332,6 @@ elf_w (lookup_symbol_closeness) (unw_addr_space_t                    as UNUSED,
   int i, ret = -UNW_ENOINFO;
   char *strtab;
 
-  if (!elf_w (valid_object) (ei))
-    return -UNW_ENOINFO;
-
   shdr = elf_w (section_table) (ei);
   if (!shdr)
     return -UNW_ENOINFO;
@@ -326,6 +393,22 @@ elf_w (lookup_symbol_closeness) (unw_addr_space_t                    as UNUSED,
       shdr = (Elf_W (Shdr) *) (((char *) shdr) + ehdr->e_shentsize);
     }
 
+  return ret;
+}
+
+static int
+elf_w (lookup_symbol_closeness) (unw_addr_space_t                    as UNUSED,
+                                 const struct symbol_lookup_context *context,
+                                 symtab_lookup_function_t            symtab_lookup,
+                                 void                               *data)
+{
+  int ret;
+
+  if (!elf_w (valid_object) (context->ei))
+    return -UNW_ENOINFO;
+
+  ret = elf_w (lookup_symbol_in_sections) (as, context, symtab_lookup, data);
+
   /* If it wasn't found in the ELF symtab, check the synamic symtab. */
   if (ret == -UNW_ENOINFO)
     ret = elf_w (lookup_symbol_from_dynamic) (as, context, symtab_lookup, data);
@@ -333,6 +416,33 @@ elf_w (lookup_symbol_closeness) (unw_addr_space_t                    as UNUSED,
   return ret;
 }
 
+/**
+ * Copies a symbol name into a caller-supplied buffer
+ * @param[in]  sym_name  The NTCS symbol name
+ * @param[out] buf       Pointer to a buffer to contain a NTCS
+ * @param[in]  buf_len   Number of bytes in `buf`
+ *
+ * @returns -UNW_ENOMEM if the symbol name was truncated to fit the buffer
+ * @returns UNW_ESUCCESS otherwise
+ */
+static int
+elf_w (copy_symbol_name) (const char *sym_name, char *buf, size_t buf_len)
+{
+  size_t sym_name_len = strlen(sym_name);
+  int ret = UNW_ESUCCESS;
+
+  if (sym_name_len >= buf_len)
+    {
+      Debug (1, "symbol length %zu exceeds buffer of length %zu\n",
+             sym_name_len+1, buf_len);
+      sym_name_len = buf_len - 1; /* adjust for null terminator */
+      ret = -UNW_ENOMEM; /* indicate truncation of symbol name */
+    }
+  memcpy(buf, sym_name, sym_name_len);
+  buf[sym_name_len] = 0; /* null terminate */
+  return ret;
+}
+
 /**
  * Finds the symbol in the symtab for an IP
  * @param[in]  context  Information on the IP being looked up
@@ -357,22 +467,9 @@ elf_w (lookup_symbol_callback)(const struct symbol_lookup_context *context,
       if ((Elf_W (Addr)) (context->ip - syminfo->start_ip) < *(context->min_dist))
         {
           *(context->min_dist) = (Elf_W (Addr)) (context->ip - syminfo->start_ip);
-          char const* const sym_name     = syminfo->strtab + syminfo->sym->st_name;
-          size_t            sym_name_len = strlen(sym_name);
+          char const* const sym_name = syminfo->strtab + syminfo->sym->st_name;
           Debug (1, "candidate sym: %s@%#010lx\n", sym_name, syminfo->start_ip);
-          if (sym_name_len >= d->buf_len)
-            {
-              Debug (1, "symbol length %zu exceeds buffer of length %zu\n",
-                     sym_name_len+1, d->buf_len);
-              sym_name_len = d->buf_len - 1; /* adjust for null terminator */
-              ret = -UNW_ENOMEM; /* indicate truncation of symbol name */
-            }
-          else
-            {
-              ret = UNW_ESUCCESS;
-            }
-          memcpy(d->buf, sym_name, sym_name_len);
-          d->buf[sym_name_len] = 0; /* null terminate */
+          ret = elf_w (copy_symbol_name) (sym_name, d->buf, d->buf_len);
         }
     }
 
@@ -626,18 +723,616 @@ elf_w (extract_minidebuginfo) (struct elf_image *ei, struct elf_image *mdi)
 
   return 1;
 }
+
+/* Decompressing MiniDebugInfo is by far the most expensive part of a
+   symbol lookup, so decompressed images are kept in a small
+   process-wide cache.  An image is identified by the build-id of the
+   object it was extracted from or, failing that, by a hash of the
+   compressed data.  The total size of the cached images is bounded
+   by UNW_MINIDEBUGINFO_CACHE_SIZE bytes (taken from the environment,
+   0 disables the cache), and unused images are evicted in least
+   recently used order.  */
+
+#define MDI_CACHE_SLOTS         64
+#define MDI_CACHE_DEFAULT_SIZE  (64 * 1024 * 1024)
+
+struct mdi_cache_entry
+{
+  uint64_t          key;             /* hash of the build-id or the xz data */
+  size_t            compressed_len;
+  struct elf_image  mdi;             /* mdi.image == NULL for a free slot */
+  unsigned int      refcount;        /* number of users of the image */
+  uint64_t          last_use;
+};
+
+static define_lock (mdi_cache_lock);
+static struct mdi_cache_entry mdi_cache[MDI_CACHE_SLOTS];
+static size_t mdi_cache_size;       /* total size of the cached images */
+static size_t mdi_cache_budget;
+static int mdi_cache_budget_set;
+static uint64_t mdi_cache_clock;
+
+static uint64_t
+mdi_hash (uint64_t hash, const uint8_t *data, size_t len)
+{
+  /* FNV-1a */
+  while (len-- > 0)
+    {
+      hash ^= *data++;
+      hash *= 0x100000001b3ULL;
+    }
+  return hash;
+}
+
+/* Must be called while holding mdi_cache_lock. */
+static struct mdi_cache_entry *
+mdi_cache_find (uint64_t key, size_t compressed_len)
+{
+  unsigned int i;
+
+  for (i = 0; i < MDI_CACHE_SLOTS; ++i)
+    if (mdi_cache[i].mdi.image
+        && mdi_cache[i].key == key
+        && mdi_cache[i].compressed_len == compressed_len)
+      return &mdi_cache[i];
+  return NULL;
+}
+
+/* Must be called while holding mdi_cache_lock.  Evicts unused images
+   until SIZE more bytes fit the budget, and returns a free slot or NULL
+   if the images in use do not leave enough room.  */
+static struct mdi_cache_entry *
+mdi_cache_make_room (size_t size)
+{
+  struct mdi_cache_entry *free_slot, *lru;
+  unsigned int i;
+
+  if (!mdi_cache_budget_set)
+    {
+      const char *str = getenv ("UNW_MINIDEBUGINFO_CACHE_SIZE");
+
+      mdi_cache_budget = str ? strtoul (str, NULL, 0) : MDI_CACHE_DEFAULT_SIZE;
+      mdi_cache_budget_set = 1;
+    }
+
+  if (size > mdi_cache_budget)
+    return NULL;
+
+  for (;;)
+    {
+      free_slot = lru = NULL;
+      for (i = 0; i < MDI_CACHE_SLOTS; ++i)
+        {
+          if (!mdi_cache[i].mdi.image)
+            free_slot = &mdi_cache[i];
+          else if (mdi_cache[i].refcount == 0
+                   && (!lru || mdi_cache[i].last_use < lru->last_use))
+            lru = &mdi_cache[i];
+        }
+
+      if (free_slot && mdi_cache_size + size <= mdi_cache_budget)
+        return free_slot;
+      if (!lru)
+        return NULL;
+
+      Debug (3, "evicting MiniDebugInfo image %p (%zu bytes)\n",
+             lru->mdi.image, lru->mdi.size);
+      mi_munmap (lru->mdi.image, lru->mdi.size);
+      mdi_cache_size -= lru->mdi.size;
+      memset (lru, 0, sizeof (*lru));
+    }
+}
+
+/* Get the decompressed MiniDebugInfo image of EI, if it has one.  The
+   image must be released with elf_w (put_minidebuginfo).  Images that
+   have to be decompressed are counted in the statistics of AS.  */
+static int
+elf_w (get_minidebuginfo) (unw_addr_space_t as, struct elf_image *ei,
+                           struct elf_image *mdi)
+{
+  struct mdi_cache_entry *e;
+  Elf_W (Shdr) *shdr;
+  intrmask_t saved_mask;
+  const uint8_t *id;
+  size_t id_len, compressed_len;
+  uint64_t key = 0xcbf29ce484222325ULL;
+
+  shdr = elf_w (find_section) (ei, ".gnu_debugdata");
+  if (!shdr)
+    return 0;
+
+  compressed_len = shdr->sh_size;
+  if (elf_w (find_build_id) (ei, &id, &id_len) == 0)
+    key = mdi_hash (key, id, id_len);
+  else
+    key = mdi_hash (key, (uint8_t *) ei->image + shdr->sh_offset,
+                    compressed_len);
+
+  lock_acquire (&mdi_cache_lock, saved_mask);
+  e = mdi_cache_find (key, compressed_len);
+  if (e)
+    {
+      ++e->refcount;
+      e->last_use = ++mdi_cache_clock;
+      *mdi = e->mdi;
+    }
+  lock_release (&mdi_cache_lock, saved_mask);
+  if (e)
+    return 1;
+
+  if (!elf_w (extract_minidebuginfo) (ei, mdi))
+    return 0;
+  unwi_stats_inc (as, UNWI_STAT_MDI_DECOMPRESS);
+
+  lock_acquire (&mdi_cache_lock, saved_mask);
+  /* Another thread may have decompressed the same image meanwhile. */
+  e = mdi_cache_find (key, compressed_len);
+  if (e)
+    {
+      mi_munmap (mdi->image, mdi->size);
+      *mdi = e->mdi;
+    }
+  else if ((e = mdi_cache_make_room (mdi->size)) != NULL)
+    {
+      e->key = key;
+      e->compressed_len = compressed_len;
+      e->mdi = *mdi;
+      mdi_cache_size += mdi->size;
+    }
+  if (e)
+    {
+      ++e->refcount;
+      e->last_use = ++mdi_cache_clock;
+    }
+  lock_release (&mdi_cache_lock, saved_mask);
+
+  return 1;
+}
+
+static void
+elf_w (put_minidebuginfo) (struct elf_image *mdi)
+{
+  intrmask_t saved_mask;
+  unsigned int i;
+  int cached = 0;
+
+  lock_acquire (&mdi_cache_lock, saved_mask);
+  for (i = 0; i < MDI_CACHE_SLOTS; ++i)
+    if (mdi_cache[i].mdi.image == mdi->image)
+      {
+        --mdi_cache[i].refcount;
+        cached = 1;
+        break;
+      }
+  lock_release (&mdi_cache_lock, saved_mask);
+
+  /* Images that did not fit in the cache are owned by the caller. */
+  if (!cached)
+    mi_munmap (mdi->image, mdi->size);
+  mdi->image = NULL;
+}
 #else
 static int
-elf_w (extract_minidebuginfo) (struct elf_image *ei UNUSED, struct elf_image *mdi UNUSED)
+elf_w (get_minidebuginfo) (unw_addr_space_t as UNUSED,
+                           struct elf_image *ei UNUSED,
+                           struct elf_image *mdi UNUSED)
 {
   return 0;
 }
+
+static void
+elf_w (put_minidebuginfo) (struct elf_image *mdi UNUSED)
+{
+}
 #endif /* !HAVE_LZMA */
 
+/**
+ * A function symbol in a per-object symbol index.
+ */
+struct unw_symbol
+{
+  Elf_W (Addr)  start_ip;   /**< Start address of the function */
+  Elf_W (Addr)  end_ip;     /**< First address past the end of the function */
+  Elf_W (Addr)  cover_end;  /**< Highest `end_ip` of this and all preceding entries */
+  const char   *name;       /**< Pointer into the string table of the image */
+};
+
+/**
+ * The function symbols of one loaded object, sorted by start address.
+ *
+ * A table is built the first time an address inside the object is looked up
+ * and is then kept on the address space until the next unw_flush_cache().
+ * The ELF image (and any MiniDebugInfo image) stays mapped so the entries can
+ * point directly at the symbol names.  Once published, a table is never
+ * modified, so lookups need no locking; they only announce themselves with
+ * elf_w (enter_symbol_tables) so that a flushed table outlives its readers.
+ * Tables are freed through `release`, which belongs to the library that
+ * built them: libunwind-ptrace has its own copy of this file, and with it
+ * its own MiniDebugInfo cache.
+ */
+struct unw_symbol_table
+{
+  struct unw_symbol_table *next;
+  struct unw_symbol_table *retired;      /**< Flushed, waiting to be freed */
+  void                   (*release) (struct unw_symbol_table *);
+  pid_t                    pid;          /**< Process the object is mapped in */
+  Elf_W (Addr)             start;        /**< Address range covered by the table */
+  Elf_W (Addr)             end;
+  struct elf_image         ei;           /**< The (debuginfo) image of the object */
+  struct elf_image         mdi;          /**< Decompressed MiniDebugInfo, if any */
+  size_t                   mem_size;     /**< Size of the mapping holding the table */
+  size_t                   symbol_count;
+  struct unw_symbol        symbols[];
+};
+
+struct symbol_collect_data
+{
+  struct unw_symbol *symbols;  /**< Destination array, or NULL to only count */
+  size_t             count;    /**< Number of symbols collected so far */
+};
+
+static int
+elf_w (collect_symbol_callback) (const struct symbol_lookup_context *context UNUSED,
+                                 const struct symbol_info           *syminfo,
+                                 void                               *data)
+{
+  struct symbol_collect_data *d = data;
+
+  /* A zero-sized symbol can never contain an IP. */
+  if (syminfo->sym->st_size == 0)
+    return -UNW_ENOINFO;
+
+  if (d->symbols)
+    {
+      struct unw_symbol *s = &d->symbols[d->count];
+
+      s->start_ip = syminfo->start_ip;
+      s->end_ip = syminfo->start_ip + syminfo->sym->st_size;
+      s->cover_end = d->count;  /* symbol table order, see sort_symbols */
+      s->name = syminfo->strtab + syminfo->sym->st_name;
+    }
+  ++d->count;
+
+  /* Keep going until every symtab entry has been visited. */
+  return -UNW_ENOINFO;
+}
+
+static size_t
+elf_w (collect_symbols) (unw_addr_space_t as, struct elf_image *ei,
+                         Elf_W (Addr) load_offset, struct unw_symbol *symbols,
+                         size_t first, void *arg)
+{
+  struct symbol_lookup_context context =
+    {
+      .as = as,
+      .ei = ei,
+      .load_offset = load_offset,
+      .arg = arg,
+    };
+  struct symbol_collect_data data =
+    {
+      .symbols = symbols,
+      .count = first,
+    };
+
+  if (!elf_w (valid_object) (ei))
+    return 0;
+
+  elf_w (lookup_symbol_in_sections) (as, &context,
+                                     elf_w (collect_symbol_callback), &data);
+  if (data.count == first)
+    elf_w (lookup_symbol_from_dynamic) (as, &context,
+                                        elf_w (collect_symbol_callback), &data);
+
+  return data.count - first;
+}
+
+static inline int
+elf_w (symbol_before) (const struct unw_symbol *a, const struct unw_symbol *b)
+{
+  if (a->start_ip != b->start_ip)
+    return a->start_ip < b->start_ip;
+  return a->cover_end < b->cover_end;
+}
+
+static void
+elf_w (sift_down) (struct unw_symbol *symbols, size_t root, size_t n)
+{
+  for (;;)
+    {
+      size_t child = 2 * root + 1;
+      struct unw_symbol tmp;
+
+      if (child >= n)
+        return;
+      if (child + 1 < n
+          && elf_w (symbol_before) (&symbols[child], &symbols[child + 1]))
+        ++child;
+      if (!elf_w (symbol_before) (&symbols[root], &symbols[child]))
+        return;
+
+      tmp = symbols[root];
+      symbols[root] = symbols[child];
+      symbols[child] = tmp;
+      root = child;
+    }
+}
+
+/* Sort the symbols by start address.  Symbols sharing a start address
+   keep the order in which they were collected, which is carried in
+   `cover_end' until the sort is done: that way an alias is resolved
+   the same way a linear symtab scan would resolve it.  A heap sort is
+   used because it needs neither malloc() nor extra memory. */
+static void
+elf_w (sort_symbols) (struct unw_symbol *symbols, size_t n)
+{
+  Elf_W (Addr) cover_end = 0;
+  size_t i;
+
+  for (i = n / 2; i-- > 0;)
+    elf_w (sift_down) (symbols, i, n);
+
+  for (i = n; i-- > 1;)
+    {
+      struct unw_symbol tmp = symbols[0];
+      symbols[0] = symbols[i];
+      symbols[i] = tmp;
+      elf_w (sift_down) (symbols, 0, i);
+    }
+
+  for (i = 0; i < n; ++i)
+    {
+      if (symbols[i].end_ip > cover_end)
+        cover_end = symbols[i].end_ip;
+      symbols[i].cover_end = cover_end;
+    }
+}
+
+static void
+elf_w (free_symbol_table) (struct unw_symbol_table *t)
+{
+  if (t->mdi.image)
+    elf_w (put_minidebuginfo) (&t->mdi);
+  mi_munmap (t->ei.image, t->ei.size);
+  mi_munmap (t, t->mem_size);
+}
+
+static struct unw_symbol_table *
+elf_w (find_symbol_table) (struct unw_symbol_table *t, pid_t pid, unw_word_t ip)
+{
+  for (; t; t = t->next)
+    if (t->pid == pid && ip >= t->start && ip < t->end)
+      return t;
+  return NULL;
+}
+
+/* Build a symbol table for the object mapped at SEGBASE which contains
+   IP and publish it on the address space.  On success, the table takes
+   ownership of EI.  Returns NULL if the object cannot be indexed, in
+   which case EI is left untouched.  */
+static struct unw_symbol_table *
+elf_w (make_symbol_table) (unw_addr_space_t as, pid_t pid, struct elf_image *ei,
+                           unsigned long segbase, unw_word_t ip, void *arg)
+{
+  Elf_W (Addr) load_offset, end = 0;
+  Elf_W (Ehdr) *ehdr = ei->image;
+  Elf_W (Phdr) *phdr;
+  struct unw_symbol_table *t, *head, *other;
+  struct elf_image mdi = { NULL, 0 };
+  size_t count, mem_size;
+  int i;
+
+  if (!elf_w (valid_object) (ei))
+    return NULL;
+
+  /* The table covers the executable segment the IP was found in. */
+  load_offset = elf_w (get_load_offset) (ei, segbase);
+  phdr = (Elf_W (Phdr) *) ((char *) ei->image + ehdr->e_phoff);
+  for (i = 0; i < ehdr->e_phnum; ++i)
+    if (phdr[i].p_type == PT_LOAD && phdr[i].p_flags & PF_X)
+      {
+        end = load_offset + phdr[i].p_vaddr + phdr[i].p_memsz;
+        break;
+      }
+  if (ip < segbase || ip >= end)
+    return NULL;
+
+  if (!elf_w (get_minidebuginfo) (as, ei, &mdi))
+    mdi.image = NULL;
+
+  count = elf_w (collect_symbols) (as, ei, load_offset, NULL, 0, arg);
+  if (mdi.image)
+    count += elf_w (collect_symbols) (as, &mdi, load_offset, NULL, 0, arg);
+
+  mem_size = UNW_ALIGN (sizeof (*t) + count * sizeof (t->symbols[0]),
+                        unw_page_size);
+  GET_MEMORY (t, mem_size);
+  if (!t)
+    {
+      if (mdi.image)
+        elf_w (put_minidebuginfo) (&mdi);
+      return NULL;
+    }
+
+  t->release = elf_w (free_symbol_table);
+  t->pid = pid;
+  t->start = segbase;
+  t->end = end;
+  t->ei = *ei;
+  t->mdi = mdi;
+  t->mem_size = mem_size;
+
+  /* Symbols from the image proper are collected first, so they win over
+     MiniDebugInfo symbols at the same address. */
+  t->symbol_count = elf_w (collect_symbols) (as, ei, load_offset,
+                                             t->symbols, 0, arg);
+  if (mdi.image)
+    t->symbol_count += elf_w (collect_symbols) (as, &mdi, load_offset,
+                                                t->symbols, t->symbol_count,
+                                                arg);
+  elf_w (sort_symbols) (t->symbols, t->symbol_count);
+
+  Debug (3, "indexed %zu symbols for %lx-%lx\n", t->symbol_count,
+         (long) t->start, (long) t->end);
+
+  head = atomic_load (&as->symbol_tables);
+  do
+    {
+      /* Another thread may have indexed the same object meanwhile. */
+      other = elf_w (find_symbol_table) (head, pid, ip);
+      if (other)
+        {
+          elf_w (free_symbol_table) (t);
+          return other;
+        }
+      t->next = head;
+    }
+  while (!atomic_compare_exchange_weak (&as->symbol_tables, &head, t));
+
+  return t;
+}
+
+/* Return the number of symbols starting at or below IP.  */
+static size_t
+elf_w (count_symbols_below) (const struct unw_symbol_table *t, unw_word_t ip)
+{
+  size_t lo = 0, hi = t->symbol_count;
+
+  while (lo < hi)
+    {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (t->symbols[mid].start_ip <= ip)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+/* Find the symbol closest to IP, i.e. the one with the highest start
+   address among those containing IP.  LO is the number of symbols
+   starting at or below IP.  */
+static const struct unw_symbol *
+elf_w (closest_symbol) (const struct unw_symbol_table *t, unw_word_t ip,
+                        size_t lo)
+{
+  const struct unw_symbol *best = NULL;
+
+  /* Walk back over symbols starting at or below IP.  Before a match is
+     found, `cover_end' bounds the search; afterwards only aliases of the
+     match remain of interest. */
+  while (lo-- > 0)
+    {
+      const struct unw_symbol *s = &t->symbols[lo];
+
+      if (best ? s->start_ip != best->start_ip : s->cover_end <= ip)
+        break;
+      if (ip < s->end_ip)
+        best = s;
+    }
+
+  if (best && ip - best->start_ip >= t->ei.size)
+    return NULL;
+  return best;
+}
+
+static const struct unw_symbol *
+elf_w (lookup_symbol_in_table) (const struct unw_symbol_table *t, unw_word_t ip)
+{
+  return elf_w (closest_symbol) (t, ip, elf_w (count_symbols_below) (t, ip));
+}
+
+/* Tables taken off an address space by a flush may still be walked by
+   lookups that found them before; those are counted in the address
+   space's symbol_table_readers.  The flushed tables are retired and
+   freed by a later flush once no lookup is active.  Flushes are
+   serialised by symbol_tables_lock, so a table on the retired list can
+   no longer be reached by a lookup that starts after the check.  */
+static define_lock (symbol_tables_lock);
+
+/* Bracket any use of the tables of AS, or of pointers into them.  */
+HIDDEN void
+elf_w (enter_symbol_tables) (unw_addr_space_t as)
+{
+  atomic_fetch_add (&as->symbol_table_readers, 1);
+}
+
+HIDDEN void
+elf_w (leave_symbol_tables) (unw_addr_space_t as)
+{
+  atomic_fetch_sub (&as->symbol_table_readers, 1);
+}
+
+HIDDEN void
+elf_w (flush_symbol_tables) (unw_addr_space_t as)
+{
+  struct unw_symbol_table *t, *n;
+  intrmask_t saved_mask;
+
+  lock_acquire (&symbol_tables_lock, saved_mask);
+  for (t = atomic_exchange (&as->symbol_tables, NULL); t; t = t->next)
+    {
+      t->retired = as->retired_symbol_tables;
+      as->retired_symbol_tables = t;
+    }
+  if (atomic_load (&as->symbol_table_readers) == 0)
+    {
+      for (t = as->retired_symbol_tables; t; t = n)
+        {
+          n = t->retired;
+          (*t->release) (t);
+        }
+      as->retired_symbol_tables = NULL;
+    }
+  lock_release (&symbol_tables_lock, saved_mask);
+}
+
+/* Look IP up in the symbol tables already cached on AS for the process
+   HINT->pid, for callers which resolve many addresses in ascending order.  HINT remembers the
+   table and the position reached by the previous call, so that the
+   addresses falling into one object are resolved in a single forward
+   pass over its symbols.  Returns 0 and sets *NAME and *OFFP if a
+   symbol contains IP, -UNW_ENOINFO if the covering table has none, or
+   1 if no table covers IP; the caller then has to look IP up itself.
+   The caller has to be inside elf_w (enter_symbol_tables) for as long
+   as it uses HINT or *NAME.  */
+
+HIDDEN int
+elf_w (lookup_symbol_cached) (unw_addr_space_t as, unw_word_t ip,
+                              struct elf_w (symbol_hint) *hint,
+                              const char **name, unw_word_t *offp)
+{
+  const struct unw_symbol_table *t = hint->table;
+  const struct unw_symbol *s;
+  size_t pos = hint->pos;
+
+  if (!t || ip < t->start || ip >= t->end
+      || (pos > 0 && t->symbols[pos - 1].start_ip > ip))
+    {
+      t = elf_w (find_symbol_table) (atomic_load (&as->symbol_tables),
+                                     hint->pid, ip);
+      if (!t)
+        return 1;
+      pos = elf_w (count_symbols_below) (t, ip);
+    }
+  else
+    while (pos < t->symbol_count && t->symbols[pos].start_ip <= ip)
+      ++pos;
+
+  hint->table = t;
+  hint->pos = pos;
+
+  s = elf_w (closest_symbol) (t, ip, pos);
+  if (!s)
+    return -UNW_ENOINFO;
+  *name = s->name;
+  *offp = ip - s->start_ip;
+  return 0;
+}
+
 /* Find the ELF image that contains IP and return the "closest"
-   procedure name, if there is one.  With some caching, this could be
-   sped up greatly, but until an application materializes that's
-   sensitive to the performance of this routine, why bother...  */
+   procedure name, if there is one.  */
 
 HIDDEN int
 elf_w (get_proc_name_in_image) (unw_addr_space_t as, struct elf_image *ei,
@@ -655,7 +1350,7 @@ elf_w (get_proc_name_in_image) (unw_addr_space_t as, struct elf_image *ei,
   /* If the ELF image has MiniDebugInfo embedded in it, look up the symbol in
      there as well and replace the previously found if it is closer. */
   struct elf_image mdi;
-  if (elf_w (extract_minidebuginfo) (ei, &mdi))
+  if (elf_w (get_minidebuginfo) (as, ei, &mdi))
     {
       int ret_mdi = elf_w (lookup_symbol) (as, ip, &mdi, load_offset, buf,
                                            buf_len, &min_dist, arg);
@@ -666,7 +1361,7 @@ elf_w (get_proc_name_in_image) (unw_addr_space_t as, struct elf_image *ei,
           ret = ret_mdi;
         }
 
-      mi_munmap (mdi.image, mdi.size);
+      elf_w (put_minidebuginfo) (&mdi);
     }
 
   if (min_dist >= ei->size)
@@ -676,23 +1371,64 @@ elf_w (get_proc_name_in_image) (unw_addr_space_t as, struct elf_image *ei,
   return ret;
 }
 
+static int
+elf_w (get_proc_name_in_table) (const struct unw_symbol_table *t, unw_word_t ip,
+                                char *buf, size_t buf_len, unw_word_t *offp)
+{
+  const struct unw_symbol *s = elf_w (lookup_symbol_in_table) (t, ip);
+
+  if (!s)
+    return -UNW_ENOINFO;
+  if (offp)
+    *offp = ip - s->start_ip;
+  return elf_w (copy_symbol_name) (s->name, buf, buf_len);
+}
+
+/* Unless caching is disabled, symbol lookups are served from a symbol
+   index kept on the address space, so that only the first lookup in
+   each object has to read the process maps and scan its symtabs.  */
+
 HIDDEN int
 elf_w (get_proc_name) (unw_addr_space_t as, pid_t pid, unw_word_t ip,
                        char *buf, size_t buf_len, unw_word_t *offp, void *arg)
 {
   unsigned long segbase, mapoff;
   struct elf_image ei;
+  struct unw_symbol_table *t;
   int ret;
   char file[PATH_MAX];
 
+  if (as->caching_policy != UNW_CACHE_NONE)
+    {
+      elf_w (enter_symbol_tables) (as);
+      t = elf_w (find_symbol_table) (atomic_load (&as->symbol_tables), pid, ip);
+      if (t)
+        ret = elf_w (get_proc_name_in_table) (t, ip, buf, buf_len, offp);
+      elf_w (leave_symbol_tables) (as);
+      if (t)
+        return ret;
+    }
+
   ret = tdep_get_elf_image (as, &ei, pid, ip, &segbase, &mapoff, file, PATH_MAX, arg);
   if (ret < 0)
     return ret;
+  unwi_stats_inc (as, UNWI_STAT_ELF_MAP);
 
   ret = elf_w (load_debuginfo) (file, &ei, 1);
   if (ret < 0)
     return ret;
 
+  if (as->caching_policy != UNW_CACHE_NONE)
+    {
+      elf_w (enter_symbol_tables) (as);
+      t = elf_w (make_symbol_table) (as, pid, &ei, segbase, ip, arg);
+      if (t)
+        ret = elf_w (get_proc_name_in_table) (t, ip, buf, buf_len, offp);
+      elf_w (leave_symbol_tables) (as);
+      if (t)
+        return ret;
+    }
+
   ret = elf_w (get_proc_name_in_image) (as, &ei, segbase, ip, buf, buf_len, offp, arg);
 
   mi_munmap (ei.image, ei.size);
@@ -717,7 +1453,7 @@ elf_w (get_proc_ip_range_in_image) (unw_addr_space_t as, struct elf_image *ei,
   /* If the ELF image has MiniDebugInfo embedded in it, look up the symbol in
      there as well and replace the previously found if it is closer. */
   struct elf_image mdi;
-  if (elf_w (extract_minidebuginfo) (ei, &mdi))
+  if (elf_w (get_minidebuginfo) (as, ei, &mdi))
     {
       int ret_mdi = elf_w (lookup_ip_range) (as, ip, &mdi, load_offset, start,
                                              end, &min_dist, arg);
@@ -728,7 +1464,7 @@ elf_w (get_proc_ip_range_in_image) (unw_addr_space_t as, struct elf_image *ei,
           ret = ret_mdi;
         }
 
-      mi_munmap (mdi.image, mdi.size);
+      elf_w (put_minidebuginfo) (&mdi);
     }
 
   if (min_dist >= ei->size)
@@ -736,23 +1472,60 @@ elf_w (get_proc_ip_range_in_image) (unw_addr_space_t as, struct elf_image *ei,
   return ret;
 }
 
+static int
+elf_w (get_proc_ip_range_in_table) (const struct unw_symbol_table *t, unw_word_t ip,
+                                    unw_word_t *start, unw_word_t *end)
+{
+  const struct unw_symbol *s = elf_w (lookup_symbol_in_table) (t, ip);
+
+  if (!s)
+    return -UNW_ENOINFO;
+  *start = s->start_ip;
+  *end = s->end_ip;
+  return UNW_ESUCCESS;
+}
+
 HIDDEN int
 elf_w (get_proc_ip_range) (unw_addr_space_t as, pid_t pid, unw_word_t ip,
                            unw_word_t *start, unw_word_t *end, void *arg)
 {
   unsigned long segbase, mapoff;
   struct elf_image ei;
+  struct unw_symbol_table *t;
   int ret;
   char file[PATH_MAX];
 
+  if (as->caching_policy != UNW_CACHE_NONE)
+    {
+      elf_w (enter_symbol_tables) (as);
+      t = elf_w (find_symbol_table) (atomic_load (&as->symbol_tables), pid, ip);
+      if (t)
+        ret = elf_w (get_proc_ip_range_in_table) (t, ip, start, end);
+      elf_w (leave_symbol_tables) (as);
+      if (t)
+        return ret;
+    }
+
   ret = tdep_get_elf_image (as, &ei, pid, ip, &segbase, &mapoff, file, PATH_MAX, arg);
   if (ret < 0)
     return ret;
+  unwi_stats_inc (as, UNWI_STAT_ELF_MAP);
 
   ret = elf_w (load_debuginfo) (file, &ei, 1);
   if (ret < 0)
     return ret;
 
+  if (as->caching_policy != UNW_CACHE_NONE)
+    {
+      elf_w (enter_symbol_tables) (as);
+      t = elf_w (make_symbol_table) (as, pid, &ei, segbase, ip, arg);
+      if (t)
+        ret = elf_w (get_proc_ip_range_in_table) (t, ip, start, end);
+      elf_w (leave_symbol_tables) (as);
+      if (t)
+        return ret;
+    }
+
   ret = elf_w (get_proc_ip_range_in_image) (as, &ei, segbase, ip, start, end, arg);
 
   mi_munmap (ei.image, ei.size);
@@ -839,75 +1612,32 @@ elf_w (add_hex_byte) (char *str, uint8_t byte)
 static int
 elf_w (find_build_id_path) (const struct elf_image *ei, char *path, unsigned path_len)
 {
-/*
- * build-id is only available on GNU plaforms. So on non-GNU platforms this
- * function just returns fail (-1).
- */
-#if defined(ELF_NOTE_GNU) && defined(NT_GNU_BUILD_ID)
-  const Elf_W (Ehdr) *ehdr = ei->image;
-  const Elf_W (Phdr) *phdr;
-  unsigned i;
+  const char prefix[] = "/usr/lib/debug/.build-id/";
+  const uint8_t *desc;
+  size_t descsz, j;
 
-  if (!elf_w (valid_object) (ei))
+  if (elf_w (find_build_id) (ei, &desc, &descsz) < 0)
     return -1;
 
-  phdr = (Elf_W (Phdr) *) ((uint8_t *) ehdr + ehdr->e_phoff);
-
-  for (i = 0; i < ehdr->e_phnum; ++i, phdr = (const Elf_W (Phdr) *) (((const uint8_t *) phdr) + ehdr->e_phentsize))
-    {
-      const uint8_t *notes;
-      const uint8_t *notes_end;
-
-      /* The build-id is in a note section */
-      if (phdr->p_type != PT_NOTE)
-        continue;
-
-      notes = elf_w (get_program_segment) (ei, phdr, &notes_end);
-
-      while(notes < notes_end)
-        {
-          const char prefix[] = "/usr/lib/debug/.build-id/";
-
-          /* See "man 5 elf" for notes about alignment in Nhdr */
-          const Elf_W(Nhdr) *nhdr = (const Elf_W(Nhdr) *) notes;
-          const Elf_W(Word) namesz = nhdr->n_namesz;
-          const Elf_W(Word) descsz = nhdr->n_descsz;
-          const Elf_W(Word) nameasz = UNW_ALIGN(namesz, 4); /* Aligned size */
-          const char *name = (const char *) (nhdr + 1);
-          const uint8_t *desc = (const uint8_t *) name + nameasz;
-          unsigned j;
-
-          notes += sizeof(*nhdr) + nameasz + UNW_ALIGN(descsz, 4);
-
-          if ((namesz != sizeof(ELF_NOTE_GNU)) ||  /* Spec says must be "GNU" with a NULL */
-              (nhdr->n_type != NT_GNU_BUILD_ID) || /* Spec says must be NT_GNU_BUILD_ID   */
-              (strcmp(name, ELF_NOTE_GNU) != 0))   /* Must be "GNU" with NULL termination */
-            continue;
-
-          /* Validate that we have enough space */
-          if (path_len < (sizeof(prefix) +     /* Path prefix inc NULL */
-                          2 +                  /* Subdirectory         */
-                          1 +                  /* Directory separator  */
-                          (2 * (descsz - 1)) + /* Leaf filename        */
-                          6))                  /* .debug extension     */
-            return -1;
-
-          memcpy(path, prefix, sizeof(prefix));
+  /* Validate that we have enough space */
+  if (path_len < (sizeof(prefix) +     /* Path prefix inc NULL */
+                  2 +                  /* Subdirectory         */
+                  1 +                  /* Directory separator  */
+                  (2 * (descsz - 1)) + /* Leaf filename        */
+                  6))                  /* .debug extension     */
+    return -1;
 
-          path = elf_w (add_hex_byte) (path + sizeof(prefix) - 1, *desc);
-          *path++ = '/';
+  memcpy(path, prefix, sizeof(prefix));
 
-          for(j = 1, ++desc; j < descsz; ++j, ++desc)
-            path = elf_w (add_hex_byte) (path, *desc);
+  path = elf_w (add_hex_byte) (path + sizeof(prefix) - 1, *desc);
+  *path++ = '/';
 
-          strcat(path, ".debug");
+  for(j = 1, ++desc; j < descsz; ++j, ++desc)
+    path = elf_w (add_hex_byte) (path, *desc);
 
-          return 0;
-        }
-    }
-#endif /* defined(ELF_NOTE_GNU) */
+  strcat(path, ".debug");
 
-  return -1;
+  return 0;
 }
 
 /* Load a debug section, following .gnu_debuglink if appropriate
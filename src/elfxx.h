@@ -66,6 +66,23 @@ extern int elf_w (get_proc_ip_range_in_image) (unw_addr_space_t as, struct elf_i
 extern int elf_w (get_elf_filename) (unw_addr_space_t as, pid_t pid, unw_word_t ip,
                                      char *buf, size_t buf_len, unw_word_t *offp, void *arg);
 
+extern void elf_w (flush_symbol_tables) (unw_addr_space_t as);
+extern void elf_w (enter_symbol_tables) (unw_addr_space_t as);
+extern void elf_w (leave_symbol_tables) (unw_addr_space_t as);
+
+/* Position of a batch of ascending lookups in the cached symbol tables
+   of process PID. */
+struct elf_w (symbol_hint)
+  {
+    const struct unw_symbol_table *table;
+    size_t pos;
+    pid_t pid;
+  };
+
+extern int elf_w (lookup_symbol_cached) (unw_addr_space_t as, unw_word_t ip,
+                                         struct elf_w (symbol_hint) *hint,
+                                         const char **name, unw_word_t *offp);
+
 extern Elf_W (Shdr)* elf_w (find_section) (const struct elf_image *ei, const char* secname);
 extern int elf_w (load_debuginfo) (const char* file, struct elf_image *ei, int is_local);
 
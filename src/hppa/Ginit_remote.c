@@ -43,6 +43,7 @@ unw_init_remote (unw_cursor_t *cursor, unw_addr_space_t as, void *as_arg)
 
   Debug (1, "(cursor=%p)\n", c);
 
+  atomic_fetch_add (&as->init_generation, 1);
   c->dwarf.as = as;
   if (as == unw_local_addr_space)
     {
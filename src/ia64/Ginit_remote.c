@@ -53,6 +53,7 @@ unw_init_remote (unw_cursor_t *cursor, unw_addr_space_t as, void *as_arg)
        able to use the context returned by getcontext() et al.  */
     return unw_init_local (cursor, as_arg);
 
+  atomic_fetch_add (&as->init_generation, 1);
   c->as = as;
   c->as_arg = as_arg;
 
@@ -49,6 +49,8 @@ loongarch64_handle_signal_frame (unw_cursor_t *cursor)
   c->sigcontext_sp = c->dwarf.cfa;
   c->sigcontext_pc = c->dwarf.ip;
   c->sigcontext_format = LOONGARCH64_SCF_LINUX_RT_SIGFRAME;
+  c->frame_info.frame_type = UNW_LOONGARCH64_FRAME_SIGRETURN;
+  c->frame_info.cfa_reg_offset = sc_addr - sp_addr;
 
   for (i = 0; i < DWARF_NUM_PRESERVED_REGS; ++i)
     c->dwarf.loc[i] = DWARF_NULL_LOC;
@@ -31,6 +31,11 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 
 #include "libunwind_i.h"
 
+/* DWARF column numbers for LoongArch64: */
+#define RA      1
+#define SP      3
+#define FP      22
+
 #define loongarch64_lock                       UNW_OBJ(lock)
 #define loongarch64_local_resume               UNW_OBJ(local_resume)
 #define loongarch64_local_addr_space_init      UNW_OBJ(local_addr_space_init)
@@ -40,4 +45,16 @@ extern int loongarch64_local_resume (unw_addr_space_t as, unw_cursor_t *cursor,
 
 extern void loongarch64_local_addr_space_init (void);
 
+/* By-pass calls to access_mem() when known to be safe. */
+#ifdef UNW_LOCAL_ONLY
+# undef ACCESS_MEM_FAST
+# define ACCESS_MEM_FAST(ret,validate,cur,addr,to)                     \
+  do {                                                                 \
+    if (unlikely(validate))                                            \
+      (ret) = dwarf_get ((cur), DWARF_MEM_LOC ((cur), (addr)), &(to)); \
+    else                                                               \
+      (ret) = 0, (to) = *(unw_word_t *)(addr);                         \
+  } while (0)
+#endif
+
 #endif /* unwind_i_h */
@@ -33,8 +33,20 @@ unw_address_is_valid(UNUSED unw_word_t addr, UNUSED size_t len)
   return false;
 }
 
+void
+unw_address_validator_flush (UNUSED unw_addr_space_t as)
+{
+}
+
 #else /* !UNW_REMOTE_ONLY */
 
+#ifdef __linux__
+# include "os-linux.h"
+#endif
+#ifdef HAVE__DL_FIND_OBJECT
+# include <dlfcn.h>
+#endif
+
 /* Each thread manages its own pipe so concurrent callers (including signal
  * handlers) never race on closing or reopening another thread's fds. */
 static thread_local int _mem_validate_pipe[2] = {-1, -1};
@@ -232,6 +244,387 @@ _cache_valid_mem(unw_word_t page_addr)
 #endif
 
 
+#ifdef __linux__
+/*
+ * Ranges known to stay readable, taken from /proc/self/maps, so that
+ * validating stack and text addresses needs no system call at all.
+ *
+ * The process-wide snapshot holds the mappings of loaded objects (files with
+ * an executable mapping) and the main thread's stack.  It is built on the
+ * first miss, published through an atomic pointer and dropped by
+ * unw_flush_cache() of the local address space.  Objects may be unloaded in
+ * between, so each object range remembers the loader's link map for it and
+ * is only trusted while _dl_find_object() still reports that link map there.
+ * Without _dl_find_object() only the loader's lock would tell, which is not
+ * safe to take in a signal handler, so the snapshot then holds the main
+ * thread's stack alone.
+ * Dropped snapshots are unmapped once no lookup is using them.
+ *
+ * Each thread remembers the part of the mapping holding its own stack that
+ * stays mapped for as long as the thread runs.
+ */
+struct valid_ranges
+  {
+    size_t count;
+    size_t mem_size;
+    struct valid_ranges *next;          /* on valid_ranges_retired */
+    struct
+      {
+        unw_word_t start;
+        unw_word_t end;
+#ifdef HAVE__DL_FIND_OBJECT
+        const struct link_map *link_map;        /* owner, NULL for [stack] */
+        unw_word_t map_start;                   /* its dlfo_map_start */
+#endif
+      }
+    range[];
+  };
+
+enum { VALID_RANGES_MIN = 64 };
+
+static _Atomic (struct valid_ranges *) valid_ranges;
+static _Atomic unsigned long valid_ranges_readers;
+static struct valid_ranges *valid_ranges_retired;
+static define_lock (valid_ranges_lock);
+
+static thread_local unw_word_t stack_lo;
+static thread_local unw_word_t stack_hi;
+static thread_local int stack_scanned;
+
+
+static int
+_valid_ranges_add (struct valid_ranges **vrp, unw_word_t start, unw_word_t end)
+{
+  struct valid_ranges *vr = *vrp, *n;
+  size_t cap = 0, mem_size;
+
+  if (vr)
+    cap = (vr->mem_size - sizeof (*vr)) / sizeof (vr->range[0]);
+  if (!vr || vr->count == cap)
+    {
+      mem_size = sizeof (*n) + (cap ? 2 * cap : VALID_RANGES_MIN)
+                               * sizeof (n->range[0]);
+      GET_MEMORY (n, mem_size);
+      if (!n)
+        return -1;
+      n->count = 0;
+      n->mem_size = mem_size;
+      n->next = NULL;
+      if (vr)
+        {
+          n->count = vr->count;
+          memcpy (n->range, vr->range, vr->count * sizeof (vr->range[0]));
+          mi_munmap (vr, vr->mem_size);
+        }
+      *vrp = vr = n;
+    }
+  vr->range[vr->count].start = start;
+  vr->range[vr->count].end = end;
+  ++vr->count;
+  return 0;
+}
+
+
+static uint64_t
+_path_hash (const char *path)
+{
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  while (*path)
+    hash = (hash ^ (unsigned char) *path++) * 0x100000001b3ULL;
+  return hash;
+}
+
+
+/**
+ * Narrows the readable mapping from @p low to @p high that holds the stack
+ * pointer @p sp to the part belonging to the calling thread's stack, and
+ * stores it in @p sp_lo and @p sp_hi.
+ *
+ * The kernel never merges the main thread's [stack] with other mappings.
+ * Other stacks are plain anonymous memory, which is merged with adjacent
+ * anonymous mappings of the same protection, and those may be unmapped
+ * while the thread runs.  Such a stack is only trusted if the thread's own
+ * static TLS, which the thread library places at the top of the stack block
+ * above every frame, lies in the mapping; it is trusted up to there.  If a
+ * readable mapping ends right at @p low, there is no guard page below the
+ * stack and it is only trusted from the page holding @p sp.
+ */
+static void
+_thread_stack_range (const char *path, unw_word_t low, unw_word_t high,
+                     bool guarded, unw_word_t sp,
+                     unw_word_t *sp_lo, unw_word_t *sp_hi)
+{
+  unw_word_t tls = (unw_word_t) &stack_scanned;
+
+  if (strcmp (path, "[stack]") == 0)
+    {
+      *sp_lo = low;
+      *sp_hi = high;
+    }
+  else if (sp < tls && tls < high)
+    {
+      *sp_lo = guarded ? low : unw_page_start (sp);
+      *sp_hi = tls;
+    }
+}
+
+
+/**
+ * Read /proc/self/maps once.  Collects the snapshot ranges into @p vrp if
+ * it is not NULL, and the calling thread's stack around @p sp into
+ * @p sp_lo and @p sp_hi.
+ */
+static void
+_scan_maps (struct valid_ranges **vrp, unw_word_t sp,
+            unw_word_t *sp_lo, unw_word_t *sp_hi)
+{
+  struct map_iterator mi;
+  unsigned long low, high, offset, flags, prev_high = 0;
+  uint64_t hash, object_hash = 0;
+  size_t object_start = 0;
+  int object_exec = 0, is_stack, prev_readable = 0, failed = 0;
+#ifdef HAVE__DL_FIND_OBJECT
+  struct dl_find_object dlfo;
+#endif
+
+  if (maps_init (&mi, getpid ()) < 0)
+    return;
+
+  while (maps_next (&mi, &low, &high, &offset, &flags))
+    {
+      int readable = (flags & PROT_READ) != 0;
+      int guarded = !prev_readable || prev_high != low;
+
+      prev_readable = readable;
+      prev_high = high;
+      if (!readable)
+        continue;
+      if (sp >= low && sp < high)
+        _thread_stack_range (mi.path, low, high, guarded, sp, sp_lo, sp_hi);
+      if (!vrp || failed)
+        continue;
+
+      /* Consecutive mappings of the same file form one object; keep its
+         ranges only if one of them is executable.  */
+      is_stack = strcmp (mi.path, "[stack]") == 0;
+      hash = is_stack ? 1 : mi.path[0] == '/' ? _path_hash (mi.path) : 0;
+      if (hash != object_hash)
+        {
+          if (!object_exec && *vrp)
+            (*vrp)->count = object_start;
+          object_start = *vrp ? (*vrp)->count : 0;
+          object_hash = hash;
+          object_exec = 0;
+        }
+      if (!hash)
+        continue;
+#ifdef HAVE__DL_FIND_OBJECT
+      /* Only mappings of the loader's objects can be checked later. */
+      if (is_stack)
+        dlfo.dlfo_link_map = NULL;
+      else if (_dl_find_object ((void *) low, &dlfo) != 0)
+        continue;
+#else
+      if (!is_stack)
+        continue;
+#endif
+      if ((flags & PROT_EXEC) || is_stack)
+        object_exec = 1;
+      if (*vrp && (*vrp)->count > object_start
+          && (*vrp)->range[(*vrp)->count - 1].end == low
+#ifdef HAVE__DL_FIND_OBJECT
+          && (*vrp)->range[(*vrp)->count - 1].link_map == dlfo.dlfo_link_map
+#endif
+          )
+        (*vrp)->range[(*vrp)->count - 1].end = high;
+      else if (_valid_ranges_add (vrp, low, high) < 0)
+        failed = 1;
+#ifdef HAVE__DL_FIND_OBJECT
+      else
+        {
+          (*vrp)->range[(*vrp)->count - 1].link_map = dlfo.dlfo_link_map;
+          (*vrp)->range[(*vrp)->count - 1].map_start
+            = is_stack ? 0 : (unw_word_t) dlfo.dlfo_map_start;
+        }
+#endif
+    }
+  if (vrp && !object_exec && *vrp)
+    (*vrp)->count = object_start;
+  maps_close (&mi);
+
+  if (failed && *vrp)
+    {
+      mi_munmap (*vrp, (*vrp)->mem_size);
+      *vrp = NULL;
+    }
+}
+
+
+/* An alternate signal stack may be freed while the thread lives. */
+static bool
+_on_alt_stack (void)
+{
+#ifdef HAVE_SIGALTSTACK
+  stack_t ss;
+
+  return sigaltstack (NULL, &ss) == 0 && (ss.ss_flags & SS_ONSTACK);
+#else
+  return false;
+#endif
+}
+
+
+#ifdef HAVE__DL_FIND_OBJECT
+/* Is range @p i of @p vr still mapped by the object it was taken from? */
+static bool
+_range_still_loaded (const struct valid_ranges *vr, size_t i, unw_word_t lo)
+{
+  struct dl_find_object dlfo;
+
+  if (!vr->range[i].link_map)
+    return true;
+  return _dl_find_object ((void *) lo, &dlfo) == 0
+         && dlfo.dlfo_link_map == vr->range[i].link_map
+         && (unw_word_t) dlfo.dlfo_map_start == vr->range[i].map_start;
+}
+#endif
+
+
+/* Must be called with valid_ranges_lock held. */
+static void
+_free_retired_ranges (void)
+{
+  struct valid_ranges *vr, *next;
+
+  if (atomic_load (&valid_ranges_readers) != 0)
+    return;
+  for (vr = valid_ranges_retired; vr; vr = next)
+    {
+      next = vr->next;
+      mi_munmap (vr, vr->mem_size);
+    }
+  valid_ranges_retired = NULL;
+}
+
+
+static void
+_build_valid_ranges (unw_word_t sp)
+{
+  struct valid_ranges *vr = NULL;
+  unw_word_t lo = 0, hi = 0;
+  intrmask_t saved_mask;
+
+  lock_acquire (&valid_ranges_lock, saved_mask);
+  if (!atomic_load (&valid_ranges))
+    {
+      _scan_maps (&vr, sp, &lo, &hi);
+      if (!stack_scanned && !_on_alt_stack ())
+        {
+          stack_lo = lo;
+          stack_hi = hi;
+          stack_scanned = 1;
+        }
+      /* An empty snapshot still records that there is nothing to find. */
+      if (vr || _valid_ranges_add (&vr, 0, 0) == 0)
+        {
+          Debug (3, "%zu readable ranges\n", vr->count);
+          atomic_store (&valid_ranges, vr);
+        }
+    }
+  _free_retired_ranges ();
+  lock_release (&valid_ranges_lock, saved_mask);
+}
+
+
+/**
+ * Checks the cached ranges for the range from @p lo to @p hi.
+ *
+ * @returns true if it is known to be readable, false if it has to be probed.
+ */
+static bool
+_is_known_valid_range (unw_word_t lo, unw_word_t hi)
+{
+  unw_word_t sp = (unw_word_t) __builtin_frame_address (0);
+  struct valid_ranges *vr;
+  size_t l, r, m;
+  bool found = false;
+
+  if (lo >= stack_lo && hi <= stack_hi)
+    return true;
+
+  if (unlikely (!atomic_load (&valid_ranges)))
+    _build_valid_ranges (sp);
+  else if (unlikely (!stack_scanned) && !_on_alt_stack ())
+    {
+      _scan_maps (NULL, sp, &stack_lo, &stack_hi);
+      stack_scanned = 1;
+      if (lo >= stack_lo && hi <= stack_hi)
+        return true;
+    }
+
+  atomic_fetch_add (&valid_ranges_readers, 1);
+  vr = atomic_load (&valid_ranges);
+  if (vr)
+    {
+      /* Find the last range starting at or below LO. */
+      for (l = 0, r = vr->count; l < r; )
+        {
+          m = (l + r) / 2;
+          if (vr->range[m].start <= lo)
+            l = m + 1;
+          else
+            r = m;
+        }
+      found = l > 0 && hi <= vr->range[l - 1].end;
+#ifdef HAVE__DL_FIND_OBJECT
+      if (found)
+        found = _range_still_loaded (vr, l - 1, lo);
+#endif
+    }
+  atomic_fetch_sub (&valid_ranges_readers, 1);
+  return found;
+}
+
+
+/* The snapshot describes this process only, so flushing the caches of
+   another address space leaves it alone.  */
+void
+unw_address_validator_flush (unw_addr_space_t as)
+{
+  struct valid_ranges *vr;
+  intrmask_t saved_mask;
+
+  if (as != unw_local_addr_space)
+    return;
+
+  lock_acquire (&valid_ranges_lock, saved_mask);
+  vr = atomic_exchange (&valid_ranges, NULL);
+  if (vr)
+    {
+      vr->next = valid_ranges_retired;
+      valid_ranges_retired = vr;
+    }
+  _free_retired_ranges ();
+  lock_release (&valid_ranges_lock, saved_mask);
+}
+
+#else /* !__linux__ */
+
+static bool
+_is_known_valid_range (UNUSED unw_word_t lo, UNUSED unw_word_t hi)
+{
+  return false;
+}
+
+void
+unw_address_validator_flush (UNUSED unw_addr_space_t as)
+{
+}
+
+#endif /* !__linux__ */
+
+
 /**
  * Validate an address is readable
  * @param[in]  addr The (starting) address of the memory range to validate
@@ -276,6 +669,9 @@ unw_address_is_valid(unw_word_t addr, size_t len)
    */
   unw_word_t end_page_addr = unw_page_start (addr + (len - 1)) + unw_page_size;
 
+  if (_is_known_valid_range (addr, addr + len))
+    return true;
+
   /*
    * Step through each page and check if the first address in each is readable.
    * The first non-readable page encountered means none of them in the given
@@ -287,6 +683,7 @@ unw_address_is_valid(unw_word_t addr, size_t len)
     {
       if (!_is_cached_valid_mem(page_addr))
         {
+          unwi_stats_inc (unw_local_addr_space, UNWI_STAT_VALIDATE_SYSCALL);
           /* Check 'addr' in first page to avoid uninitialized memory access. */
           if (!_write_validate ((page_addr == start_page_addr) ? addr : page_addr))
             {
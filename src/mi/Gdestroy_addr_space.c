@@ -29,6 +29,9 @@ void
 unw_destroy_addr_space (unw_addr_space_t as UNUSED)
 {
 #ifndef UNW_LOCAL_ONLY
+# ifndef UNW_REMOTE_ONLY
+  elf_w (flush_symbol_tables) (as);
+# endif
 # if UNW_DEBUG
   memset (as, 0, sizeof (*as));
 # endif
@@ -51,6 +51,21 @@ local_find_proc_info (unw_addr_space_t as, unw_word_t ip, unw_proc_info_t *pi,
 
   // Access the `_U_dyn_info_list` from `LOCAL_ONLY` library, i.e. libunwind.so.
   list = (unw_dyn_info_list_t *) (uintptr_t) _U_dyn_info_list_addr ();
+
+#ifdef UNW_LOCAL_ONLY
+  /* The index lives next to the list only in the local-only library. */
+  switch (unwi_dyn_index_find (ip, &di))
+    {
+    case 1:
+      return unwi_extract_dynamic_proc_info (as, ip, pi, di, need_unwind_info,
+                                             arg);
+    case 0:
+      return -UNW_ENOINFO;
+    default:
+      break;
+    }
+#endif
+
   for (di = list->first; di; di = di->next)
     if (ip >= di->start_ip && ip < di->end_ip)
       return unwi_extract_dynamic_proc_info (as, ip, pi, di, need_unwind_info,
@@ -26,6 +26,9 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include "libunwind_i.h"
 #include "remote.h"
 
+#include <limits.h>
+#include <stdint.h>
+
 static inline int
 intern_string (unw_addr_space_t as, unw_accessors_t *a,
                unw_word_t addr, char *buf, size_t buf_len, void *arg)
@@ -96,6 +99,247 @@ unw_get_proc_name_by_ip (unw_addr_space_t as, unw_word_t ip,
   return -UNW_ENOINFO;
 }
 
+/* An address of a unw_get_proc_names_by_ip() batch and its position in
+   the caller's arrays.  */
+struct name_request
+  {
+    unw_word_t ip;
+    size_t index;
+  };
+
+/* The caller's arena and the name stored last in it, so that addresses
+   in the same procedure share one copy of its name.  */
+struct name_arena
+  {
+    char *buf;
+    size_t len;
+    size_t used;
+    const char *last;
+    int full;
+  };
+
+static inline int
+request_before (const struct name_request *a, const struct name_request *b)
+{
+  if (a->ip != b->ip)
+    return a->ip < b->ip;
+  return a->index < b->index;
+}
+
+static void
+sift_down (struct name_request *req, size_t root, size_t n)
+{
+  for (;;)
+    {
+      size_t child = 2 * root + 1;
+      struct name_request tmp;
+
+      if (child >= n)
+        return;
+      if (child + 1 < n && request_before (&req[child], &req[child + 1]))
+        ++child;
+      if (!request_before (&req[root], &req[child]))
+        return;
+
+      tmp = req[root];
+      req[root] = req[child];
+      req[child] = tmp;
+      root = child;
+    }
+}
+
+/* Heap sort, as for the symbol tables: it needs no memory beyond the
+   request array itself.  */
+static void
+sort_requests (struct name_request *req, size_t n)
+{
+  size_t i;
+
+  for (i = n / 2; i-- > 0;)
+    sift_down (req, i, n);
+
+  for (i = n; i-- > 1;)
+    {
+      struct name_request tmp = req[0];
+      req[0] = req[i];
+      req[i] = tmp;
+      sift_down (req, 0, i);
+    }
+}
+
+/* Keep the name just written at the free end of the arena, unless it
+   repeats the previous one.  */
+static const char *
+arena_commit (struct name_arena *na)
+{
+  char *name = na->buf + na->used;
+
+  if (na->last && strcmp (na->last, name) == 0)
+    return na->last;
+  na->used += strlen (name) + 1;
+  na->last = name;
+  return name;
+}
+
+static const char *
+arena_add (struct name_arena *na, const char *name)
+{
+  size_t len;
+
+  if (na->last && strcmp (na->last, name) == 0)
+    return na->last;
+  len = strlen (name) + 1;
+  if (len > na->len - na->used)
+    {
+      na->full = 1;
+      return NULL;
+    }
+  memcpy (na->buf + na->used, name, len);
+  return arena_commit (na);
+}
+
+/* Resolve one address of a batch.  Returns the name in the arena, or
+   NULL if there is none or it did not fit.  */
+static const char *
+lookup_name (unw_addr_space_t as, unw_accessors_t *a, unw_word_t ip,
+             struct name_arena *na, unw_word_t *offp,
+             struct elf_w (symbol_hint) *hint, void *arg)
+{
+  size_t avail = na->len - na->used;
+  unw_proc_info_t pi;
+  int ret;
+
+  ret = unwi_find_dynamic_proc_info (as, ip, &pi, 1, arg);
+  if (ret == 0)
+    {
+      unw_dyn_info_t *di = pi.unwind_info;
+      const char *name = NULL;
+
+      *offp = ip - pi.start_ip;
+      if (di->format == UNW_INFO_FORMAT_DYNAMIC)
+        {
+          if (avail == 0)
+            na->full = 1;
+          else
+            {
+              ret = intern_string (as, a, di->u.pi.name_ptr,
+                                   na->buf + na->used, avail, arg);
+              if (ret == 0)
+                name = arena_commit (na);
+              else if (ret == -UNW_ENOMEM)
+                na->full = 1;
+            }
+        }
+      unwi_put_dynamic_unwind_info (as, &pi, arg);
+      return name;
+    }
+  if (ret != -UNW_ENOINFO)
+    return NULL;
+
+#ifndef UNW_REMOTE_ONLY
+  if (hint->pid != 0 && as->caching_policy != UNW_CACHE_NONE)
+    {
+      const char *sym_name;
+
+      ret = elf_w (lookup_symbol_cached) (as, ip, hint, &sym_name, offp);
+      if (ret == 0)
+        return arena_add (na, sym_name);
+      if (ret < 0)
+        return NULL;
+    }
+#else
+  (void) hint;
+#endif /* !UNW_REMOTE_ONLY */
+
+  if (!a->get_proc_name)
+    return NULL;
+  if (avail == 0)
+    {
+      na->full = 1;
+      return NULL;
+    }
+  ret = (*a->get_proc_name) (as, ip, na->buf + na->used, avail, offp, arg);
+  if (ret == 0)
+    return arena_commit (na);
+  if (ret == -UNW_ENOMEM)
+    na->full = 1;
+  return NULL;
+}
+
+/* Resolve a batch of addresses.  The addresses are sorted first, so
+   that repeated addresses are looked up once and those falling into one
+   object are resolved from its cached symbol table in a single forward
+   pass; in the local address space, the accessor is only called for the
+   first address of an object that has no table yet.  */
+int
+unw_get_proc_names_by_ip (unw_addr_space_t as, const unw_word_t *ips,
+                          size_t n, const char **names, unw_word_t *offs,
+                          char *arena, size_t arena_len, void *arg)
+{
+  unw_accessors_t *a = unw_get_accessors_int (as);
+  struct name_arena na = { arena, arena_len, 0, NULL, 0 };
+  struct elf_w (symbol_hint) hint = { NULL, 0, 0 };
+  struct name_request *req;
+  size_t i, mem_size;
+  int resolved = 0;
+
+  if (n == 0)
+    return 0;
+  if (n > SIZE_MAX / sizeof (*req) || n > INT_MAX)
+    return -UNW_EINVAL;
+
+  mem_size = n * sizeof (*req);
+  GET_MEMORY (req, mem_size);
+  if (!req)
+    return -UNW_ENOMEM;
+
+  for (i = 0; i < n; ++i)
+    {
+      req[i].ip = ips[i];
+      req[i].index = i;
+    }
+  sort_requests (req, n);
+
+  /* HINT points into the symbol tables across the whole batch.  Only
+   the local address space knows which process it is looking at; the
+   tables of the others may belong to several processes, so those are
+   left to the get_proc_name() accessor.  */
+#ifndef UNW_REMOTE_ONLY
+  if (as == unw_local_addr_space)
+    hint.pid = getpid ();
+  elf_w (enter_symbol_tables) (as);
+#endif
+  for (i = 0; i < n; ++i)
+    {
+      size_t k = req[i].index;
+      unw_word_t off = 0;
+
+      if (i > 0 && req[i].ip == req[i - 1].ip)
+        {
+          size_t prev = req[i - 1].index;
+
+          names[k] = names[prev];
+          if (offs)
+            offs[k] = offs[prev];
+        }
+      else
+        {
+          names[k] = lookup_name (as, a, req[i].ip, &na, &off, &hint, arg);
+          if (offs)
+            offs[k] = names[k] ? off : 0;
+        }
+      if (names[k])
+        ++resolved;
+    }
+#ifndef UNW_REMOTE_ONLY
+  elf_w (leave_symbol_tables) (as);
+#endif
+
+  mi_munmap (req, mem_size);
+
+  return na.full ? -UNW_ENOMEM : resolved;
+}
+
 int
 unw_get_proc_name (unw_cursor_t *cursor, char *buf, size_t buf_len,
                    unw_word_t *offp)
@@ -0,0 +1,63 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "libunwind_i.h"
+
+int
+unw_get_stats (unw_addr_space_t as, unw_stats_t *stats)
+{
+  unsigned long count[UNWI_STAT_COUNT];
+  int i, j;
+
+  memset (count, 0, sizeof (count));
+  for (i = 0; i < UNWI_STATS_STRIPES; ++i)
+    for (j = 0; j < UNWI_STAT_COUNT; ++j)
+      count[j] += atomic_load_explicit (&as->stats.stripe[i].count[j],
+                                        memory_order_relaxed);
+
+  stats->rs_cache_hits = count[UNWI_STAT_RS_CACHE_HIT];
+  stats->rs_cache_misses = count[UNWI_STAT_RS_CACHE_MISS];
+  stats->compact_table_hits = count[UNWI_STAT_COMPACT_TABLE_HIT];
+  stats->trace_cache_expansions = count[UNWI_STAT_TRACE_CACHE_EXPAND];
+  stats->phdr_walks = count[UNWI_STAT_PHDR_WALK];
+  stats->validate_syscalls = count[UNWI_STAT_VALIDATE_SYSCALL];
+  stats->elf_maps = count[UNWI_STAT_ELF_MAP];
+  stats->minidebuginfo_decompressions = count[UNWI_STAT_MDI_DECOMPRESS];
+
+#ifdef CONFIG_STATS
+  return 0;
+#else
+  return -UNW_EUNSPEC;
+#endif
+}
+
+void
+unw_reset_stats (unw_addr_space_t as)
+{
+  int i, j;
+
+  for (i = 0; i < UNWI_STATS_STRIPES; ++i)
+    for (j = 0; j < UNWI_STAT_COUNT; ++j)
+      atomic_store_explicit (&as->stats.stripe[i].count[j], 0,
+                             memory_order_relaxed);
+}
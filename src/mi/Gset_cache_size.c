@@ -38,35 +38,42 @@ unw_set_cache_size (unw_addr_space_t as, size_t size, int flag)
   if (flag != 0)
     return -1;
 
-  /* Currently not supported for per-thread cache due to memory leak */
-  /* A pthread-key destructor would work, but is not signal safe */
-#if defined(HAVE___THREAD) && HAVE___THREAD
-  return -1;
-#endif
-
   /* Round up to next power of two, slowly but portably */
   while(power < size)
     {
       power *= 2;
       log_size++;
       /* Largest size currently supported by rs_cache */
+#if !defined(__ia64__)
+      if (log_size >= DWARF_MAX_LOG_UNW_CACHE_SIZE)
+#else
       if (log_size >= 15)
+#endif
         break;
     }
 
 #if !defined(__ia64__)
-  if (log_size == as->global_cache.log_size)
-    return 0;   /* no change */
+  struct dwarf_rs_cache *cache = &as->global_cache;
+  intrmask_t saved_mask;
+  int ret = 0;
 
-  as->global_cache.log_size = log_size;
+  lock_acquire (&cache->lock, saved_mask);
+  if (cache->hash && log_size == cache->log_size)
+    {
+      lock_release (&cache->lock, saved_mask);
+      return 0;   /* no change */
+    }
+  /* Synchronously resize, to ensure memory is allocated */
+  ret = dwarf_flush_rs_cache (cache, log_size, 1);
+  lock_release (&cache->lock, saved_mask);
 #endif
 
-  /* Ensure caches are empty (and initialized).  */
+  /* Ensure caches are empty (and initialized); per-thread caches pick
+     up the new size from the global one.  */
   unw_flush_cache (as, 0, 0);
 #ifdef __ia64__
   return 0;
 #else
-  /* Synchronously purge cache, to ensure memory is allocated */
-  return dwarf_flush_rs_cache(&as->global_cache);
+  return ret;
 #endif
 }
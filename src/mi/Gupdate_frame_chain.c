@@ -0,0 +1,157 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "libunwind_i.h"
+
+/* Frames of a new walk are collected here until the walk meets the
+   previous chain, which has to stay intact for the comparison.  If
+   this many frames are new, the rest is walked without comparing.  */
+#define CHAIN_HEAD_MAX  32
+
+static int
+read_frame (unw_cursor_t *cursor, unw_chain_frame_t *f)
+{
+  unw_save_loc_t loc;
+  int ret;
+
+  if ((ret = unw_get_reg (cursor, UNW_REG_IP, &f->ip)) < 0
+      || (ret = unw_get_reg (cursor, UNW_REG_SP, &f->sp)) < 0)
+    return ret;
+
+  f->ip_addr = 0;
+  if (unw_get_save_loc (cursor, UNW_REG_IP, &loc) == 0
+      && loc.type == UNW_SLT_MEMORY)
+    f->ip_addr = loc.u.addr;
+  return 0;
+}
+
+/* A frame of the previous chain matching the new one only shows that
+   the frame is at the same place; it could have returned and been
+   called again from elsewhere.  So check that every outer frame is
+   still there by reading each IP back from where it was found.  */
+static int
+outer_frames_unchanged (unw_cursor_t *cursor, const unw_chain_frame_t *frames,
+                        int first, int depth)
+{
+  struct cursor *c = (struct cursor *) cursor;
+  unw_addr_space_t as = tdep_get_as (c);
+  unw_accessors_t *a = unw_get_accessors_int (as);
+  void *arg = tdep_get_as_arg (c);
+  unw_word_t val;
+  int i;
+
+  for (i = first; i < depth; ++i)
+    if (!frames[i].ip_addr
+        || (*a->access_mem) (as, frames[i].ip_addr, &val, 0, arg) < 0
+        || val != frames[i].ip)
+      return 0;
+  return 1;
+}
+
+int
+unw_update_frame_chain (unw_cursor_t *cursor, unw_frame_chain_t *chain)
+{
+  unw_chain_frame_t head[CHAIN_HEAD_MAX], f;
+  unw_chain_frame_t *old = chain->frames;
+  int old_depth = chain->depth, size = chain->size;
+  int n = 0, j = 0, m, tail, truncated = 0, grows_down, ret;
+  int comparing;
+
+  if (size <= 0 || old_depth < 0 || old_depth > size)
+    return -UNW_EINVAL;
+
+  /* The innermost frame was read from the context, and its IP location
+     with it, so neither side's frame 0 takes part in the comparison.  */
+  comparing = old_depth > 1;
+  grows_down = comparing && old[0].sp <= old[old_depth - 1].sp;
+
+  for (;;)
+    {
+      if ((ret = read_frame (cursor, &f)) < 0)
+        {
+          chain->depth = 0;
+          return ret;
+        }
+
+      if (comparing && n > 0 && f.ip_addr)
+        {
+          /* Both walks move outwards, so the previous chain is scanned
+             only once.  Frames of a leaf and its caller can share SP.  */
+          while (j < old_depth && (grows_down ? old[j].sp < f.sp
+                                              : old[j].sp > f.sp))
+            ++j;
+          for (m = j; m < old_depth && old[m].sp == f.sp; ++m)
+            if (m > 0 && old[m].ip == f.ip && old[m].ip_addr == f.ip_addr)
+              break;
+
+          if (m < old_depth && old[m].sp == f.sp)
+            {
+              /* Splicing in a cut-off chain must not lose frames.  */
+              if ((!chain->truncated || n >= m)
+                  && outer_frames_unchanged (cursor, old, m + 1, old_depth))
+                {
+                  tail = old_depth - m;
+                  truncated = chain->truncated;
+                  if (n + tail > size)
+                    {
+                      tail = size - n;
+                      truncated = 1;
+                    }
+                  memmove (&old[n], &old[m], tail * sizeof (*old));
+                  memcpy (old, head, n * sizeof (*head));
+                  chain->depth = n + tail;
+                  chain->reused = tail;
+                  chain->truncated = truncated;
+                  return chain->depth;
+                }
+              comparing = 0;
+              memcpy (old, head, n * sizeof (*head));
+            }
+        }
+
+      if (comparing && n == CHAIN_HEAD_MAX)
+        {
+          comparing = 0;
+          memcpy (old, head, n * sizeof (*head));
+        }
+      if (comparing)
+        head[n] = f;
+      else
+        old[n] = f;
+
+      if (++n == size)
+        {
+          truncated = unw_step (cursor) > 0;
+          break;
+        }
+      if (unw_step (cursor) <= 0)
+        break;
+    }
+
+  if (comparing)
+    memcpy (old, head, n * sizeof (*head));
+  chain->depth = n;
+  chain->reused = 0;
+  chain->truncated = truncated;
+  return n;
+}
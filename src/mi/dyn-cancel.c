@@ -31,6 +31,7 @@ _U_dyn_cancel (unw_dyn_info_t *di)
   mutex_lock (&_U_dyn_info_list_lock);
   {
     ++_U_dyn_info_list.generation;
+    unwi_dyn_index_remove (di);
 
     if (di->prev)
       di->prev->next = di->next;
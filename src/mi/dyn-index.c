@@ -0,0 +1,413 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* Index of the dynamic unwind info registered in this process, so that
+   local unwinding through JIT code does not walk _U_dyn_info_list.
+
+   The index is a treap ordered by start_ip, in which each node also
+   keeps the largest end_ip of its subtree.  It is persistent: an
+   update copies the nodes on the path it changes and then publishes the
+   new root, so readers never see a node change and need no lock.  The
+   replaced nodes are retired and freed by a later update once no reader
+   is active.  Updates are serialised by _U_dyn_info_list_lock.
+
+   Lookups answer "use the list" instead if regions overlap, because
+   then the most recently registered region must win, or if the index
+   could not be updated for lack of memory.  A region that overlaps any
+   region registered before it is counted until it is cancelled, so
+   the index stays off while any two registered regions overlap.  */
+
+#include "libunwind_i.h"
+
+#include <stdatomic.h>
+
+struct dyn_node
+  {
+    unw_word_t start_ip;
+    unw_word_t end_ip;
+    unw_word_t max_end;         /* largest end_ip in this subtree */
+    unw_dyn_info_t *di;
+    struct dyn_node *left;
+    struct dyn_node *right;
+    struct dyn_node *link;      /* retired or newly allocated nodes */
+    uint32_t prio;
+    uint32_t overlaps;          /* did overlap a region when added */
+  };
+
+/* Nodes are carved from chunks of this size and recycled through
+   dyn_free; chunks are never returned.  Registration may come before
+   the first unwind, i.e. before unw_page_size is known.  */
+#define DYN_CHUNK_SIZE  65536
+
+static struct dyn_node *dyn_free;
+
+static _Atomic (struct dyn_node *) dyn_index_root;
+static _Atomic unsigned long dyn_index_readers;
+static _Atomic int dyn_index_broken;
+static _Atomic unsigned long dyn_index_overlaps;
+
+/* Writer-only state of the update in progress.  */
+static struct dyn_node *dyn_new;        /* allocated by this update */
+static struct dyn_node *dyn_replaced;   /* replaced by this update */
+static struct dyn_node *dyn_retired;    /* waiting for readers to leave */
+static int dyn_failed;
+
+static inline int
+node_before (const struct dyn_node *a, unw_word_t start_ip,
+             const unw_dyn_info_t *di)
+{
+  if (a->start_ip != start_ip)
+    return a->start_ip < start_ip;
+  return (uintptr_t) a->di < (uintptr_t) di;
+}
+
+/* Recompute the max_end of N from its children.  */
+static void
+node_update (struct dyn_node *n)
+{
+  n->max_end = n->end_ip;
+  if (n->left && n->left->max_end > n->max_end)
+    n->max_end = n->left->max_end;
+  if (n->right && n->right->max_end > n->max_end)
+    n->max_end = n->right->max_end;
+}
+
+static struct dyn_node *
+node_alloc (void)
+{
+  struct dyn_node *n;
+  char *chunk;
+  size_t i;
+
+  if (dyn_failed)
+    return NULL;
+  if (! dyn_free)
+    {
+      GET_MEMORY (chunk, DYN_CHUNK_SIZE);
+      if (! chunk)
+        {
+          dyn_failed = 1;
+          return NULL;
+        }
+      for (i = 0; i + sizeof (*n) <= DYN_CHUNK_SIZE; i += sizeof (*n))
+        {
+          n = (struct dyn_node *) (chunk + i);
+          n->link = dyn_free;
+          dyn_free = n;
+        }
+    }
+  n = dyn_free;
+  dyn_free = n->link;
+  n->link = dyn_new;
+  dyn_new = n;
+  return n;
+}
+
+/* Return a private copy of published node N, to be modified by the
+   current update.  */
+static struct dyn_node *
+node_copy (struct dyn_node *n)
+{
+  struct dyn_node *c = node_alloc ();
+  struct dyn_node *link;
+
+  if (c)
+    {
+      link = c->link;
+      *c = *n;
+      c->link = link;
+      n->link = dyn_replaced;
+      dyn_replaced = n;
+    }
+  return c;
+}
+
+/* Split T into nodes before N and the rest.  */
+static void
+split (struct dyn_node *t, const struct dyn_node *n,
+       struct dyn_node **l, struct dyn_node **r)
+{
+  struct dyn_node *c;
+
+  if (! t)
+    {
+      *l = *r = NULL;
+      return;
+    }
+  if (! (c = node_copy (t)))
+    return;
+  if (node_before (t, n->start_ip, n->di))
+    {
+      split (t->right, n, &c->right, r);
+      *l = c;
+    }
+  else
+    {
+      split (t->left, n, l, &c->left);
+      *r = c;
+    }
+  node_update (c);
+}
+
+static struct dyn_node *
+insert (struct dyn_node *t, struct dyn_node *n)
+{
+  struct dyn_node *c;
+
+  if (! t)
+    return n;
+  if (n->prio > t->prio)
+    {
+      split (t, n, &n->left, &n->right);
+      node_update (n);
+      return n;
+    }
+  if (! (c = node_copy (t)))
+    return NULL;
+  if (node_before (n, t->start_ip, t->di))
+    c->left = insert (t->left, n);
+  else
+    c->right = insert (t->right, n);
+  node_update (c);
+  return c;
+}
+
+static struct dyn_node *
+merge (struct dyn_node *a, struct dyn_node *b)
+{
+  struct dyn_node *c;
+
+  if (! a)
+    return b;
+  if (! b)
+    return a;
+  if (a->prio > b->prio)
+    {
+      if ((c = node_copy (a)))
+        c->right = merge (a->right, b);
+    }
+  else
+    {
+      if ((c = node_copy (b)))
+        c->left = merge (a, b->left);
+    }
+  if (c)
+    node_update (c);
+  return c;
+}
+
+static struct dyn_node *
+remove_node (struct dyn_node *t, const struct dyn_node *n)
+{
+  struct dyn_node *c;
+
+  if (t == n)
+    {
+      t->link = dyn_replaced;
+      dyn_replaced = t;
+      return merge (t->left, t->right);
+    }
+  if (! (c = node_copy (t)))
+    return NULL;
+  if (node_before (n, t->start_ip, t->di))
+    c->left = remove_node (t->left, n);
+  else
+    c->right = remove_node (t->right, n);
+  node_update (c);
+  return c;
+}
+
+static struct dyn_node *
+find_node (struct dyn_node *t, const unw_dyn_info_t *di)
+{
+  while (t && t->di != di)
+    t = node_before (t, di->start_ip, di) ? t->right : t->left;
+  return t;
+}
+
+/* Return the node with the largest start_ip not above IP.  */
+static struct dyn_node *
+find_floor (struct dyn_node *t, unw_word_t ip)
+{
+  struct dyn_node *best = NULL;
+
+  while (t)
+    if (t->start_ip <= ip)
+      {
+        best = t;
+        t = t->right;
+      }
+    else
+      t = t->left;
+  return best;
+}
+
+/* Return whether any region in T overlaps START..END.  If the left
+   subtree reaches past START but has no overlapping region, the region
+   reaching past START begins at or after END, and so does everything
+   in the right subtree.  */
+static int
+overlaps_any (struct dyn_node *t, unw_word_t start, unw_word_t end)
+{
+  while (t)
+    {
+      if (t->start_ip < end && start < t->end_ip)
+        return 1;
+      if (t->left && t->left->max_end > start)
+        t = t->left;
+      else
+        t = t->right;
+    }
+  return 0;
+}
+
+static void
+free_list (struct dyn_node *n)
+{
+  struct dyn_node *next;
+
+  for (; n; n = next)
+    {
+      next = n->link;
+      n->link = dyn_free;
+      dyn_free = n;
+    }
+}
+
+static void
+update_begin (void)
+{
+  dyn_new = dyn_replaced = NULL;
+  dyn_failed = 0;
+}
+
+/* Publish ROOT, or give up on the index if the update ran out of
+   memory, and free what no reader can see any more.  */
+static void
+update_end (struct dyn_node *root)
+{
+  struct dyn_node *n;
+
+  if (dyn_failed)
+    {
+      Debug (1, "out of memory, using the dynamic info list from now on\n");
+      atomic_store (&dyn_index_broken, 1);
+      free_list (dyn_new);
+      return;
+    }
+
+  atomic_store (&dyn_index_root, root);
+  if (dyn_replaced)
+    {
+      for (n = dyn_replaced; n->link; n = n->link)
+        continue;
+      n->link = dyn_retired;
+      dyn_retired = dyn_replaced;
+    }
+
+  /* A reader arriving from now on finds the new root.  */
+  if (atomic_load (&dyn_index_readers) == 0)
+    {
+      free_list (dyn_retired);
+      dyn_retired = NULL;
+    }
+}
+
+/* Add DI to the index.  Called with _U_dyn_info_list_lock held.  */
+HIDDEN void
+unwi_dyn_index_insert (unw_dyn_info_t *di)
+{
+  struct dyn_node *root, *n;
+  uint32_t overlaps = 0;
+
+  if (atomic_load (&dyn_index_broken))
+    return;
+
+  update_begin ();
+  root = atomic_load (&dyn_index_root);
+
+  if (di->start_ip >= di->end_ip
+      || overlaps_any (root, di->start_ip, di->end_ip))
+    overlaps = 1;
+
+  if ((n = node_alloc ()))
+    {
+      n->start_ip = di->start_ip;
+      n->end_ip = di->end_ip;
+      n->di = di;
+      n->left = n->right = NULL;
+      n->max_end = n->end_ip;
+      n->prio = (uint32_t) (((uint64_t) (uintptr_t) di
+                             * 0x9e3779b97f4a7c15ULL) >> 32);
+      n->overlaps = overlaps;
+      root = insert (root, n);
+    }
+  if (! dyn_failed && overlaps)
+    atomic_fetch_add (&dyn_index_overlaps, 1);
+  update_end (root);
+}
+
+/* Remove DI from the index.  Called with _U_dyn_info_list_lock held.  */
+HIDDEN void
+unwi_dyn_index_remove (unw_dyn_info_t *di)
+{
+  struct dyn_node *root, *n;
+  uint32_t overlaps;
+
+  if (atomic_load (&dyn_index_broken))
+    return;
+
+  root = atomic_load (&dyn_index_root);
+  if (! (n = find_node (root, di)))
+    return;
+
+  update_begin ();
+  overlaps = n->overlaps;
+  root = remove_node (root, n);
+  if (! dyn_failed && overlaps)
+    atomic_fetch_sub (&dyn_index_overlaps, 1);
+  update_end (root);
+}
+
+/* Find the dynamic info covering IP.  Returns 1 and sets *DIP if found,
+   0 if no registered region covers IP, or -1 if the caller has to walk
+   _U_dyn_info_list instead.  Safe to call from signal handlers.  */
+HIDDEN int
+unwi_dyn_index_find (unw_word_t ip, unw_dyn_info_t **dip)
+{
+  struct dyn_node *n;
+  int ret = 0;
+
+  atomic_fetch_add (&dyn_index_readers, 1);
+  if (atomic_load (&dyn_index_broken)
+      || atomic_load (&dyn_index_overlaps))
+    ret = -1;
+  else if ((n = find_floor (atomic_load (&dyn_index_root), ip))
+           && ip < n->end_ip)
+    {
+      *dip = n->di;
+      ret = 1;
+    }
+  atomic_fetch_sub (&dyn_index_readers, 1);
+  return ret;
+}
@@ -26,6 +26,47 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include "libunwind_i.h"
 #include <stdatomic.h>
 
+#if !UNW_TARGET_IA64
+/* Lookups may still walk the compact tables they found before a flush;
+   they are counted in the address space's compact_table_readers.  The
+   flushed lists are retired and freed by a later flush once no lookup
+   is active.  Flushes are serialised by compact_tables_lock, so a list
+   on the retired list can no longer be reached by a lookup that starts
+   after the check.  */
+static define_lock (compact_tables_lock);
+
+static void
+flush_compact_tables (unw_addr_space_t as)
+{
+  struct dwarf_compact_table *list, *t, *n;
+  intrmask_t saved_mask;
+
+  lock_acquire (&compact_tables_lock, saved_mask);
+  t = atomic_exchange (&as->compact_tables, NULL);
+  if (t)
+    {
+      t->retired = as->retired_compact_tables;
+      as->retired_compact_tables = t;
+    }
+  if (atomic_load (&as->compact_table_readers) == 0)
+    {
+      for (list = as->retired_compact_tables; list; list = list->retired)
+        for (t = atomic_load (&list->next); t; t = n)
+          {
+            n = atomic_load (&t->next);
+            mi_munmap (t, t->mem_size);
+          }
+      for (list = as->retired_compact_tables; list; list = n)
+        {
+          n = list->retired;
+          mi_munmap (list, list->mem_size);
+        }
+      as->retired_compact_tables = NULL;
+    }
+  lock_release (&compact_tables_lock, saved_mask);
+}
+#endif
+
 void
 unw_flush_cache (unw_addr_space_t as, unw_word_t lo UNUSED, unw_word_t hi UNUSED)
 {
@@ -44,8 +85,16 @@ unw_flush_cache (unw_addr_space_t as, unw_word_t lo UNUSED, unw_word_t hi UNUSED
       w = n;
     }
   as->debug_frames = NULL;
+
+  flush_compact_tables (as);
 #endif
 
+#ifndef UNW_REMOTE_ONLY
+  elf_w (flush_symbol_tables) (as);
+#endif
+
+  unw_address_validator_flush (as);
+
   /* clear dyn_info_list_addr cache: */
   as->dyn_info_list_addr = 0;
 
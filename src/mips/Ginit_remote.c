@@ -42,6 +42,7 @@ unw_init_remote (unw_cursor_t *cursor, unw_addr_space_t as, void *as_arg)
 
   Debug (1, "(cursor=%p)\n", c);
 
+  atomic_fetch_add (&as->init_generation, 1);
   c->dwarf.as = as;
   c->dwarf.as_arg = as_arg;
   return common_init (c, 0);
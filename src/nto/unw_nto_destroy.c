@@ -65,6 +65,7 @@ void unw_nto_destroy (void *arg)
 {
   unw_nto_internal_t *uni = (unw_nto_internal_t *)arg;
   invalidate_edi (&uni->edi);
+  edi_cache_flush (&uni->edi_cache, 1);
   int ctl_fd = unw_nto_procfs_open_ctl (uni->pid);
 
   if (ctl_fd < 0)
@@ -68,24 +68,35 @@ int unw_nto_find_proc_info (unw_addr_space_t as,
   unsigned long segbase = 0;
   unsigned long mapoff = 0;
   char path[PATH_MAX];
-  invalidate_edi (&uni->edi);
-  ret = tdep_get_elf_image (as,
-                            &uni->edi.ei,
-                            uni->pid,
-                            ip,
-                            &segbase,
-                            &mapoff,
-                            path,
-                            sizeof (path), arg);
 
-  if (ret >= 0)
+  if (edi_covers (&uni->edi, ip)
+      || edi_cache_lookup (&uni->edi_cache, &uni->edi, ip, 1))
+    ret = UNW_ESUCCESS;
+  else
     {
-      ret = tdep_find_unwind_table (&uni->edi, as, path, segbase, mapoff, ip);
-      if (ret < UNW_ESUCCESS)
+      edi_cache_save (&uni->edi_cache, &uni->edi, 1);
+      ret = tdep_get_elf_image (as,
+                                &uni->edi.ei,
+                                uni->pid,
+                                ip,
+                                &segbase,
+                                &mapoff,
+                                path,
+                                sizeof (path), arg);
+      if (ret >= 0)
         {
-          return ret;
+          unwi_stats_inc (as, UNWI_STAT_ELF_MAP);
+          ret = tdep_find_unwind_table (&uni->edi, as, path, segbase, mapoff, ip);
+          if (ret < UNW_ESUCCESS)
+            {
+              return ret;
+            }
         }
+    }
 
+  if (ret >= 0)
+    {
+      ret = -UNW_ENOINFO;
       if (uni->edi.di_cache.format != -1)
         {
           ret = tdep_search_unwind_table (as, ip, &uni->edi.di_cache,
@@ -37,6 +37,7 @@ typedef struct unw_nto_internal
   pid_t               pid;        /* process ID of the thread being unwound */
   pthread_t           tid;        /* thread ID of the thread being unwound */
   struct elf_dyn_info edi;        /* ELF info for current frame */
+  struct elf_dyn_info_cache edi_cache; /* ELF info for other objects */
 } unw_nto_internal_t;
 
 
@@ -366,6 +366,7 @@ unw_step (unw_cursor_t * cursor)
               /* Mark all registers unsaved */
               for (i = 0; i < DWARF_NUM_PRESERVED_REGS; ++i)
                 c->dwarf.loc[i] = DWARF_NULL_LOC;
+              c->frame_info.frame_type = UNW_PPC64_FRAME_BACKCHAIN;
             }
     }
 
@@ -389,6 +390,8 @@ signal_frame:
 
           c->sigcontext_format = PPC_SCF_LINUX_RT_SIGFRAME;
           c->sigcontext_addr = ucontext;
+          c->frame_info.frame_type = UNW_PPC64_FRAME_SIGRETURN;
+          c->frame_info.cfa_reg_offset = __SIGNAL_FRAMESIZE;
 
           sp_loc = DWARF_LOC ((ucontext + UC_MCONTEXT_GREGS_R1), 0);
           ip_loc = DWARF_LOC ((ucontext + UC_MCONTEXT_GREGS_NIP), 0);
@@ -49,4 +49,19 @@ extern int ppc64_local_resume (unw_addr_space_t as, unw_cursor_t *cursor,
 extern dwarf_loc_t ppc64_scratch_loc (struct cursor *c, unw_regnum_t reg);
 #endif
 
+/* By-pass calls to access_mem() when known to be safe.  The local
+   dwarf_get() dereferences directly, so go through access_mem() when
+   the address has to be validated. */
+#ifdef UNW_LOCAL_ONLY
+# undef ACCESS_MEM_FAST
+# define ACCESS_MEM_FAST(ret,validate,cur,addr,to)                     \
+  do {                                                                 \
+    if (unlikely(validate))                                            \
+      (ret) = (*(cur)->as->acc.access_mem) ((cur)->as, (addr), &(to),  \
+                                            0, (cur)->as_arg);         \
+    else                                                               \
+      (ret) = 0, (to) = *(unw_word_t *)(addr);                         \
+  } while (0)
+#endif
+
 #endif /* unwind_i_h */
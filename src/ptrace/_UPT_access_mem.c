@@ -26,9 +26,117 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 
 #include "_UPT_internal.h"
 
+#ifdef UPT_HAVE_MEM_CACHE
+#include <fcntl.h>
+#ifdef HAVE_PROCESS_VM_READV
+#include <sys/uio.h>
+#endif
+
+/* Read the block at ADDR into BLOCK, preferably with a single system
+   call.  Returns 0 on success.  */
+static int
+fetch_block (struct UPT_info *ui, unw_word_t addr, struct UPT_mem_block *block)
+{
+#ifdef HAVE_PROCESS_VM_READV
+  static int process_vm_readv_supported = 1;
+
+  if (process_vm_readv_supported)
+    {
+      struct iovec local, remote;
+      ssize_t n;
+
+      local.iov_base = block->data;
+      local.iov_len = UPT_MEM_BLOCK_SIZE;
+      remote.iov_base = (void *) (uintptr_t) addr;
+      remote.iov_len = UPT_MEM_BLOCK_SIZE;
+      n = process_vm_readv (ui->pid, &local, 1, &remote, 1, 0);
+      if (n == UPT_MEM_BLOCK_SIZE)
+        return 0;
+      if (n < 0 && errno == ENOSYS)
+        process_vm_readv_supported = 0;
+      else if (n < 0 && errno == EFAULT)
+        return -1;
+    }
+#endif
+
+  if (ui->mem_fd == -1)
+    {
+      char path[64];
+
+      snprintf (path, sizeof (path), "/proc/%d/mem", (int) ui->pid);
+      ui->mem_fd = open (path, O_RDONLY | O_CLOEXEC);
+      if (ui->mem_fd < 0)
+        ui->mem_fd = -2;
+    }
+  if (ui->mem_fd >= 0
+      && pread (ui->mem_fd, block->data, UPT_MEM_BLOCK_SIZE, (off_t) addr)
+         == UPT_MEM_BLOCK_SIZE)
+    return 0;
+
+  return -1;
+}
+
+/* Read the word at ADDR through the block cache.  Returns 0 on
+   success, or -1 if the caller should fall back to PTRACE_PEEKDATA.  */
+static int
+read_cached (struct UPT_info *ui, unw_word_t addr, unw_word_t *val)
+{
+  unw_word_t block_addr = addr & ~(unw_word_t) (UPT_MEM_BLOCK_SIZE - 1);
+  struct UPT_mem_block *block;
+  int i;
+
+  /* Words straddling two blocks are rare enough to be read directly.  */
+  if (addr - block_addr > UPT_MEM_BLOCK_SIZE - sizeof (*val)
+      || block_addr == 0)
+    return -1;
+
+  if (!ui->mem_cache)
+    {
+      ui->mem_cache = calloc (UPT_MEM_CACHE_BLOCKS, sizeof (*ui->mem_cache));
+      if (!ui->mem_cache)
+        return -1;
+    }
+
+  for (i = 0; i < UPT_MEM_CACHE_BLOCKS; ++i)
+    if (ui->mem_cache[i].addr == block_addr)
+      {
+        block = &ui->mem_cache[i];
+        goto hit;
+      }
+
+  block = &ui->mem_cache[ui->mem_victim];
+  block->addr = 0;
+  if (fetch_block (ui, block_addr, block) < 0)
+    return -1;
+  block->addr = block_addr;
+  ui->mem_victim = (ui->mem_victim + 1) % UPT_MEM_CACHE_BLOCKS;
+
+ hit:
+  memcpy (val, block->data + (addr - block_addr), sizeof (*val));
+  Debug (16, "mem[%lx] -> %lx (cached)\n", (long) addr, (long) *val);
+  return 0;
+}
+
+/* Drop the cached blocks that overlap the word at ADDR.  */
+static void
+invalidate_cached (struct UPT_info *ui, unw_word_t addr)
+{
+  unw_word_t mask = ~(unw_word_t) (UPT_MEM_BLOCK_SIZE - 1);
+  int i;
+
+  if (!ui->mem_cache)
+    return;
+
+  for (i = 0; i < UPT_MEM_CACHE_BLOCKS; ++i)
+    if (ui->mem_cache[i].addr == (addr & mask)
+        || ui->mem_cache[i].addr == ((addr + sizeof (unw_word_t) - 1) & mask))
+      ui->mem_cache[i].addr = 0;
+}
+#endif /* UPT_HAVE_MEM_CACHE */
+
 #if HAVE_DECL_PTRACE_POKEDATA || defined(HAVE_TTRACE)
 int
-_UPT_access_mem (unw_addr_space_t as UNUSED, unw_word_t addr, unw_word_t *val,
+_UPT_access_mem (unw_addr_space_t as, unw_word_t addr, unw_word_t *val,
                  int write, void *arg)
 {
   struct UPT_info *ui = arg;
@@ -40,6 +148,13 @@ _UPT_access_mem (unw_addr_space_t as UNUSED, unw_word_t addr, unw_word_t *val,
 
   pid_t pid = ui->pid;
 
+#ifdef UPT_HAVE_MEM_CACHE
+  if (write)
+    invalidate_cached (ui, addr);
+  else if (_UPT_validate_cache (as, ui) && read_cached (ui, addr, val) == 0)
+    return 0;
+#endif
+
   // Some 32-bit archs have to define a 64-bit unw_word_t.
   // Callers of this function therefore expect a 64-bit
   // return value, but ptrace only returns a 32-bit value
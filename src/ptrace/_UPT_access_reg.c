@@ -37,12 +37,11 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #if HAVE_DECL_PTRACE_SETREGSET && (defined(__linux__) && !defined(UNW_TARGET_X86))
 #include <sys/uio.h>
 int
-_UPT_access_reg (unw_addr_space_t as UNUSED, unw_regnum_t reg, unw_word_t *val,
+_UPT_access_reg (unw_addr_space_t as, unw_regnum_t reg, unw_word_t *val,
                  int write, void *arg)
 {
   struct UPT_info *ui = arg;
   pid_t pid = ui->pid;
-  elf_gregset_t regs;
   char *r;
   struct iovec loc;
 
@@ -59,10 +58,11 @@ _UPT_access_reg (unw_addr_space_t as UNUSED, unw_regnum_t reg, unw_word_t *val,
       goto badreg;
     }
 
-  loc.iov_base = &regs;
-  loc.iov_len = sizeof(regs);
+  _UPT_validate_cache (as, ui);
+  loc.iov_base = &ui->regs;
+  loc.iov_len = sizeof(ui->regs);
 
-  r = (char *)&regs + _UPT_reg_offset[reg];
+  r = (char *)&ui->regs + _UPT_reg_offset[reg];
 
 #ifdef UNW_TARGET_ALPHA
   /* Alpha kernels before 7.1 do not support PTRACE_GETREGSET.
@@ -73,19 +73,25 @@ _UPT_access_reg (unw_addr_space_t as UNUSED, unw_regnum_t reg, unw_word_t *val,
     if (getregset_supported == 0)
       goto use_peekuser;
 
-    if (ptrace (PTRACE_GETREGSET, pid, NT_PRSTATUS, &loc) == -1)
+    if (!ui->regs_valid)
       {
-        if (getregset_supported < 0)
+        if (ptrace (PTRACE_GETREGSET, pid, NT_PRSTATUS, &loc) == -1)
           {
-            getregset_supported = 0;
-            goto use_peekuser;
+            if (getregset_supported < 0)
+              {
+                getregset_supported = 0;
+                goto use_peekuser;
+              }
+            goto badreg;
           }
-        goto badreg;
+        getregset_supported = 1;
+        ui->regs_valid = 1;
       }
-    getregset_supported = 1;
 
     if (write)
       {
+        /* Let the next read pick up whatever the kernel stored.  */
+        ui->regs_valid = 0;
         memcpy(r, val, sizeof(unw_word_t));
         if (ptrace(PTRACE_SETREGSET, pid, NT_PRSTATUS, &loc) == -1)
           goto badreg;
@@ -114,9 +120,15 @@ use_peekuser:
     return 0;
   }
 #else /* !UNW_TARGET_ALPHA */
-  if (ptrace (PTRACE_GETREGSET, pid, NT_PRSTATUS, &loc) == -1)
-    goto badreg;
+  if (!ui->regs_valid)
+    {
+      if (ptrace (PTRACE_GETREGSET, pid, NT_PRSTATUS, &loc) == -1)
+        goto badreg;
+      ui->regs_valid = 1;
+    }
   if (write) {
+    /* Let the next read pick up whatever the kernel stored.  */
+    ui->regs_valid = 0;
     memcpy(r, val, sizeof(unw_word_t));
     if (ptrace(PTRACE_SETREGSET, pid, NT_PRSTATUS, &loc) == -1)
       goto badreg;
@@ -377,12 +389,11 @@ _UPT_access_reg (UNUSED unw_addr_space_t as, unw_regnum_t reg, unw_word_t *val,
 # include <sys/user.h>
 
 int
-_UPT_access_reg (unw_addr_space_t as UNUSED, unw_regnum_t reg, unw_word_t *val,
+_UPT_access_reg (unw_addr_space_t as, unw_regnum_t reg, unw_word_t *val,
                  int write, void *arg)
 {
   struct UPT_info *ui = arg;
   pid_t pid = ui->pid;
-  struct user_regs_struct regs;
   char *r;
 
 #if UNW_DEBUG
@@ -396,12 +407,19 @@ _UPT_access_reg (unw_addr_space_t as UNUSED, unw_regnum_t reg, unw_word_t *val,
       errno = EINVAL;
       goto badreg;
     }
-  r = (char *)&regs + _UPT_reg_offset[reg];
-  if (ptrace(PT_GETREGS, pid, NULL, &regs) == -1)
-    goto badreg;
+  r = (char *)&ui->regs + _UPT_reg_offset[reg];
+  _UPT_validate_cache (as, ui);
+  if (!ui->regs_valid)
+    {
+      if (ptrace(PT_GETREGS, pid, NULL, &ui->regs) == -1)
+        goto badreg;
+      ui->regs_valid = 1;
+    }
   if (write) {
+      /* Let the next read pick up whatever the kernel stored.  */
+      ui->regs_valid = 0;
       memcpy(r, val, sizeof(unw_word_t));
-      if (ptrace(PT_SETREGS, pid, NULL, &regs) == -1)
+      if (ptrace(PT_SETREGS, pid, NULL, &ui->regs) == -1)
         goto badreg;
   } else
       memcpy(val, r, sizeof(unw_word_t));
@@ -419,7 +437,6 @@ _UPT_access_reg (unw_addr_space_t as, unw_regnum_t reg, unw_word_t *val,
 {
   struct UPT_info *ui = arg;
   pid_t pid = ui->pid;
-  gregset_t regs;
   char *r;
 
 #if UNW_DEBUG
@@ -434,12 +451,19 @@ _UPT_access_reg (unw_addr_space_t as, unw_regnum_t reg, unw_word_t *val,
       errno = EINVAL;
       goto badreg;
     }
-  r = (char *)&regs + _UPT_reg_offset[reg];
-  if (ptrace(PT_GETREGS, pid, (caddr_t)&regs, 0) == -1)
-    goto badreg;
+  r = (char *)&ui->regs + _UPT_reg_offset[reg];
+  _UPT_validate_cache (as, ui);
+  if (!ui->regs_valid)
+    {
+      if (ptrace(PT_GETREGS, pid, (caddr_t)&ui->regs, 0) == -1)
+        goto badreg;
+      ui->regs_valid = 1;
+    }
   if (write) {
+      /* Let the next read pick up whatever the kernel stored.  */
+      ui->regs_valid = 0;
       memcpy(r, val, sizeof(unw_word_t));
-      if (ptrace(PT_SETREGS, pid, (caddr_t)&regs, 0) == -1)
+      if (ptrace(PT_SETREGS, pid, (caddr_t)&ui->regs, 0) == -1)
         goto badreg;
   } else
       memcpy(val, r, sizeof(unw_word_t));
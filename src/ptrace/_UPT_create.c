@@ -41,8 +41,14 @@ _UPT_create (pid_t pid)
   ui->pid = pid;
   ui->edi.di_cache.format = -1;
   ui->edi.di_debug.format = -1;
+#if UNW_TARGET_ARM
+  ui->edi.di_arm.format = -1;
+#endif
 #if UNW_TARGET_IA64
   ui->edi.ktab.format = -1;
+#endif
+#ifdef UPT_HAVE_MEM_CACHE
+  ui->mem_fd = -1;
 #endif
   return ui;
 }
@@ -30,5 +30,11 @@ _UPT_destroy (void *ptr)
 {
   struct UPT_info *ui = (struct UPT_info *) ptr;
   invalidate_edi (&ui->edi);
+  edi_cache_flush (&ui->edi_cache, 1);
+#ifdef UPT_HAVE_MEM_CACHE
+  if (ui->mem_fd >= 0)
+    close (ui->mem_fd);
+  free (ui->mem_cache);
+#endif
   free (ptr);
 }
@@ -33,8 +33,9 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 #include "_UPT_internal.h"
 
 static int
-get_unwind_info ( struct elf_dyn_info *edi, pid_t pid, unw_addr_space_t as, unw_word_t ip, void *arg)
+get_unwind_info (struct UPT_info *ui, unw_addr_space_t as, unw_word_t ip, void *arg)
 {
+  struct elf_dyn_info *edi = &ui->edi;
   unsigned long segbase, mapoff;
   char path[PATH_MAX];
 
@@ -46,21 +47,16 @@ get_unwind_info ( struct elf_dyn_info *edi, pid_t pid, unw_addr_space_t as, unw_
     return 0;
 #endif
 
-  if ((edi->di_cache.format != -1
-       && ip >= edi->di_cache.start_ip && ip < edi->di_cache.end_ip)
-#if UNW_TARGET_ARM
-      || (edi->di_debug.format != -1
-       && ip >= edi->di_arm.start_ip && ip < edi->di_arm.end_ip)
-#endif
-      || (edi->di_debug.format != -1
-       && ip >= edi->di_debug.start_ip && ip < edi->di_debug.end_ip))
+  if (edi_covers (edi, ip)
+      || edi_cache_lookup (&ui->edi_cache, edi, ip, 1))
     return 0;
 
-  invalidate_edi(edi);
+  edi_cache_save (&ui->edi_cache, edi, 1);
 
-  if (tdep_get_elf_image (as, &edi->ei, pid, ip, &segbase, &mapoff, path,
+  if (tdep_get_elf_image (as, &edi->ei, ui->pid, ip, &segbase, &mapoff, path,
                           sizeof(path), arg) < 0)
     return -UNW_ENOINFO;
+  unwi_stats_inc (as, UNWI_STAT_ELF_MAP);
 
   /* Here, SEGBASE is the starting-address of the (mmap'ped) segment
      which covers the IP we're looking for.  */
@@ -96,7 +92,7 @@ _UPT_find_proc_info (unw_addr_space_t as, unw_word_t ip, unw_proc_info_t *pi,
   struct UPT_info *ui = arg;
   int ret = -UNW_ENOINFO;
 
-  if (get_unwind_info (&ui->edi, ui->pid, as, ip, arg) < 0)
+  if (get_unwind_info (ui, as, ip, arg) < 0)
     return -UNW_ENOINFO;
 
 #if UNW_TARGET_IA64
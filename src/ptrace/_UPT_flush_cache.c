@@ -0,0 +1,70 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_UPT_internal.h"
+
+/* Forget the registers and memory of the target, which change whenever
+   it runs.  */
+HIDDEN void
+_UPT_flush_target (struct UPT_info *ui)
+{
+#ifdef UPT_HAVE_REGSET
+  ui->regs_valid = 0;
+#endif
+#ifdef UPT_HAVE_MEM_CACHE
+  if (ui->mem_cache)
+    {
+      int i;
+
+      for (i = 0; i < UPT_MEM_CACHE_BLOCKS; ++i)
+        ui->mem_cache[i].addr = 0;
+    }
+#endif
+}
+
+/* The target may have run since the previous unwind, so each
+   unw_init_remote() starts with an empty copy of its registers and
+   memory; with UNW_CACHE_NONE, nothing is kept at all.  Returns whether
+   the copies may be used.  */
+HIDDEN int
+_UPT_validate_cache (unw_addr_space_t as, struct UPT_info *ui)
+{
+  uint32_t generation = atomic_load (&as->init_generation);
+
+  if (as->caching_policy == UNW_CACHE_NONE || ui->generation != generation)
+    {
+      _UPT_flush_target (ui);
+      ui->generation = generation;
+    }
+  return as->caching_policy != UNW_CACHE_NONE;
+}
+
+void
+_UPT_flush_cache (void *arg)
+{
+  struct UPT_info *ui = arg;
+
+  _UPT_flush_target (ui);
+  invalidate_edi (&ui->edi);
+  edi_cache_flush (&ui->edi_cache, 1);
+}
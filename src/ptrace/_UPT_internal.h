@@ -48,12 +48,57 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 
 #include "libunwind_i.h"
 
+/* Where the registers can only be fetched all at once, _UPT_access_reg()
+   keeps a copy of the whole register set.  */
+#if HAVE_DECL_PTRACE_SETREGSET && (defined(__linux__) && !defined(UNW_TARGET_X86))
+# define UPT_HAVE_REGSET 1
+typedef elf_gregset_t UPT_regset_t;
+#elif (HAVE_DECL_PTRACE_POKEUSER || defined(HAVE_TTRACE)) && (defined(__linux__) && !defined(UNW_TARGET_X86))
+/* registers are accessed one at a time */
+#elif defined(HAVE_DECL_PT_GETREGS) && defined(__linux__)
+# include <sys/user.h>
+# define UPT_HAVE_REGSET 1
+typedef struct user_regs_struct UPT_regset_t;
+#elif defined(HAVE_DECL_PT_GETREGS) && defined(__FreeBSD__)
+# define UPT_HAVE_REGSET 1
+typedef gregset_t UPT_regset_t;
+#endif
+
+/* On Linux, _UPT_access_mem() reads the child's memory in aligned
+   blocks that never straddle a page and keeps the most recently used
+   ones around.  */
+#if defined(__linux__) && HAVE_DECL_PTRACE_POKEDATA
+# define UPT_HAVE_MEM_CACHE 1
+# define UPT_MEM_BLOCK_SIZE     4096
+# define UPT_MEM_CACHE_BLOCKS   8
+
+struct UPT_mem_block
+  {
+    unw_word_t addr;    /* start of the block, 0 if unused */
+    unsigned char data[UPT_MEM_BLOCK_SIZE];
+  };
+#endif
+
 struct UPT_info
   {
     pid_t pid;          /* the process-id of the child we're unwinding */
+    uint32_t generation; /* as->init_generation of the cached target state */
     struct elf_dyn_info edi;
+    struct elf_dyn_info_cache edi_cache; /* tables of other objects */
+#ifdef UPT_HAVE_REGSET
+    int regs_valid;     /* does regs hold the current register set? */
+    UPT_regset_t regs;  /* (cached) register set of the child */
+#endif
+#ifdef UPT_HAVE_MEM_CACHE
+    struct UPT_mem_block *mem_cache;    /* (cached) memory of the child */
+    int mem_victim;     /* next block to be replaced */
+    int mem_fd;         /* /proc/<pid>/mem, -1 if not open yet, -2 if n/a */
+#endif
   };
 
 extern const int _UPT_reg_offset[UNW_REG_LAST + 1];
 
+extern void _UPT_flush_target (struct UPT_info *ui);
+extern int _UPT_validate_cache (unw_addr_space_t as, struct UPT_info *ui);
+
 #endif /* _UPT_internal_h */
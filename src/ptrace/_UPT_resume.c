@@ -32,6 +32,10 @@ _UPT_resume (unw_addr_space_t as UNUSED, unw_cursor_t *c UNUSED, void *arg)
 
   mi_init ();
 
+  /* The registers and memory will have changed by the time the child
+     stops again, but the unwind tables of its objects stay valid.  */
+  _UPT_flush_target (ui);
+
 #ifdef HAVE_TTRACE
 # warning No support for ttrace() yet.
 #elif HAVE_DECL_PTRACE_CONT
@@ -48,6 +48,8 @@ riscv_handle_signal_frame (unw_cursor_t *cursor)
   c->sigcontext_addr = sp_addr + sizeof (siginfo_t) + UC_MCONTEXT_REGS_OFF;
   c->sigcontext_sp = sp_addr;
   c->sigcontext_pc = c->dwarf.ip;
+  c->frame_info.frame_type = UNW_RISCV_FRAME_SIGRETURN;
+  c->frame_info.cfa_reg_offset = c->sigcontext_addr - sp_addr;
 #else
   /* Not making any assumption at all - You need to implement this */
   return -UNW_EUNSPEC;
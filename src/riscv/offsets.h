@@ -5,3 +5,10 @@
    https://github.com/torvalds/linux/blob/44db63d1ad8d71c6932cbe007eb41f31c434d140/arch/riscv/include/uapi/asm/ucontext.h
 */
 #define UC_MCONTEXT_REGS_OFF 176
+
+/* Offsets into the sigcontext (struct user_regs_struct); the PC is
+   stored in place of x0.  */
+#define SC_PC_OFF       0
+#define SC_RA_OFF       8       /* x1 */
+#define SC_SP_OFF       16      /* x2 */
+#define SC_FP_OFF       64      /* x8 (s0) */
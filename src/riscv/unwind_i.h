@@ -32,6 +32,11 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 
 #include "libunwind_i.h"
 
+/* DWARF column numbers for RISC-V: */
+#define RA      1
+#define SP      2
+#define FP      8
+
 #define riscv_lock                    UNW_OBJ(lock)
 #define riscv_local_resume            UNW_OBJ(local_resume)
 #define riscv_local_addr_space_init   UNW_OBJ(local_addr_space_init)
@@ -43,4 +48,16 @@ extern int riscv_local_resume (unw_addr_space_t as,
                                 void *arg);
 extern int setcontext (const ucontext_t *ucp);
 
+/* By-pass calls to access_mem() when known to be safe. */
+#ifdef UNW_LOCAL_ONLY
+# undef ACCESS_MEM_FAST
+# define ACCESS_MEM_FAST(ret,validate,cur,addr,to)                     \
+  do {                                                                 \
+    if (unlikely(validate))                                            \
+      (ret) = dwarf_get ((cur), DWARF_MEM_LOC ((cur), (addr)), &(to)); \
+    else                                                               \
+      (ret) = 0, (to) = *(unw_word_t *)(addr);                         \
+  } while (0)
+#endif
+
 #endif /* unwind_i_h */
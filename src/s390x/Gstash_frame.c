@@ -0,0 +1,91 @@
+/* libunwind - a platform-independent unwind library
+   Copyright (C) 2010, 2011 by FERMI NATIONAL ACCELERATOR LABORATORY
+   Copyright (C) 2014 CERN and Aalto University
+        Contributed by Filip Nyback
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "unwind_i.h"
+
+HIDDEN void
+tdep_stash_frame (struct dwarf_cursor *d, struct dwarf_reg_state *rs)
+{
+  struct cursor *c = (struct cursor *) dwarf_to_cursor (d);
+  unw_tdep_frame_t *f = &c->frame_info;
+
+  Debug (4, "ip=0x%lx cfa=0x%lx type %d cfa [where=%d val=%ld] cfaoff=%ld"
+         " ra=0x%lx r11 [where=%d val=%ld @0x%lx] r14 [where=%d val=%ld @0x%lx]"
+         " r15 [where=%d]\n",
+         d->ip, d->cfa, f->frame_type,
+         rs->reg.where[DWARF_CFA_REG_COLUMN],
+         rs->reg.val[DWARF_CFA_REG_COLUMN],
+         rs->reg.val[DWARF_CFA_OFF_COLUMN],
+         DWARF_GET_LOC(d->loc[rs->ret_addr_column]),
+         rs->reg.where[UNW_S390X_R11], rs->reg.val[UNW_S390X_R11], DWARF_GET_LOC(d->loc[UNW_S390X_R11]),
+         rs->reg.where[UNW_S390X_R14], rs->reg.val[UNW_S390X_R14], DWARF_GET_LOC(d->loc[UNW_S390X_R14]),
+         rs->reg.where[UNW_S390X_R15]);
+
+  /* A standard frame is defined as:
+      - CFA is register-relative offset off r15 or r11;
+      - Return address is saved in r14;
+      - r11 is unsaved or saved at CFA+offset, offset != -1;
+      - r14 is unsaved or saved at CFA+offset, offset != -1;
+      - r15 is unsaved or saved in the register save area, so that
+        the caller's r15 is CFA-160 as the ABI defines it.  */
+  if (f->frame_type == UNW_S390X_FRAME_OTHER
+      && (rs->reg.where[DWARF_CFA_REG_COLUMN] == DWARF_WHERE_REG)
+      && (rs->reg.val[DWARF_CFA_REG_COLUMN] == UNW_S390X_R11
+          || rs->reg.val[DWARF_CFA_REG_COLUMN] == UNW_S390X_R15)
+      && labs((long)rs->reg.val[DWARF_CFA_OFF_COLUMN]) < (1 << 29)
+      && rs->ret_addr_column == UNW_S390X_R14
+      && (rs->reg.where[UNW_S390X_R11] == DWARF_WHERE_UNDEF
+          || rs->reg.where[UNW_S390X_R11] == DWARF_WHERE_SAME
+          || rs->reg.where[UNW_S390X_R11] == DWARF_WHERE_CFA
+          || (rs->reg.where[UNW_S390X_R11] == DWARF_WHERE_CFAREL
+              && labs((long)rs->reg.val[UNW_S390X_R11]) < (1 << 29)
+              && rs->reg.val[UNW_S390X_R11]+1 != 0))
+      && (rs->reg.where[UNW_S390X_R14] == DWARF_WHERE_UNDEF
+          || rs->reg.where[UNW_S390X_R14] == DWARF_WHERE_SAME
+          || rs->reg.where[UNW_S390X_R14] == DWARF_WHERE_CFA
+          || (rs->reg.where[UNW_S390X_R14] == DWARF_WHERE_CFAREL
+              && labs((long)rs->reg.val[UNW_S390X_R14]) < (1 << 29)
+              && rs->reg.val[UNW_S390X_R14]+1 != 0))
+      && (rs->reg.where[UNW_S390X_R15] == DWARF_WHERE_SAME
+          || rs->reg.where[UNW_S390X_R15] == DWARF_WHERE_CFAREL))
+  {
+    /* Save information for a standard frame. */
+    f->frame_type = UNW_S390X_FRAME_STANDARD;
+    f->cfa_reg_sp = (rs->reg.val[DWARF_CFA_REG_COLUMN] == UNW_S390X_R15);
+    f->cfa_reg_offset = rs->reg.val[DWARF_CFA_OFF_COLUMN];
+    if (rs->reg.where[UNW_S390X_R11] == DWARF_WHERE_CFAREL)
+      f->fp_cfa_offset = rs->reg.val[UNW_S390X_R11];
+    if (rs->reg.where[UNW_S390X_R14] == DWARF_WHERE_CFAREL)
+      f->ra_cfa_offset = rs->reg.val[UNW_S390X_R14];
+    if (rs->reg.where[UNW_S390X_R11] == DWARF_WHERE_CFA)
+      f->fp_cfa_offset = 0;
+    if (rs->reg.where[UNW_S390X_R14] == DWARF_WHERE_CFA)
+      f->ra_cfa_offset = 0;
+    Debug (4, " standard frame\n");
+  }
+  else
+    Debug (4, " unusual frame\n");
+}
@@ -57,6 +57,8 @@ s390x_handle_signal_frame (unw_cursor_t *cursor)
       gprs = ((ucontext_t*)sc_addr)->uc_mcontext.gregs;
       fprs = (unw_word_t*)((ucontext_t*)sc_addr)->uc_mcontext.fpregs.fprs;
       psw  = &((ucontext_t*)sc_addr)->uc_mcontext.psw.addr;
+      c->frame_info.frame_type = UNW_S390X_FRAME_SIGRETURN;
+      c->frame_info.cfa_reg_offset = sc_addr - sp;
       break;
     default:
       return -UNW_EUNSPEC;
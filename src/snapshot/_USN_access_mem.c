@@ -0,0 +1,75 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+/* Memory is read from the stack copy of the sample if it covers the
+   address, and otherwise from the file behind the mapping.  For
+   writable mappings that gives the initial contents, which is all a
+   sample without a copy of them can offer.  */
+int
+_USN_access_mem (unw_addr_space_t  as,
+                 unw_word_t        addr,
+                 unw_word_t       *val,
+                 int               write,
+                 void             *arg)
+{
+  struct USN_info *ui = arg;
+  struct USN_map *map;
+  struct USN_file *file;
+  unw_word_t off;
+
+  if (write)
+    {
+      Debug (0, "write is not supported\n");
+      return -UNW_EINVAL;
+    }
+
+  if (addr >= ui->stack_addr
+      && ui->stack_size >= sizeof (*val)
+      && addr - ui->stack_addr <= ui->stack_size - sizeof (*val))
+    {
+      memcpy (val, ui->stack + (addr - ui->stack_addr), sizeof (*val));
+      Debug (16, "%#010llx <- [addr:%#010llx stack]\n",
+             (unsigned long long) *val, (unsigned long long) addr);
+      return UNW_ESUCCESS;
+    }
+
+  map = _USN_find_map (ui, addr);
+  if (map && addr + sizeof (*val) - 1 - map->start < map->end - map->start
+      && (file = _USN_map_file (ui, as, map)))
+    {
+      off = map->offset + (addr - map->start);
+      if (off < file->ei.size && file->ei.size - off >= sizeof (*val))
+        {
+          memcpy (val, (uint8_t *) file->ei.image + off, sizeof (*val));
+          Debug (16, "%#010llx <- [addr:%#010llx file:%s]\n",
+                 (unsigned long long) *val, (unsigned long long) addr,
+                 file->filename);
+          return UNW_ESUCCESS;
+        }
+    }
+
+  Debug (1, "addr %#010llx is not in the sample\n", (unsigned long long) addr);
+  return -UNW_EINVAL;
+}
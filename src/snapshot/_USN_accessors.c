@@ -0,0 +1,37 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+unw_accessors_t _USN_accessors =
+  {
+    .find_proc_info             = _USN_find_proc_info,
+    .put_unwind_info            = _USN_put_unwind_info,
+    .get_dyn_info_list_addr     = _USN_get_dyn_info_list_addr,
+    .access_mem                 = _USN_access_mem,
+    .access_reg                 = _USN_access_reg,
+    .access_fpreg               = _USN_access_fpreg,
+    .resume                     = _USN_resume,
+    .get_proc_name              = _USN_get_proc_name,
+    .get_elf_filename           = _USN_get_elf_filename
+  };
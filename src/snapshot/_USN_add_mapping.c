@@ -0,0 +1,169 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+/* Return the index of the file FILENAME with the given build-id,
+   adding it if it is new.  */
+static int
+get_file (struct USN_info *ui, const char *filename,
+          const void *build_id, size_t build_id_len)
+{
+  struct USN_file *file;
+  unsigned i;
+
+  for (i = 0; i < ui->files_count; i++)
+    {
+      file = &ui->files[i];
+      if (strcmp (file->filename, filename) == 0
+          && file->build_id_len == build_id_len
+          && (build_id_len == 0
+              || memcmp (file->build_id, build_id, build_id_len) == 0))
+        return i;
+    }
+
+  if (ui->files_count == ui->files_size)
+    {
+      unsigned size = ui->files_size ? 2 * ui->files_size : 16;
+
+      file = realloc (ui->files, size * sizeof (*file));
+      if (!file)
+        return -UNW_ENOMEM;
+      ui->files = file;
+      ui->files_size = size;
+    }
+
+  file = &ui->files[ui->files_count];
+  memset (file, 0, sizeof (*file));
+  if (!(file->filename = strdup (filename)))
+    return -UNW_ENOMEM;
+  if (build_id_len > 0)
+    {
+      if (!(file->build_id = malloc (build_id_len)))
+        {
+          free (file->filename);
+          return -UNW_ENOMEM;
+        }
+      memcpy (file->build_id, build_id, build_id_len);
+      file->build_id_len = build_id_len;
+    }
+  file->state = USN_UNTRIED;
+  return ui->files_count++;
+}
+
+/* Make MAP cover only START..END, a part of what it covered.  */
+static void
+trim_map (struct USN_map *map, unw_word_t start, unw_word_t end)
+{
+  map->offset += start - map->start;
+  map->start = start;
+  map->end = end;
+  map->edi_state = USN_UNTRIED;
+  invalidate_edi (&map->edi);
+}
+
+/* Insert MAP into the sorted array of UI, which must have room.  */
+static void
+insert_map (struct USN_info *ui, const struct USN_map *map)
+{
+  unsigned i;
+
+  for (i = ui->maps_count; i > 0 && ui->maps[i - 1].start > map->start; i--)
+    continue;
+  memmove (&ui->maps[i + 1], &ui->maps[i],
+           (ui->maps_count - i) * sizeof (*map));
+  ui->maps[i] = *map;
+  ui->maps_count++;
+}
+
+/* Add the mapping of FILENAME at OFFSET to START..END.  If BUILD_ID is
+   not NULL, the file is only used if its GNU build-id note matches the
+   BUILD_ID_LEN bytes at BUILD_ID.  As with mmap(), the new mapping
+   replaces what it overlaps of older mappings; their parts outside
+   START..END stay.  */
+int
+_USN_add_mapping (struct USN_info *ui, unw_word_t start, unw_word_t end,
+                  unw_word_t offset, const char *filename,
+                  const void *build_id, size_t build_id_len)
+{
+  struct USN_map *map, new_map, tail;
+  int file_index, have_tail = 0;
+  unsigned i, n;
+
+  if (start >= end || !filename)
+    return -UNW_EINVAL;
+  if (!build_id)
+    build_id_len = 0;
+
+  if ((file_index = get_file (ui, filename, build_id, build_id_len)) < 0)
+    return file_index;
+
+  /* Make room for the new mapping and for the tail of one it splits.  */
+  if (ui->maps_count + 2 > ui->maps_size)
+    {
+      unsigned size = ui->maps_size ? 2 * ui->maps_size : 16;
+
+      map = realloc (ui->maps, size * sizeof (*map));
+      if (!map)
+        return -UNW_ENOMEM;
+      ui->maps = map;
+      ui->maps_size = size;
+    }
+
+  for (i = n = 0; i < ui->maps_count; i++)
+    {
+      map = &ui->maps[i];
+      if (map->start < end && start < map->end)
+        {
+          Debug (3, "mapping %#lx-%#lx overlapped\n",
+                 (long) map->start, (long) map->end);
+          release_edi (&map->edi, 0);
+          if (end < map->end)
+            {
+              tail = *map;
+              trim_map (&tail, end, map->end);
+              have_tail = 1;
+            }
+          if (map->start >= start)
+            continue;
+          trim_map (map, map->start, start);
+        }
+      if (n != i)
+        ui->maps[n] = *map;
+      n++;
+    }
+  ui->maps_count = n;
+  ui->last_map = NULL;
+  if (have_tail)
+    insert_map (ui, &tail);
+
+  memset (&new_map, 0, sizeof (new_map));
+  new_map.start = start;
+  new_map.end = end;
+  new_map.offset = offset;
+  new_map.file_index = file_index;
+  new_map.edi_state = USN_UNTRIED;
+  invalidate_edi (&new_map.edi);
+  insert_map (ui, &new_map);
+  return 0;
+}
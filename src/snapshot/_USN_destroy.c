@@ -0,0 +1,49 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+void
+_USN_destroy (struct USN_info *ui)
+{
+  unsigned i;
+
+  if (!ui)
+    return;
+
+  for (i = 0; i < ui->maps_count; i++)
+    release_edi (&ui->maps[i].edi, 0);
+  free (ui->maps);
+
+  for (i = 0; i < ui->files_count; i++)
+    {
+      if (ui->files[i].ei.image)
+        mi_munmap (ui->files[i].ei.image, ui->files[i].ei.size);
+      free (ui->files[i].filename);
+      free (ui->files[i].build_id);
+    }
+  free (ui->files);
+
+  free (ui->regs);
+  free (ui);
+}
@@ -0,0 +1,20 @@
+/* We need to get a separate copy of the ELF-code into
+   libunwind-snapshot since it cannot (and must not) have any ELF
+   dependencies on libunwind.  */
+#include "_USN_internal.h"
+#include "../elfxx.c"
+
+/* Does the image of FILE have the build-id FILE was added with?
+   Returns 0 if it does, -1 otherwise.  */
+HIDDEN int
+_USN_check_build_id (struct USN_file *file)
+{
+  const uint8_t *id;
+  size_t len;
+
+  if (elf_w (find_build_id) (&file->ei, &id, &len) < 0)
+    return -1;
+  if (len != file->build_id_len || memcmp (id, file->build_id, len) != 0)
+    return -1;
+  return 0;
+}
@@ -0,0 +1,82 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+/* Return the mapping that contains ADDR, or NULL.  */
+HIDDEN struct USN_map *
+_USN_find_map (struct USN_info *ui, unw_word_t addr)
+{
+  struct USN_map *map = ui->last_map;
+  unsigned lo, hi, mid;
+
+  if (map && addr >= map->start && addr < map->end)
+    return map;
+
+  lo = 0;
+  hi = ui->maps_count;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      map = &ui->maps[mid];
+      if (addr < map->start)
+        hi = mid;
+      else if (addr >= map->end)
+        lo = mid + 1;
+      else
+        {
+          ui->last_map = map;
+          return map;
+        }
+    }
+  return NULL;
+}
+
+/* Return the file of MAP with its image mapped, or NULL if it cannot
+   be used.  Each file is mapped and checked only once.  */
+HIDDEN struct USN_file *
+_USN_map_file (struct USN_info *ui, unw_addr_space_t as, struct USN_map *map)
+{
+  struct USN_file *file = &ui->files[map->file_index];
+
+  if (file->state == USN_UNTRIED)
+    {
+      file->state = USN_FAILED;
+      if (elf_map_image (&file->ei, file->filename) < 0)
+        Debug (1, "cannot map \"%s\"\n", file->filename);
+      else if (file->build_id && _USN_check_build_id (file) < 0)
+        {
+          Debug (1, "\"%s\" does not have the expected build-id\n",
+                 file->filename);
+          mi_munmap (file->ei.image, file->ei.size);
+          file->ei.image = NULL;
+          file->ei.size = 0;
+        }
+      else
+        {
+          unwi_stats_inc (as, UNWI_STAT_ELF_MAP);
+          file->state = USN_OK;
+        }
+    }
+  return file->state == USN_OK ? file : NULL;
+}
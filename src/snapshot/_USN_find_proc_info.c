@@ -0,0 +1,89 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+/* Find the unwind tables of the object mapped at MAP, once.  */
+static int
+get_unwind_info (struct USN_info *ui, unw_addr_space_t as,
+                 struct USN_map *map, unw_word_t ip)
+{
+  struct USN_file *file;
+
+  if (map->edi_state == USN_UNTRIED)
+    {
+      map->edi_state = USN_FAILED;
+      if ((file = _USN_map_file (ui, as, map)))
+        {
+          map->edi.ei = file->ei;
+          if (tdep_find_unwind_table (&map->edi, as, file->filename,
+                                      map->start, map->offset, ip) >= 0
+              && edi_is_valid (&map->edi))
+            map->edi_state = USN_OK;
+          else
+            {
+              Debug (1, "no unwind info in \"%s\"\n", file->filename);
+            }
+        }
+    }
+  return map->edi_state == USN_OK ? 0 : -UNW_ENOINFO;
+}
+
+int
+_USN_find_proc_info (unw_addr_space_t as, unw_word_t ip, unw_proc_info_t *pi,
+                     int need_unwind_info, void *arg)
+{
+  struct USN_info *ui = arg;
+  struct USN_map *map;
+  int ret = -UNW_ENOINFO;
+
+  if (!(map = _USN_find_map (ui, ip))
+      || get_unwind_info (ui, as, map, ip) < 0)
+    {
+      Debug (1, "no unwind info for ip %#lx\n", (long) ip);
+      return -UNW_ENOINFO;
+    }
+
+  if (map->edi.di_cache.format != -1)
+    ret = tdep_search_unwind_table (as, ip, &map->edi.di_cache,
+                                    pi, need_unwind_info, arg);
+
+#if UNW_TARGET_ARM
+  /* .debug_frame before .ARM.exidx, as for coredumps: exidx CANTUNWIND
+     entries of leaf functions cover the following function, too.  */
+  if (ret == -UNW_ENOINFO && map->edi.di_debug.format != -1)
+    ret = tdep_search_unwind_table (as, ip, &map->edi.di_debug, pi,
+                                    need_unwind_info, arg);
+
+  if (ret == -UNW_ENOINFO && map->edi.di_arm.format != -1)
+    ret = tdep_search_unwind_table (as, ip, &map->edi.di_arm, pi,
+                                    need_unwind_info, arg);
+#else
+  if (ret == -UNW_ENOINFO && map->edi.di_debug.format != -1)
+    ret = tdep_search_unwind_table (as, ip, &map->edi.di_debug, pi,
+                                    need_unwind_info, arg);
+#endif
+
+  Debug (15, "returns %d\n", ret);
+  return ret;
+}
@@ -0,0 +1,51 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+int
+_USN_get_elf_filename (unw_addr_space_t as UNUSED, unw_word_t ip,
+                       char *buf, size_t buf_len, unw_word_t *offp, void *arg)
+{
+  struct USN_info *ui = arg;
+  struct USN_map *map;
+  const char *filename;
+  int ret = UNW_ESUCCESS;
+
+  if (!(map = _USN_find_map (ui, ip)))
+    return -UNW_ENOINFO;
+  filename = ui->files[map->file_index].filename;
+
+  if (buf)
+    {
+      strncpy (buf, filename, buf_len);
+      buf[buf_len - 1] = '\0';
+      if (strlen (filename) >= buf_len)
+        ret = -UNW_ENOMEM;
+    }
+
+  if (offp)
+    *offp = ip - map->start + map->offset;
+
+  return ret;
+}
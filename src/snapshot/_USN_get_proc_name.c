@@ -0,0 +1,73 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+#if defined(HAVE_ELF_H)
+# include <elf.h>
+#elif defined(HAVE_SYS_ELF_H)
+# include <sys/elf.h>
+#endif
+
+static int
+elf_w (SN_get_proc_name) (struct USN_info *ui, unw_addr_space_t as,
+                          unw_word_t ip, char *buf, size_t buf_len,
+                          unw_word_t *offp)
+{
+  struct USN_map *map;
+  struct USN_file *file;
+  int ret;
+
+  if (!(map = _USN_find_map (ui, ip)) || !(file = _USN_map_file (ui, as, map)))
+    return -UNW_ENOINFO;
+
+  ret = elf_w (get_proc_name_in_image) (as, &file->ei, map->start, ip,
+                                        buf, buf_len, offp, ui);
+  if (ret == -UNW_ENOINFO)
+    {
+      /* maybe symtab is stripped, try debuglink */
+      struct elf_image ei = {NULL, 0};
+
+      if (elf_w (load_debuginfo) (file->filename, &ei, 1) == 0)
+        {
+          ret = elf_w (get_proc_name_in_image) (as, &ei, map->start, ip,
+                                                buf, buf_len, offp, ui);
+          mi_munmap (ei.image, ei.size);
+        }
+    }
+  return ret;
+}
+
+int
+_USN_get_proc_name (unw_addr_space_t as, unw_word_t ip,
+                    char *buf, size_t buf_len, unw_word_t *offp, void *arg)
+{
+  struct USN_info *ui = arg;
+#if UNW_ELF_CLASS == UNW_ELFCLASS64
+  return _Uelf64_SN_get_proc_name (ui, as, ip, buf, buf_len, offp);
+#elif UNW_ELF_CLASS == UNW_ELFCLASS32
+  return _Uelf32_SN_get_proc_name (ui, as, ip, buf, buf_len, offp);
+#else
+  return -UNW_ENOINFO;
+#endif
+}
@@ -0,0 +1,91 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#ifndef _USN_internal_h
+#define _USN_internal_h
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libunwind-snapshot.h>
+
+#include "libunwind_i.h"
+
+/* An object file named by one or more mappings.  It is mapped the first
+   time it is needed and stays mapped until _USN_destroy(), so that its
+   unwind tables are found once however many samples refer to it.  */
+struct USN_file
+  {
+    char       *filename;
+    uint8_t    *build_id;       /* expected build-id, or NULL */
+    size_t      build_id_len;
+    struct elf_image ei;        /* image, if mapped */
+    int         state;          /* USN_UNTRIED, USN_OK or USN_FAILED */
+  };
+
+/* A mapping of the sampled process.  */
+struct USN_map
+  {
+    unw_word_t  start;
+    unw_word_t  end;            /* exclusive */
+    unw_word_t  offset;         /* file offset mapped at START */
+    int         file_index;     /* into USN_info.files */
+    int         edi_state;      /* were the unwind tables looked up? */
+    struct elf_dyn_info edi;    /* unwind tables; the image is the file's */
+  };
+
+#define USN_UNTRIED     0
+#define USN_OK          1
+#define USN_FAILED      (-1)
+
+struct USN_info
+  {
+    struct USN_file *files;     /* array, allocated */
+    unsigned         files_count;
+    unsigned         files_size;
+    struct USN_map  *maps;      /* array sorted by start, allocated */
+    unsigned         maps_count;
+    unsigned         maps_size;
+    struct USN_map  *last_map;  /* last hit of _USN_find_map() */
+
+    /* The current sample.  The stack contents belong to the caller.  */
+    unw_word_t      *regs;      /* array, allocated */
+    unsigned         nregs;
+    unsigned         regs_size;
+    unw_word_t       stack_addr;
+    const uint8_t   *stack;
+    size_t           stack_size;
+  };
+
+struct USN_map *_USN_find_map (struct USN_info *ui, unw_word_t addr);
+struct USN_file *_USN_map_file (struct USN_info *ui, unw_addr_space_t as,
+                                struct USN_map *map);
+int _USN_check_build_id (struct USN_file *file);
+
+#endif
@@ -0,0 +1,53 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+#include "_USN_internal.h"
+
+/* Make REGS the registers and STACK the copy of the stack from
+   STACK_ADDR on of the sample to unwind next.  REGS is indexed by
+   libunwind register number; registers from NREGS on are unknown.  The
+   registers are copied, the stack is not: it must stay valid while the
+   sample is unwound.  */
+int
+_USN_set_sample (struct USN_info *ui, const unw_word_t *regs,
+                 unsigned int nregs, unw_word_t stack_addr,
+                 const void *stack, size_t stack_size)
+{
+  if (nregs > ui->regs_size)
+    {
+      unw_word_t *r = realloc (ui->regs, nregs * sizeof (*r));
+
+      if (!r)
+        return -UNW_ENOMEM;
+      ui->regs = r;
+      ui->regs_size = nregs;
+    }
+  if (nregs > 0)
+    memcpy (ui->regs, regs, nregs * sizeof (*regs));
+  ui->nregs = nregs;
+
+  ui->stack_addr = stack_addr;
+  ui->stack = stack;
+  ui->stack_size = stack ? stack_size : 0;
+  return 0;
+}
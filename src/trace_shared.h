@@ -0,0 +1,343 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* Process-wide frame cache for the fast trace implementations in
+   src/<arch>/Gtrace.c.  By default each thread classifies frames into
+   its own hash table.  With UNW_TRACE_CACHE=shared the classifications
+   go into a single table that all threads read without locking; with
+   UNW_TRACE_CACHE=shared,thread a small per-thread table sits in front
+   of the shared one.
+
+   Shared table slots are published once and never change afterwards:
+   an inserter claims an empty slot by swinging its key from 0 to
+   TRACE_SHARED_BUSY, fills in the frame and then release-stores the
+   address as key.  Readers acquire-load the key and may copy the frame
+   once the key matches.  Growing the table is serialised by a lock and
+   copies published slots into a table four times larger.  After
+   unw_flush_cache() the next insert replaces the table with an empty
+   one instead.  Readers and inserters may still be using a replaced
+   table, so it is retired and only freed once none is active.
+
+   Both kinds of table remember the cache generation of the local
+   address space they were filled in, and are emptied when it changes,
+   so that frames of unloaded objects are not used.  */
+
+#ifndef trace_shared_h
+#define trace_shared_h
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_CACHE_THREAD      0x1     /* per-thread table */
+#define TRACE_CACHE_SHARED      0x2     /* process-wide table */
+
+#define TRACE_SHARED_MIN_BITS   12      /* initial shared table size */
+#define TRACE_SHARED_MAX_BITS   22      /* stop growing beyond this */
+#define TRACE_SHARED_PROBES     16      /* linear probes per lookup */
+#define TRACE_L1_BITS           8       /* per-thread table in front of it */
+
+#define TRACE_SHARED_BUSY       ((unw_word_t) -1)
+
+struct trace_shared_slot
+  {
+    _Atomic unw_word_t key;     /* 0, TRACE_SHARED_BUSY or the address */
+    unw_tdep_frame_t frame;
+  };
+
+struct trace_shared_table
+  {
+    size_t log_size;
+    _Atomic size_t used;
+    size_t mem_size;
+    uint32_t generation;
+    struct trace_shared_table *retired; /* replaced, waiting to be freed */
+    struct trace_shared_slot slots[];
+  };
+
+static _Atomic (struct trace_shared_table *) trace_shared;
+static _Atomic unsigned long trace_shared_users;
+static struct trace_shared_table *trace_shared_retired;
+static define_lock (trace_shared_lock);
+static _Atomic int trace_cache_mode;
+
+static unw_tdep_frame_t *trace_init_addr (unw_tdep_frame_t *f,
+                                          unw_cursor_t *cursor,
+                                          unw_word_t cfa,
+                                          unw_word_t pc,
+                                          unw_word_t fp,
+                                          unw_word_t sp);
+
+/* Return the TRACE_CACHE_* mask selected by UNW_TRACE_CACHE.  */
+static inline int
+trace_cache_get_mode (void)
+{
+  int mode = atomic_load_explicit (&trace_cache_mode, memory_order_relaxed);
+
+  if (unlikely (mode == 0))
+    {
+      const char *str = getenv ("UNW_TRACE_CACHE");
+
+      mode = TRACE_CACHE_THREAD;
+      if (str && strcmp (str, "shared") == 0)
+        mode = TRACE_CACHE_SHARED;
+      else if (str && (strcmp (str, "shared,thread") == 0
+                       || strcmp (str, "thread,shared") == 0))
+        mode = TRACE_CACHE_SHARED | TRACE_CACHE_THREAD;
+      atomic_store_explicit (&trace_cache_mode, mode, memory_order_relaxed);
+    }
+  return mode;
+}
+
+static inline uint32_t
+trace_cache_generation (void)
+{
+  return atomic_load_explicit (&unw_local_addr_space->cache_generation,
+                               memory_order_relaxed);
+}
+
+static inline size_t
+trace_shared_hash (unw_word_t ip, size_t log_size)
+{
+  return ((uint64_t) ip * 0x9e3779b97f4a7c16ULL) >> (64 - log_size);
+}
+
+/* Return the published frame for IP in TABLE, or NULL.  */
+static unw_tdep_frame_t *
+trace_shared_find (struct trace_shared_table *table, unw_word_t ip)
+{
+  size_t mask = ((size_t) 1 << table->log_size) - 1;
+  size_t slot = trace_shared_hash (ip, table->log_size);
+  unw_word_t key;
+  int i;
+
+  for (i = 0; i < TRACE_SHARED_PROBES; ++i)
+    {
+      key = atomic_load_explicit (&table->slots[slot].key,
+                                  memory_order_acquire);
+      if (key == ip)
+        return &table->slots[slot].frame;
+      if (key == 0)
+        break;
+      slot = (slot + 1) & mask;
+    }
+  return NULL;
+}
+
+/* Replace OLD with a table four times larger holding the same frames,
+   or with an empty one if OLD is of an earlier cache generation.
+   Returns 0 if a new table is available, either ours or one another
+   thread installed meanwhile, or -1 if the table cannot grow.  Must be
+   called outside of trace_shared_enter() .. trace_shared_leave().  */
+static int
+trace_shared_expand (struct trace_shared_table *old)
+{
+  struct trace_shared_table *table, *next;
+  intrmask_t saved_mask;
+  size_t log_size, mem_size, i, slot, mask;
+  uint32_t generation = trace_cache_generation ();
+  unw_word_t key;
+  int ret = 0;
+
+  lock_acquire (&trace_shared_lock, saved_mask);
+  if (atomic_load_explicit (&trace_shared, memory_order_relaxed) != old)
+    goto out;
+
+  log_size = TRACE_SHARED_MIN_BITS;
+  if (old && old->generation == generation)
+    log_size = old->log_size + 2;
+  else
+    old = NULL;         /* nothing to copy */
+  if (log_size > TRACE_SHARED_MAX_BITS)
+    {
+      ret = -1;
+      goto out;
+    }
+
+  mem_size = sizeof (*table)
+             + ((size_t) 1 << log_size) * sizeof (table->slots[0]);
+  GET_MEMORY (table, mem_size);
+  if (unlikely (! table))
+    {
+      ret = -1;
+      goto out;
+    }
+  table->log_size = log_size;
+  table->mem_size = mem_size;
+  table->generation = generation;
+  table->retired = NULL;
+  atomic_init (&table->used, 0);
+  mask = ((size_t) 1 << log_size) - 1;
+
+  /* Frames still being inserted into OLD are lost; they are simply
+     classified again on a later miss.  */
+  for (i = 0; old && i < ((size_t) 1 << old->log_size); ++i)
+    {
+      key = atomic_load_explicit (&old->slots[i].key, memory_order_acquire);
+      if (key == 0 || key == TRACE_SHARED_BUSY)
+        continue;
+      for (slot = trace_shared_hash (key, log_size);
+           atomic_load_explicit (&table->slots[slot].key,
+                                 memory_order_relaxed) != 0;
+           slot = (slot + 1) & mask)
+        continue;
+      table->slots[slot].frame = old->slots[i].frame;
+      atomic_init (&table->slots[slot].key, key);
+      ++table->used;
+    }
+
+  Debug (3, "shared trace cache replaced by %zu slots\n",
+         (size_t) 1 << log_size);
+  old = atomic_exchange (&trace_shared, table);
+  if (old)
+    {
+      old->retired = trace_shared_retired;
+      trace_shared_retired = old;
+    }
+  if (old && old->generation == generation)
+    unwi_stats_inc (unw_local_addr_space, UNWI_STAT_TRACE_CACHE_EXPAND);
+
+  /* Users arriving from now on find the new table.  */
+  if (atomic_load (&trace_shared_users) == 0)
+    {
+      for (table = trace_shared_retired; table; table = next)
+        {
+          next = table->retired;
+          mi_munmap (table, table->mem_size);
+        }
+      trace_shared_retired = NULL;
+    }
+
+ out:
+  lock_release (&trace_shared_lock, saved_mask);
+  return ret;
+}
+
+/* Bracket any use of the table that trace_shared_enter() returns.  */
+static inline struct trace_shared_table *
+trace_shared_enter (void)
+{
+  atomic_fetch_add (&trace_shared_users, 1);
+  return atomic_load (&trace_shared);
+}
+
+static inline void
+trace_shared_leave (void)
+{
+  atomic_fetch_sub (&trace_shared_users, 1);
+}
+
+/* Publish a copy of frame F in the shared table.  Failure to insert is
+   not an error, the frame is just not cached.  */
+static void
+trace_shared_insert (const unw_tdep_frame_t *f)
+{
+  struct trace_shared_table *table;
+  unw_word_t ip = f->virtual_address;
+  unw_word_t expected;
+  size_t mask, slot;
+  int i, done;
+
+  if (unlikely (ip == 0 || ip == TRACE_SHARED_BUSY))
+    return;
+
+  for (;;)
+    {
+      done = 0;
+      table = trace_shared_enter ();
+      if (table && table->generation == trace_cache_generation ()
+          && table->used < ((size_t) 1 << table->log_size) / 2)
+        {
+          mask = ((size_t) 1 << table->log_size) - 1;
+          slot = trace_shared_hash (ip, table->log_size);
+          for (i = 0; i < TRACE_SHARED_PROBES && !done; ++i)
+            {
+              struct trace_shared_slot *s = &table->slots[slot];
+
+              expected = 0;
+              if (atomic_compare_exchange_strong (&s->key, &expected,
+                                                  TRACE_SHARED_BUSY))
+                {
+                  s->frame = *f;
+                  atomic_store_explicit (&s->key, ip, memory_order_release);
+                  atomic_fetch_add_explicit (&table->used, 1,
+                                             memory_order_relaxed);
+                  done = 1;
+                }
+              else if (expected == ip)
+                done = 1;
+              slot = (slot + 1) & mask;
+            }
+        }
+      trace_shared_leave ();
+
+      if (done || trace_shared_expand (table) < 0)
+        return;
+    }
+}
+
+/* Look up the frame at IP in the shared table and copy it to SCRATCH.
+   On a miss classify it into SCRATCH with trace_init_addr() and publish
+   the result.  Returns SCRATCH.  */
+static unw_tdep_frame_t *
+trace_shared_lookup (unw_cursor_t *cursor,
+                     unw_tdep_frame_t *scratch,
+                     unw_word_t cfa,
+                     unw_word_t pc,
+                     unw_word_t fp,
+                     unw_word_t sp)
+{
+  struct trace_shared_table *table;
+  unw_tdep_frame_t *f = NULL;
+
+  table = trace_shared_enter ();
+  if (likely (table != NULL)
+      && likely (table->generation == trace_cache_generation ())
+      && (f = trace_shared_find (table, pc)))
+    *scratch = *f;
+  trace_shared_leave ();
+  if (f)
+    return scratch;
+
+  f = trace_init_addr (scratch, cursor, cfa, pc, fp, sp);
+  trace_shared_insert (f);
+  return f;
+}
+
+/* Fill per-thread cache slot F for address PC.  In layered mode the
+   shared table is consulted first, otherwise this is trace_init_addr().  */
+static unw_tdep_frame_t *
+trace_cache_fill (unw_tdep_frame_t *f,
+                  unw_cursor_t *cursor,
+                  unw_word_t cfa,
+                  unw_word_t pc,
+                  unw_word_t fp,
+                  unw_word_t sp)
+{
+  if (! (trace_cache_get_mode () & TRACE_CACHE_SHARED))
+    return trace_init_addr (f, cursor, cfa, pc, fp, sp);
+
+  return trace_shared_lookup (cursor, f, cfa, pc, fp, sp);
+}
+
+#endif /* trace_shared_h */
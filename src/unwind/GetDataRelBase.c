@@ -30,6 +30,9 @@ _Unwind_GetDataRelBase (struct _Unwind_Context *context)
 {
   unw_proc_info_t pi;
 
+  if (context->pi)
+    return context->pi->gp;
+
   pi.gp = 0;
   unw_get_proc_info (&context->cursor, &pi);
   return pi.gp;
@@ -30,6 +30,9 @@ _Unwind_GetLanguageSpecificData (struct _Unwind_Context *context)
 {
   unw_proc_info_t pi;
 
+  if (context->pi)
+    return context->pi->lsda;
+
   pi.lsda = 0;
   unw_get_proc_info (&context->cursor, &pi);
   return pi.lsda;
@@ -30,6 +30,9 @@ _Unwind_GetRegionStart (struct _Unwind_Context *context)
 {
   unw_proc_info_t pi;
 
+  if (context->pi)
+    return context->pi->start_ip;
+
   pi.start_ip = 0;
   unw_get_proc_info (&context->cursor, &pi);
   return pi.start_ip;
@@ -25,13 +25,47 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
 
 #include "unwind-internal.h"
 
+HIDDEN thread_local struct _Unwind_Phase1_Record _U_phase1_record;
+
+/* Note a frame of the search phase in RECORD.  Returns 0 if the frame
+   cannot be recorded, because it does not lie outside the frames seen
+   before it and hence the cleanup phase could not tell the frames
+   apart by their stack pointers.  */
+static int
+record_frame (struct _Unwind_Phase1_Record *record, unw_cursor_t *cursor,
+              unw_word_t *last_sp, const unw_proc_info_t *pi)
+{
+  struct _Unwind_Phase1_Frame *frame;
+  unw_word_t sp;
+
+  if (unw_get_reg (cursor, UNW_REG_SP, &sp) < 0
+      || (*last_sp != 0 && sp <= *last_sp))
+    return 0;
+  *last_sp = sp;
+
+  if (!pi->handler || record->nframes >= _U_PHASE1_MAX_FRAMES)
+    return 1;
+
+  frame = &record->frames[record->nframes];
+  if (unw_get_reg (cursor, UNW_REG_IP, &frame->ip) < 0)
+    return 0;
+  frame->sp = sp;
+  frame->pi = *pi;
+  frame->pi.unwind_info = NULL;
+  frame->pi.unwind_info_size = 0;
+  ++record->nframes;
+  return 1;
+}
+
 _Unwind_Reason_Code
 _Unwind_RaiseException (struct _Unwind_Exception *exception_object)
 {
+  struct _Unwind_Phase1_Record *record = &_U_phase1_record;
   uint64_t exception_class = exception_object->exception_class;
   _Unwind_Personality_Fn personality;
   struct _Unwind_Context context;
   _Unwind_Reason_Code reason;
+  unw_word_t last_sp = 0;
   unw_proc_info_t pi;
   unw_context_t uc;
   unw_word_t ip;
@@ -42,6 +76,9 @@ _Unwind_RaiseException (struct _Unwind_Exception *exception_object)
   if (_Unwind_InitContext (&context, &uc) < 0)
     return _URC_FATAL_PHASE1_ERROR;
 
+  record->exception_object = NULL;
+  record->nframes = 0;
+
   /* Phase 1 (search phase) */
 
   while (1)
@@ -57,8 +94,16 @@ _Unwind_RaiseException (struct _Unwind_Exception *exception_object)
             return _URC_FATAL_PHASE1_ERROR;
         }
 
+      context.pi = NULL;
       if (unw_get_proc_info (&context.cursor, &pi) < 0)
         return _URC_FATAL_PHASE1_ERROR;
+      context.pi = &pi;
+
+      if (record && !record_frame (record, &context.cursor, &last_sp, &pi))
+        {
+          Debug (2, "not recording the search phase\n");
+          record = NULL;
+        }
 
       personality = (_Unwind_Personality_Fn) (uintptr_t) pi.handler;
       if (personality)
@@ -89,9 +134,16 @@ _Unwind_RaiseException (struct _Unwind_Exception *exception_object)
   exception_object->private_1 = 0;      /* clear "stop" pointer */
   exception_object->private_2 = ip;     /* save frame marker */
 
+  if (record)
+    {
+      record->handler_ip = ip;
+      record->exception_object = exception_object;
+    }
+
   Debug (1, "found handler for IP=%lx; entering cleanup phase\n", (long) ip);
 
   /* Reset the cursor to the first frame: */
+  context.pi = NULL;
   if (unw_init_local (&context.cursor, &uc) < 0)
     return _URC_FATAL_PHASE1_ERROR;
 
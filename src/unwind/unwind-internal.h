@@ -49,16 +49,71 @@ typedef _Unwind_Reason_Code (*_Unwind_Personality_Fn)
 struct _Unwind_Context {
   unw_cursor_t cursor;
   int end_of_stack;     /* set to 1 if the end of stack was reached */
+  const unw_proc_info_t *pi;    /* proc-info of the current frame or NULL */
 };
 
+/* The frames for which the search phase of _Unwind_RaiseException()
+   called a personality routine, innermost first.  The cleanup phase of
+   the same exception, including its continuations via _Unwind_Resume(),
+   replays them instead of looking up the proc-info of every frame
+   again.  Frames beyond the last entry take the normal path.  */
+#define _U_PHASE1_MAX_FRAMES    32
+
+struct _Unwind_Phase1_Frame {
+  unw_word_t ip;
+  unw_word_t sp;
+  unw_proc_info_t pi;           /* without unwind_info */
+};
+
+struct _Unwind_Phase1_Record {
+  struct _Unwind_Exception *exception_object;   /* NULL if not valid */
+  unw_word_t handler_ip;
+  unsigned int nframes;
+  struct _Unwind_Phase1_Frame frames[_U_PHASE1_MAX_FRAMES];
+};
+
+extern HIDDEN thread_local struct _Unwind_Phase1_Record _U_phase1_record;
+
 /* This must be a macro because unw_getcontext() must be invoked from
    the callee, even if optimization (and hence inlining) is turned
    off.  The macro arguments MUST NOT have any side-effects. */
 #define _Unwind_InitContext(context, uc)                                     \
   ((context)->end_of_stack = 0,                                              \
+   (context)->pi = NULL,                                                     \
    ((unw_getcontext (uc) < 0 || unw_init_local (&(context)->cursor, uc) < 0) \
     ? -1 : 0))
 
+/* Find the current frame of CURSOR in RECORD, skipping the entries
+   before *NEXT and those for frames the cursor is already past.
+   Returns 1 and the entry in *FRAMEP if the search phase called a
+   personality routine for the frame, 0 if the search phase went past
+   the frame without finding one, or -1 if the record does not tell.
+   The search phase made sure that the stack pointers of its frames
+   strictly increase.  */
+ALWAYS_INLINE static int
+_Unwind_Phase1_Find (const struct _Unwind_Phase1_Record *record,
+                     unsigned int *next, unw_cursor_t *cursor,
+                     const struct _Unwind_Phase1_Frame **framep)
+{
+  unw_word_t ip, sp;
+
+  if (unw_get_reg (cursor, UNW_REG_SP, &sp) < 0
+      || unw_get_reg (cursor, UNW_REG_IP, &ip) < 0)
+    return -1;
+
+  while (*next < record->nframes && record->frames[*next].sp < sp)
+    ++*next;
+  if (*next >= record->nframes)
+    return -1;
+  if (record->frames[*next].sp > sp)
+    return 0;
+  if (record->frames[*next].ip != ip)
+    return -1;
+
+  *framep = &record->frames[(*next)++];
+  return 1;
+}
+
 ALWAYS_INLINE static _Unwind_Reason_Code
 _Unwind_Phase2 (struct _Unwind_Exception *exception_object,
                 struct _Unwind_Context *context)
@@ -66,19 +121,27 @@ _Unwind_Phase2 (struct _Unwind_Exception *exception_object,
   _Unwind_Stop_Fn stop = (_Unwind_Stop_Fn) exception_object->private_1;
   uint64_t exception_class = exception_object->exception_class;
   void *stop_parameter = (void *) exception_object->private_2;
+  const struct _Unwind_Phase1_Record *record = NULL;
+  const struct _Unwind_Phase1_Frame *frame;
   _Unwind_Personality_Fn personality;
   _Unwind_Reason_Code reason;
   _Unwind_Action actions;
   unw_proc_info_t pi;
+  unsigned int next = 0;
+  int first = 1;
   unw_word_t ip;
   int ret;
 
   actions = _UA_CLEANUP_PHASE;
   if (stop)
     actions |= _UA_FORCE_UNWIND;
+  else if (_U_phase1_record.exception_object == exception_object
+           && _U_phase1_record.handler_ip == exception_object->private_2)
+    record = &_U_phase1_record;
 
   while (1)
     {
+      context->pi = NULL;
       ret = unw_step (&context->cursor);
       if (ret <= 0)
         {
@@ -104,11 +167,30 @@ _Unwind_Phase2 (struct _Unwind_Exception *exception_object,
             return _URC_FATAL_PHASE2_ERROR;
         }
 
-      if (context->end_of_stack
-          || unw_get_proc_info (&context->cursor, &pi) < 0)
+      if (context->end_of_stack)
         return _URC_FATAL_PHASE2_ERROR;
 
-      personality = (_Unwind_Personality_Fn) (uintptr_t) pi.handler;
+      /* The first frame may be one that _Unwind_Resume() was called
+         from, at another IP and possibly SP than in the search phase,
+         so it always takes the normal path.  */
+      ret = -1;
+      if (record && !first)
+        ret = _Unwind_Phase1_Find (record, &next, &context->cursor, &frame);
+      first = 0;
+
+      if (ret == 0)
+        continue;
+      if (ret > 0)
+        context->pi = &frame->pi;
+      else
+        {
+          if (unw_get_proc_info (&context->cursor, &pi) < 0)
+            return _URC_FATAL_PHASE2_ERROR;
+          context->pi = &pi;
+        }
+
+      personality =
+        (_Unwind_Personality_Fn) (uintptr_t) context->pi->handler;
       if (personality)
         {
           if (!stop)
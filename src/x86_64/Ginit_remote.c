@@ -46,6 +46,7 @@ unw_init_remote (unw_cursor_t *cursor UNUSED, unw_addr_space_t as UNUSED, void *
 
   Debug (1, "(cursor=%p)\n", c);
 
+  atomic_fetch_add (&as->init_generation, 1);
   c->dwarf.as = as;
   if (as == unw_local_addr_space)
     {
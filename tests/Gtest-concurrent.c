@@ -95,6 +95,66 @@ worker (void *arg UNUSED)
   return NULL;
 }
 
+static volatile int resizing;
+
+/* Unwind over and over while the main thread keeps resizing and
+   flushing the cache underneath us.  */
+void *
+unwinder (void *arg UNUSED)
+{
+  unw_context_t uc;
+  unw_cursor_t c;
+  int ret, num_frames;
+
+  while (resizing)
+    {
+      num_frames = 0;
+      unw_getcontext (&uc);
+      unw_init_local (&c, &uc);
+      do
+        ++num_frames;
+      while ((ret = unw_step (&c)) > 0);
+
+#ifdef UNW_TARGET_ARM
+      if (ret == -UNW_ESTOPUNWIND)
+        continue;
+#endif
+      if (ret < 0)
+        panic ("unw_step() returned %d\n", ret);
+      if (num_frames < 2)
+        panic ("FAILURE: only found %d frames\n", num_frames);
+    }
+  return NULL;
+}
+
+static void
+doit_resizing (void)
+{
+  static const size_t sizes[] = { 64, 4096, 1 << 14 };
+  pthread_t th[8];
+  unsigned i;
+
+  resizing = 1;
+  for (i = 0; i < ARRAY_SIZE (th); ++i)
+    if (pthread_create (th + i, NULL, unwinder, NULL))
+      {
+        fprintf (stderr, "FAILURE: Failed to create unwinder thread\n");
+        exit (-1);
+      }
+
+  for (i = 0; i < 300; ++i)
+    {
+      if (unw_set_cache_size (unw_local_addr_space,
+                              sizes[i % ARRAY_SIZE (sizes)], 0) != 0)
+        panic ("unw_set_cache_size() failed\n");
+      unw_flush_cache (unw_local_addr_space, 0, 0);
+    }
+
+  resizing = 0;
+  for (i = 0; i < ARRAY_SIZE (th); ++i)
+    pthread_join (th[i], NULL);
+}
+
 static void
 doit (void)
 {
@@ -134,11 +194,22 @@ main (int argc, char **argv UNUSED)
   unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_GLOBAL);
   doit ();
 
+  if (verbose)
+    printf ("Caching: global, resized while unwinding\n");
+  doit_resizing ();
+  unw_set_cache_size (unw_local_addr_space, 128, 0);
+
   if (verbose)
     printf ("Caching: per-thread\n");
   unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_PER_THREAD);
   doit ();
 
+  if (verbose)
+    printf ("Caching: per-thread, 4096 entries\n");
+  if (unw_set_cache_size (unw_local_addr_space, 4096, 0) != 0)
+    panic ("unw_set_cache_size() failed\n");
+  doit ();
+
   if (nerrors)
     {
       fprintf (stderr, "FAILURE: detected %d errors\n", nerrors);
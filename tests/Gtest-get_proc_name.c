@@ -104,6 +104,101 @@ test_function_name_shorter_than_buffer ()
                   "unexpected return value for function name shorter than buffer\n");
 }
 
+static void NOINLINE
+test_function_name_after_flush ()
+{
+  unw_flush_cache (unw_local_addr_space, 0, 0);
+  UNW_TEST_ASSERT(trace_back_1 (__FUNCTION__, sizeof(__FUNCTION__)+1) == UNW_ESUCCESS,
+                  "unexpected return value for function name after cache flush\n");
+}
+
+static void NOINLINE
+test_function_name_without_caching ()
+{
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_NONE);
+  int ret = trace_back_1 (__FUNCTION__, sizeof(__FUNCTION__)+1);
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_GLOBAL);
+  UNW_TEST_ASSERT(ret == UNW_ESUCCESS,
+                  "unexpected return value for function name without caching\n");
+}
+
+/* Resolve IPS as one batch, the last being an address outside any
+   procedure, and compare the result with one-by-one lookups.  */
+static void
+check_batch_names (const unw_word_t *ips, int n, size_t arena_len)
+{
+  const char *names[2 * 16 + 1];
+  unw_word_t offs[2 * 16 + 1];
+  char arena[4096];
+  char sym[buffer_size];
+  int i, ret, resolved = 0;
+
+  ret = unw_get_proc_names_by_ip (unw_local_addr_space, ips, n, names, offs,
+                                  arena, arena_len, 0);
+  for (i = 0; i < n; ++i)
+    {
+      unw_word_t off;
+
+      if (is_verbose_mode)
+        printf("%#010lx: %s\n", (long)ips[i], names[i] ? names[i] : "?");
+      if (!names[i])
+        continue;
+      ++resolved;
+      UNW_TEST_ASSERT(names[i] >= arena && names[i] < arena + arena_len,
+                      "name not stored in the arena\n");
+      UNW_TEST_ASSERT(unw_get_proc_name_by_ip (unw_local_addr_space, ips[i],
+                                               sym, sizeof(sym), &off, 0) == 0,
+                      "batch found a name for %#lx, single lookup did not\n",
+                      (long)ips[i]);
+      UNW_TEST_ASSERT(strcmp(sym, names[i]) == 0 && off == offs[i],
+                      "batch result '%s' differs from single lookup '%s'\n",
+                      names[i], sym);
+    }
+  UNW_TEST_ASSERT(names[0] == names[n - 2],
+                  "repeated address did not share its name\n");
+
+  if (arena_len == sizeof(arena))
+    {
+      UNW_TEST_ASSERT(ret == resolved, "batch returned %d, resolved %d\n",
+                      ret, resolved);
+      UNW_TEST_ASSERT(names[n - 1] == NULL, "name found for a bad address\n");
+      for (i = 0; i < n - 1; ++i)
+        UNW_TEST_ASSERT(names[i] != NULL
+                        || unw_get_proc_name_by_ip (unw_local_addr_space,
+                                                    ips[i], sym, sizeof(sym),
+                                                    NULL, 0) != 0,
+                        "batch missed the name of %#lx\n", (long)ips[i]);
+      UNW_TEST_ASSERT(strcmp(names[0], "test_batch_names") == 0,
+                      "unexpected name '%s' for the first frame\n", names[0]);
+    }
+  else
+    UNW_TEST_ASSERT(ret == -UNW_ENOMEM,
+                    "unexpected return value %d for a short arena\n", ret);
+}
+
+/* Batch-resolve the frames above, twice each and in both orders.  */
+static void NOINLINE
+test_batch_names ()
+{
+  void *frames[16];
+  unw_word_t ips[2 * 16 + 1];
+  int depth, n = 0, i;
+
+  depth = unw_backtrace (frames, 16);
+  UNW_TEST_ASSERT(depth > 1, "backtrace too short\n");
+  for (i = 0; i < depth; ++i)
+    ips[n++] = (unw_word_t) frames[i];
+  for (i = depth; i-- > 0;)
+    ips[n++] = (unw_word_t) frames[i];
+  ips[n++] = 0;
+
+  check_batch_names (ips, n, 4096);
+  check_batch_names (ips, n, 8);
+
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_NONE);
+  check_batch_names (ips, n, 4096);
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_GLOBAL);
+}
 
 int
 main (int argc, char **argv)
@@ -112,6 +207,9 @@ main (int argc, char **argv)
 
   test_function_name_shorter_than_buffer ();
   test_function_name_longer_than_buffer ();
+  test_function_name_after_flush ();
+  test_function_name_without_caching ();
+  test_batch_names ();
 
   return UNW_TEST_EXIT_PASS;
 }
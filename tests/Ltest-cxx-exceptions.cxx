@@ -60,10 +60,36 @@ extern "C" void bar()
   }
 }
 
+// Each level has a cleanup, so the exception passes more frames with a
+// personality routine than _Unwind_RaiseException() keeps from the search
+// phase, and every cleanup continues with _Unwind_Resume().
+extern "C" void __attribute__((noinline)) deep(int depth)
+{
+  Test t;
+  if (depth == 0)
+    throw 7;
+  deep(depth - 1);
+}
+
+static void test_depth(int depth)
+{
+  try {
+    Test t;
+    deep(depth);
+  } catch (int i) {
+    if (i != 7 || Test::counter_ != 0)
+      panic("Wrong exception or counter non-zero at depth %d\n", depth);
+    return;
+  }
+  panic("No exception at depth %d\n", depth);
+}
+
 int main(int argc, char **argv UNUSED)
 {
   if (argc > 1)
     verbose = 1;
+  test_depth(4);
+  test_depth(100);
   try {
     Test t;
     bar();
@@ -0,0 +1,190 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test verifies that decompressed MiniDebugInfo images are kept
+   in the cache: looking up a symbol in the same object again must not
+   decompress its .gnu_debugdata again, and once more objects than the
+   cache has slots have been looked up, the least recently used image
+   must be evicted and decompressed anew, while the others stay.
+
+   The objects are made up here.  Each is an ELF header with just a
+   .gnu_debugdata section, which holds a different xz-compressed ELF
+   header, so that the images are told apart by their compressed data. */
+
+#include "libunwind_i.h"
+
+#if !defined(UNW_REMOTE_ONLY) && defined(HAVE_LZMA)
+
+#include <lzma.h>
+
+#include "unw_test.h"
+
+enum
+  {
+    CACHE_SLOTS = 64,           /* MDI_CACHE_SLOTS in src/elfxx.c */
+    NOBJECTS = CACHE_SLOTS + 1,
+    IMAGE_SIZE = 16 * 1024      /* size of a decompressed image */
+  };
+
+static const char shstrtab[] = "\0.gnu_debugdata\0.shstrtab";
+#define DEBUGDATA_NAME  1
+#define SHSTRTAB_NAME   16
+
+struct mdi_object
+  {
+    Elf_W (Ehdr) ehdr;
+    Elf_W (Shdr) shdr[3];
+    char shstrtab[sizeof (shstrtab)];
+    uint8_t debugdata[];
+  };
+
+static int verbose;
+static struct elf_image objects[NOBJECTS];
+
+
+static void
+init_ehdr (Elf_W (Ehdr) *ehdr)
+{
+  memset (ehdr, 0, sizeof (*ehdr));
+  memcpy (ehdr->e_ident, ELFMAG, SELFMAG);
+  ehdr->e_ident[EI_CLASS] = UNW_ELF_CLASS;
+  ehdr->e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr->e_version = EV_CURRENT;
+  ehdr->e_ehsize = sizeof (*ehdr);
+  ehdr->e_shentsize = sizeof (Elf_W (Shdr));
+}
+
+
+static void
+make_object (struct elf_image *ei, int k)
+{
+  static uint8_t image[IMAGE_SIZE];
+  size_t max_len = lzma_stream_buffer_bound (IMAGE_SIZE), len = 0;
+  struct mdi_object *o;
+  size_t i;
+
+  /* The image differs from the others in its contents.  */
+  init_ehdr ((Elf_W (Ehdr) *) image);
+  for (i = sizeof (Elf_W (Ehdr)); i < IMAGE_SIZE; ++i)
+    image[i] = (uint8_t) ((i % 251) * (k + 1));
+
+  o = calloc (1, sizeof (*o) + max_len);
+  UNW_TEST_ASSERT (o != NULL, "calloc failed\n");
+  UNW_TEST_ASSERT (lzma_easy_buffer_encode (0, LZMA_CHECK_CRC32, NULL,
+                                            image, IMAGE_SIZE, o->debugdata,
+                                            &len, max_len) == LZMA_OK,
+                   "cannot compress image %d\n", k);
+
+  init_ehdr (&o->ehdr);
+  o->ehdr.e_shoff = offsetof (struct mdi_object, shdr);
+  o->ehdr.e_shnum = 3;
+  o->ehdr.e_shstrndx = 2;
+  o->shdr[1].sh_name = DEBUGDATA_NAME;
+  o->shdr[1].sh_type = SHT_PROGBITS;
+  o->shdr[1].sh_offset = offsetof (struct mdi_object, debugdata);
+  o->shdr[1].sh_size = len;
+  o->shdr[2].sh_name = SHSTRTAB_NAME;
+  o->shdr[2].sh_type = SHT_STRTAB;
+  o->shdr[2].sh_offset = offsetof (struct mdi_object, shstrtab);
+  o->shdr[2].sh_size = sizeof (shstrtab);
+  memcpy (o->shstrtab, shstrtab, sizeof (shstrtab));
+
+  ei->image = o;
+  ei->size = offsetof (struct mdi_object, debugdata) + len;
+}
+
+
+/* Looks up a symbol in object K and returns the number of images that
+   had to be decompressed for it.  */
+static unsigned long
+lookup (int k)
+{
+  unw_stats_t stats;
+  unw_word_t off;
+  char name[64];
+
+  unw_reset_stats (unw_local_addr_space);
+  /* There is no symbol to find, but the lookup has to look.  */
+  elf_w (get_proc_name_in_image) (unw_local_addr_space, &objects[k], 0, 0,
+                                  name, sizeof (name), &off, NULL);
+  unw_get_stats (unw_local_addr_space, &stats);
+  return stats.minidebuginfo_decompressions;
+}
+
+
+int
+main (int argc, char **argv UNUSED)
+{
+  unw_context_t uc;
+  unw_cursor_t c;
+  unw_stats_t stats;
+  int k;
+
+  verbose = argc > 1;
+
+  unw_getcontext (&uc);
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  if (unw_get_stats (unw_local_addr_space, &stats) < 0)
+    {
+      printf ("statistics are disabled, skipping\n");
+      return UNW_TEST_EXIT_SKIP;
+    }
+  if (getenv ("UNW_MINIDEBUGINFO_CACHE_SIZE"))
+    {
+      printf ("UNW_MINIDEBUGINFO_CACHE_SIZE is set, skipping\n");
+      return UNW_TEST_EXIT_SKIP;
+    }
+
+  for (k = 0; k < NOBJECTS; ++k)
+    make_object (&objects[k], k);
+
+  UNW_TEST_ASSERT (lookup (0) == 1, "first lookup did not decompress\n");
+  UNW_TEST_ASSERT (lookup (0) == 0, "second lookup decompressed again\n");
+
+  /* Fill the other slots; the last object evicts object 0.  */
+  for (k = 1; k < NOBJECTS; ++k)
+    UNW_TEST_ASSERT (lookup (k) == 1, "object %d was not decompressed\n", k);
+  for (k = 1; k < NOBJECTS; ++k)
+    UNW_TEST_ASSERT (lookup (k) == 0, "object %d was evicted too soon\n", k);
+  UNW_TEST_ASSERT (lookup (0) == 1, "least recently used image was not "
+                   "evicted\n");
+  /* Which evicted object 1, but nothing used more recently.  */
+  UNW_TEST_ASSERT (lookup (2) == 0, "object 2 was evicted\n");
+  UNW_TEST_ASSERT (lookup (1) == 1, "object 1 was not evicted\n");
+
+  if (verbose)
+    printf ("SUCCESS: %d objects\n", NOBJECTS);
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* UNW_REMOTE_ONLY || !HAVE_LZMA */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* UNW_REMOTE_ONLY || !HAVE_LZMA */
@@ -0,0 +1,186 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test verifies that the address validator rejects memory once it
+   has been unmapped.  The validator accepts the mappings of loaded
+   objects and the calling thread's stack without a system call, so it
+   must notice objects being unloaded without an unw_flush_cache(), and
+   it must not extend a thread's stack to anonymous memory that the
+   kernel merged with it.  Objects are only trusted that way where
+   _dl_find_object() is available; elsewhere their pages are probed and
+   remembered as before, and unloading them needs a flush.  */
+
+#include "libunwind_i.h"
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "unw_test.h"
+
+#ifdef HAVE__DL_FIND_OBJECT
+static const char *libraries[] =
+  {
+    "libresolv.so.2", "libutil.so.1", "libm.so.6", "libz.so.1"
+  };
+#endif
+
+enum { STACK_SIZE = 1024 * 1024, NEIGHBOUR_PAGES = 4 };
+
+static int verbose;
+static char *neighbour;
+static size_t neighbour_size;
+static bool stack_valid, stack_still_valid, neighbour_valid;
+
+
+static int
+check_unloaded_object (void)
+{
+#ifdef HAVE__DL_FIND_OBJECT
+  size_t i;
+
+  for (i = 0; i < sizeof (libraries) / sizeof (libraries[0]); ++i)
+    {
+      struct link_map *map;
+      unw_word_t addr;
+      void *handle;
+
+      /* An object that was loaded before would stay mapped.  */
+      if (dlopen (libraries[i], RTLD_NOW | RTLD_NOLOAD))
+        continue;
+      handle = dlopen (libraries[i], RTLD_NOW | RTLD_LOCAL);
+      if (!handle)
+        continue;
+      /* Symbols may come from other objects; the dynamic section can't. */
+      if (dlinfo (handle, RTLD_DI_LINKMAP, &map) != 0)
+        {
+          dlclose (handle);
+          continue;
+        }
+      addr = (unw_word_t) (uintptr_t) map->l_ld;
+
+      /* Loading needs a flush to be seen, unloading must not.  */
+      unw_flush_cache (unw_local_addr_space, 0, 0);
+      UNW_TEST_ASSERT (unw_address_is_valid (addr, sizeof (unw_word_t)),
+                       "%s at 0x%lx rejected\n", libraries[i], (long) addr);
+
+      dlclose (handle);
+      if (dlopen (libraries[i], RTLD_NOW | RTLD_NOLOAD))
+        continue;
+      UNW_TEST_ASSERT (!unw_address_is_valid (addr, sizeof (unw_word_t)),
+                       "unloaded %s at 0x%lx accepted\n",
+                       libraries[i], (long) addr);
+      if (verbose)
+        printf ("%s: 0x%lx rejected after dlclose\n", libraries[i],
+                (long) addr);
+      return 1;
+    }
+#endif
+  return 0;
+}
+
+
+static void *
+stack_thread (void *arg UNUSED)
+{
+  volatile unw_word_t local = 0;
+
+  /* Lets the validator record this thread's stack.  */
+  stack_valid = unw_address_is_valid ((unw_word_t) &local, sizeof (local));
+
+  munmap (neighbour, neighbour_size);
+  neighbour_valid = unw_address_is_valid ((unw_word_t) neighbour,
+                                          sizeof (unw_word_t));
+  stack_still_valid = unw_address_is_valid ((unw_word_t) &local,
+                                            sizeof (local));
+  return NULL;
+}
+
+
+/* The thread's stack and the memory above it are a single mapping.  */
+static void
+check_merged_stack (void)
+{
+  pthread_attr_t attr;
+  pthread_t thread;
+  char *block;
+
+  neighbour_size = NEIGHBOUR_PAGES * unw_page_size;
+  block = mmap (NULL, STACK_SIZE + neighbour_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  UNW_TEST_ASSERT (block != MAP_FAILED, "mmap failed\n");
+  neighbour = block + STACK_SIZE;
+
+  pthread_attr_init (&attr);
+  pthread_attr_setstack (&attr, block, STACK_SIZE);
+  UNW_TEST_ASSERT (pthread_create (&thread, &attr, stack_thread, NULL) == 0,
+                   "pthread_create failed\n");
+  pthread_join (thread, NULL);
+  pthread_attr_destroy (&attr);
+  munmap (block, STACK_SIZE);
+
+  UNW_TEST_ASSERT (stack_valid, "thread stack rejected\n");
+  UNW_TEST_ASSERT (!neighbour_valid, "unmapped neighbour of the stack "
+                   "accepted\n");
+  UNW_TEST_ASSERT (stack_still_valid, "thread stack rejected after "
+                   "unmapping its neighbour\n");
+  if (verbose)
+    printf ("unmapped neighbour of the thread stack rejected\n");
+}
+
+
+int
+main (int argc, char **argv UNUSED)
+{
+  unw_context_t uc;
+  unw_cursor_t c;
+
+  verbose = argc > 1;
+
+  /* The validator needs the library to be initialized.  */
+  unw_getcontext (&uc);
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+
+  if (!check_unloaded_object () && verbose)
+    printf ("no library could be unloaded, skipping that check\n");
+  check_merged_stack ();
+
+  if (verbose)
+    printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
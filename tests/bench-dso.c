@@ -0,0 +1,49 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* One link of the chain of shared objects that perf-bench unwinds
+   through.  "make bench" compiles this file once per object with a
+   different BENCH_DSO_ID; perf-bench loads them all and calls through
+   each in turn, so that every frame of the stack lives in a different
+   object.  */
+
+#ifndef BENCH_DSO_ID
+# define BENCH_DSO_ID 0
+#endif
+
+typedef int (*bench_dso_fn) (const void *chain, int index, void *arg);
+
+/* Give each object a data section of its own size, so the objects do
+   not all have the same layout.  */
+int bench_dso_pad[BENCH_DSO_ID % 16 + 1];
+
+__attribute__((noinline)) int
+bench_dso_enter (const void *chain, int index, void *arg)
+{
+  const bench_dso_fn *fns = chain;
+  int ret;
+
+  ret = fns[index + 1] (chain, index + 1, arg);
+  bench_dso_pad[0] += ret;
+  return ret + 1;
+}
@@ -0,0 +1,771 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* Unwinding benchmarks with machine-readable results.
+
+   Each scenario sets up a stack, then times a fixed number of unwind
+   operations on it, a fixed number of times.  The results are written
+   to stdout as one JSON document: the minimum, median and maximum cost
+   of one operation over the repetitions, for each scenario, caching
+   policy and cache state.  "cold" operations flush the unwind caches,
+   including the frame caches of unw_backtrace(), before each operation
+   and the flush is included in the time.
+
+   Scenarios:
+     stack      unw_backtrace() and unw_step() at a moderate depth
+     deep       the same through a deep recursion
+     signal     the same from a signal handler
+     symbolize  unw_step() and unw_get_proc_name() for every frame
+     dso        unw_backtrace() and unw_step() through a chain of shared
+                objects, one frame each (needs -D, see bench-dso.c)
+     threads    unw_backtrace() in 1, 2, 4, ... concurrent threads
+     ptrace     unw_step() in a stopped child through libunwind-ptrace
+     coredump   unw_step() in a core file through libunwind-coredump
+                (needs -c)
+
+   "make bench" builds the shared objects and a core file and runs all
+   scenarios, see run-perf-bench.  */
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <dlfcn.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+#ifdef BENCH_PTRACE
+# include <sys/ptrace.h>
+# include <libunwind-ptrace.h>
+#endif
+#ifdef BENCH_COREDUMP
+# include <libunwind-coredump.h>
+#endif
+#include <libunwind.h>
+#include "compiler.h"
+
+#define panic(...)							  \
+	do { fprintf (stderr, __VA_ARGS__); exit (-1); } while (0)
+
+#define STR_(x)         #x
+#define STR(x)          STR_(x)
+
+#define MAX_FRAMES      4096
+#define MAX_REPS        64
+#define MAX_THREADS     256
+
+enum op
+  {
+    OP_BACKTRACE,
+    OP_STEP,
+    OP_SYMBOLIZE
+  };
+
+static const char *const op_name[] = { "backtrace", "step", "symbolize" };
+
+/* unw_backtrace() always unwinds with the local-only library, whose
+   address space is not the unw_local_addr_space of this program, so
+   caching policies and flushes have to be applied to both.  */
+#define local_only_addr_space \
+  UNW_PASTE (UNW_PASTE (_UL, UNW_TARGET), _local_addr_space)
+extern unw_addr_space_t local_only_addr_space;
+
+/* One repetition of one measurement.  */
+struct run
+  {
+    enum op op;
+    int cold;
+    long ops;
+    int frames;
+    double ns;                  /* per operation */
+  };
+
+/* All repetitions of one measurement.  */
+struct result
+  {
+    const char *scenario;
+    enum op op;
+    const char *policy;
+    int cold;
+    int threads;
+    int depth;
+    int frames;
+    long ops;
+    double ns[MAX_REPS];
+  };
+
+static const struct
+  {
+    unw_caching_policy_t policy;
+    const char *name;
+  }
+policies[] =
+  {
+    { UNW_CACHE_NONE,           "none" },
+    { UNW_CACHE_GLOBAL,         "global" },
+    { UNW_CACHE_PER_THREAD,     "per-thread" }
+  };
+
+static int reps = 5;
+static long iterations = 1000;
+static int depth = 32;
+static int deep_depth = 1024;
+static int max_threads;
+static const char *dso_dir;
+static int ndsos;
+static const char *core_file;
+static const char *scenarios;
+static int nresults;
+
+typedef int (*bench_dso_fn) (const void *chain, int index, void *arg);
+static bench_dso_fn *dso_chain;
+
+static struct run *signal_run;
+static pthread_barrier_t thread_barrier;
+
+static inline double
+now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int
+want (const char *name)
+{
+  size_t len = strlen (name);
+  const char *s;
+
+  if (!scenarios)
+    return 1;
+  for (s = scenarios; (s = strstr (s, name)) != NULL; s += len)
+    if ((s == scenarios || s[-1] == ',') && (s[len] == '\0' || s[len] == ','))
+      return 1;
+  return 0;
+}
+
+static int
+compare_doubles (const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return (x > y) - (x < y);
+}
+
+static void
+print_env (const char *name, int last)
+{
+  const char *value = getenv (name);
+
+  if (value)
+    printf ("      \"%s\": \"%s\"%s\n", name, value, last ? "" : ",");
+  else
+    printf ("      \"%s\": null%s\n", name, last ? "" : ",");
+}
+
+static void
+print_header (void)
+{
+  struct utsname u;
+
+  if (uname (&u) < 0)
+    strcpy (u.machine, "unknown");
+
+  printf ("{\n");
+  printf ("  \"benchmark\": \"libunwind perf-bench\",\n");
+  printf ("  \"version\": \"%d.%d%s\",\n", UNW_VERSION_MAJOR,
+          UNW_VERSION_MINOR, STR (UNW_VERSION_EXTRA));
+  printf ("  \"machine\": \"%s\",\n", u.machine);
+  printf ("  \"cpus\": %ld,\n", sysconf (_SC_NPROCESSORS_ONLN));
+  printf ("  \"config\":\n");
+  printf ("    {\n");
+  printf ("      \"repetitions\": %d,\n", reps);
+  printf ("      \"iterations\": %ld,\n", iterations);
+  printf ("      \"depth\": %d,\n", depth);
+  printf ("      \"deep_depth\": %d,\n", deep_depth);
+  printf ("      \"max_threads\": %d,\n", max_threads);
+  printf ("      \"dsos\": %d,\n", dso_chain ? ndsos : 0);
+  print_env ("UNW_TRACE_CACHE", 0);
+  print_env ("UNW_COMPACT_UNWIND_TABLES", 1);
+  printf ("    },\n");
+  printf ("  \"results\":\n");
+  printf ("    [");
+}
+
+static void
+print_footer (void)
+{
+  printf ("\n    ]\n}\n");
+}
+
+static void
+print_result (struct result *res)
+{
+  double median;
+
+  qsort (res->ns, reps, sizeof (res->ns[0]), compare_doubles);
+  median = res->ns[reps / 2];
+  if (reps % 2 == 0)
+    median = (median + res->ns[reps / 2 - 1]) / 2;
+
+  printf ("%s\n      {\"scenario\": \"%s\", \"op\": \"%s\", \"policy\": \"%s\","
+          " \"cache\": \"%s\", \"threads\": %d, \"depth\": %d,"
+          " \"frames\": %d, \"ops\": %ld,"
+          " \"ns_per_op\": {\"min\": %.1f, \"median\": %.1f, \"max\": %.1f},"
+          " \"ns_per_frame\": %.2f, \"ops_per_sec\": %.0f}",
+          nresults++ ? "," : "", res->scenario, op_name[res->op],
+          res->policy, res->cold ? "cold" : "warm", res->threads, res->depth,
+          res->frames, res->ops, res->ns[0], median, res->ns[reps - 1],
+          res->frames ? median / res->frames : 0.0,
+          median > 0 ? res->threads * 1e9 / median : 0.0);
+  fflush (stdout);
+}
+
+static int NOINLINE
+local_op (enum op op)
+{
+  void *buffer[MAX_FRAMES];
+  char name[256];
+  unw_context_t uc;
+  unw_cursor_t c;
+  unw_word_t off;
+  int frames = 1;
+
+  if (op == OP_BACKTRACE)
+    return unw_backtrace (buffer, MAX_FRAMES);
+
+  if (unw_getcontext (&uc) < 0 || unw_init_local (&c, &uc) < 0)
+    panic ("unw_init_local() failed\n");
+  do
+    if (op == OP_SYMBOLIZE)
+      unw_get_proc_name (&c, name, sizeof (name), &off);
+  while (unw_step (&c) > 0 && ++frames < MAX_FRAMES);
+  return frames;
+}
+
+static void
+set_local_policy (unw_caching_policy_t policy)
+{
+  unw_set_caching_policy (unw_local_addr_space, policy);
+  unw_set_caching_policy (local_only_addr_space, policy);
+}
+
+static void
+flush_local_caches (void)
+{
+  unw_flush_cache (unw_local_addr_space, 0, 0);
+  unw_flush_cache (local_only_addr_space, 0, 0);
+}
+
+/* Time run->ops local operations at the current stack depth.  */
+static void NOINLINE
+measure (struct run *run)
+{
+  double start;
+  long i;
+
+  start = now_ns ();
+  for (i = 0; i < run->ops; ++i)
+    {
+      if (run->cold)
+        flush_local_caches ();
+      run->frames = local_op (run->op);
+    }
+  run->ns = (now_ns () - start) / run->ops;
+}
+
+static int NOINLINE
+recurse (int n, void (*fn) (void *), void *arg)
+{
+  if (n > 0)
+    return recurse (n - 1, fn, arg) + 1;
+  fn (arg);
+  return 0;
+}
+
+static void
+measure_arg (void *arg)
+{
+  measure (arg);
+}
+
+static void
+enter_stack (struct run *run, int n)
+{
+  recurse (n, measure_arg, run);
+}
+
+static void
+signal_handler (int sig UNUSED)
+{
+  measure (signal_run);
+}
+
+static void
+raise_signal (void *arg)
+{
+  signal_run = arg;
+  raise (SIGUSR1);
+}
+
+static void
+enter_signal (struct run *run, int n)
+{
+  recurse (n, raise_signal, run);
+}
+
+static int
+dso_bottom (const void *chain UNUSED, int index UNUSED, void *arg)
+{
+  measure (arg);
+  return 0;
+}
+
+static void
+enter_dso (struct run *run, int n UNUSED)
+{
+  dso_chain[0] (dso_chain, 0, run);
+}
+
+static long
+scaled_ops (long divisor)
+{
+  return iterations / divisor > 0 ? iterations / divisor : 1;
+}
+
+/* Measure OP on the stack set up by ENTER under every caching policy,
+   warm and (unless COLD is 0) cold.  */
+static void
+bench_local (const char *scenario, enum op op, int n, long divisor, int cold,
+             void (*enter) (struct run *, int))
+{
+  struct result res;
+  struct run run;
+  size_t p;
+  int c, r;
+
+  for (p = 0; p < sizeof (policies) / sizeof (policies[0]); ++p)
+    {
+      set_local_policy (policies[p].policy);
+      for (c = 0; c <= cold; ++c)
+        {
+          /* Without a cache there is no cold/warm difference.  */
+          if (c && policies[p].policy == UNW_CACHE_NONE)
+            continue;
+
+          memset (&res, 0, sizeof (res));
+          res.scenario = scenario;
+          res.op = op;
+          res.policy = policies[p].name;
+          res.cold = c;
+          res.threads = 1;
+          res.depth = n;
+          res.ops = scaled_ops (c ? 10 * divisor : divisor);
+
+          /* An untimed pass to fault in the stack and the caches.  */
+          memset (&run, 0, sizeof (run));
+          run.op = op;
+          run.cold = c;
+          run.ops = 1;
+          enter (&run, n);
+
+          for (r = 0; r < reps; ++r)
+            {
+              run.ops = res.ops;
+              enter (&run, n);
+              res.ns[r] = run.ns;
+            }
+          res.frames = run.frames;
+          print_result (&res);
+        }
+    }
+  set_local_policy (UNW_CACHE_GLOBAL);
+}
+
+static void
+load_dsos (void)
+{
+  char path[PATH_MAX];
+  void *handle;
+  int i;
+
+  dso_chain = calloc (ndsos + 1, sizeof (dso_chain[0]));
+  if (!dso_chain)
+    panic ("out of memory\n");
+  for (i = 0; i < ndsos; ++i)
+    {
+      snprintf (path, sizeof (path), "%s/libbench-dso-%d.so", dso_dir, i);
+      if (!(handle = dlopen (path, RTLD_NOW | RTLD_LOCAL)))
+        panic ("%s\n", dlerror ());
+      if (!(dso_chain[i] = (bench_dso_fn) dlsym (handle, "bench_dso_enter")))
+        panic ("%s: no bench_dso_enter\n", path);
+    }
+  dso_chain[ndsos] = dso_bottom;
+}
+
+static void
+thread_bottom (void *arg)
+{
+  struct run *run = arg;
+  long ops = run->ops;
+
+  /* Set up this thread's caches before the clock starts.  */
+  run->ops = 1;
+  measure (run);
+  run->ops = ops;
+
+  pthread_barrier_wait (&thread_barrier);
+  measure (run);
+}
+
+static void *
+thread_main (void *arg)
+{
+  recurse (depth, thread_bottom, arg);
+  return NULL;
+}
+
+/* Run NTHREADS threads doing backtraces at the same time.  Each thread
+   times its own operations; the result is their average.  */
+static void
+bench_threads (int nthreads, size_t p)
+{
+  static struct run runs[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+  struct result res;
+  double sum;
+  int r, t;
+
+  memset (&res, 0, sizeof (res));
+  res.scenario = "threads";
+  res.op = OP_BACKTRACE;
+  res.policy = policies[p].name;
+  res.threads = nthreads;
+  res.depth = depth;
+  res.ops = iterations;
+
+  set_local_policy (policies[p].policy);
+  for (r = 0; r < reps; ++r)
+    {
+      pthread_barrier_init (&thread_barrier, NULL, nthreads);
+      for (t = 0; t < nthreads; ++t)
+        {
+          memset (&runs[t], 0, sizeof (runs[t]));
+          runs[t].op = OP_BACKTRACE;
+          runs[t].ops = res.ops;
+          if (pthread_create (&threads[t], NULL, thread_main, &runs[t]) != 0)
+            panic ("pthread_create() failed\n");
+        }
+      for (sum = 0, t = 0; t < nthreads; ++t)
+        {
+          pthread_join (threads[t], NULL);
+          sum += runs[t].ns;
+        }
+      pthread_barrier_destroy (&thread_barrier);
+      res.ns[r] = sum / nthreads;
+      res.frames = runs[0].frames;
+    }
+  print_result (&res);
+  set_local_policy (UNW_CACHE_GLOBAL);
+}
+
+#if defined(BENCH_PTRACE) || defined(BENCH_COREDUMP)
+static int
+remote_op (unw_addr_space_t as, void *arg)
+{
+  unw_cursor_t c;
+  int frames = 1;
+
+  if (unw_init_remote (&c, as, arg) < 0)
+    panic ("unw_init_remote() failed\n");
+  while (unw_step (&c) > 0 && ++frames < MAX_FRAMES)
+    continue;
+  return frames;
+}
+
+/* Measure unw_step() in AS under UNW_CACHE_NONE and UNW_CACHE_GLOBAL,
+   warm and cold.  FLUSH, if not NULL, drops the accessors' own caches
+   of ARG.  */
+static void
+bench_remote (const char *scenario, unw_addr_space_t as, void *arg,
+              void (*flush) (void *))
+{
+  struct result res;
+  double start;
+  size_t p;
+  long i;
+  int c, r, frames = 0;
+
+  for (p = 0; p < 2; ++p)
+    {
+      unw_set_caching_policy (as, policies[p].policy);
+      for (c = 0; c <= 1; ++c)
+        {
+          if (c && policies[p].policy == UNW_CACHE_NONE)
+            continue;
+
+          memset (&res, 0, sizeof (res));
+          res.scenario = scenario;
+          res.op = OP_STEP;
+          res.policy = policies[p].name;
+          res.cold = c;
+          res.threads = 1;
+          res.depth = depth;
+          res.ops = scaled_ops (c ? 100 : 10);
+
+          remote_op (as, arg);
+          for (r = 0; r < reps; ++r)
+            {
+              start = now_ns ();
+              for (i = 0; i < res.ops; ++i)
+                {
+                  if (c)
+                    {
+                      unw_flush_cache (as, 0, 0);
+                      if (flush)
+                        flush (arg);
+                    }
+                  frames = remote_op (as, arg);
+                }
+              res.ns[r] = (now_ns () - start) / res.ops;
+            }
+          res.frames = frames;
+          print_result (&res);
+        }
+    }
+}
+#endif
+
+#ifdef BENCH_PTRACE
+static void
+stop_self (void *arg UNUSED)
+{
+  kill (getpid (), SIGSTOP);
+}
+
+static void
+bench_ptrace (void)
+{
+  unw_addr_space_t as;
+  void *ui;
+  pid_t pid;
+  int status;
+
+  fflush (stdout);
+  if ((pid = fork ()) < 0)
+    panic ("fork() failed: %s\n", strerror (errno));
+  if (pid == 0)
+    {
+      if (ptrace (PTRACE_TRACEME, 0, 0, 0) < 0)
+        _exit (1);
+      recurse (depth, stop_self, NULL);
+      _exit (0);
+    }
+
+  if (waitpid (pid, &status, 0) != pid || !WIFSTOPPED (status))
+    {
+      fprintf (stderr, "ptrace: child did not stop, scenario skipped\n");
+      kill (pid, SIGKILL);
+      waitpid (pid, &status, 0);
+      return;
+    }
+
+  if (!(as = unw_create_addr_space (&_UPT_accessors, 0)))
+    panic ("unw_create_addr_space() failed\n");
+  if (!(ui = _UPT_create (pid)))
+    panic ("_UPT_create() failed\n");
+
+  bench_remote ("ptrace", as, ui, _UPT_flush_cache);
+
+  _UPT_destroy (ui);
+  unw_destroy_addr_space (as);
+  kill (pid, SIGKILL);
+  waitpid (pid, &status, 0);
+}
+#endif
+
+#ifdef BENCH_COREDUMP
+static void
+bench_coredump (void)
+{
+  struct UCD_info *ui;
+  unw_addr_space_t as;
+
+  if (!(as = unw_create_addr_space (&_UCD_accessors, 0)))
+    panic ("unw_create_addr_space() failed\n");
+  if (!(ui = _UCD_create (core_file)))
+    panic ("_UCD_create(\"%s\") failed\n", core_file);
+
+  bench_remote ("coredump", as, ui, NULL);
+
+  _UCD_destroy (ui);
+  unw_destroy_addr_space (as);
+}
+#endif
+
+static void
+crash (void *arg UNUSED)
+{
+  abort ();
+}
+
+/* Die at DEPTH with a core dump, for the coredump scenario.  */
+static void
+make_core (void)
+{
+  struct rlimit rl;
+
+  if (getrlimit (RLIMIT_CORE, &rl) == 0)
+    {
+      rl.rlim_cur = rl.rlim_max;
+      setrlimit (RLIMIT_CORE, &rl);
+    }
+  signal (SIGABRT, SIG_DFL);
+  recurse (depth, crash, NULL);
+}
+
+static void
+usage (const char *prog, int status)
+{
+  fprintf (status ? stderr : stdout,
+           "Usage: %s [options]\n"
+           "  -r REPS      repetitions of each measurement (default %d)\n"
+           "  -i ITERS     operations per repetition (default %ld)\n"
+           "  -d DEPTH     stack depth (default %d)\n"
+           "  -R DEPTH     stack depth of the deep scenario (default %d)\n"
+           "  -t THREADS   maximum number of threads (default: CPUs)\n"
+           "  -D DIR -n N  unwind through DIR/libbench-dso-{0..N-1}.so\n"
+           "  -c CORE      core file for the coredump scenario\n"
+           "  -s LIST      comma-separated scenarios to run (default all)\n"
+           "  -a CPU       pin to CPU\n"
+           "  -C           dump core at DEPTH and exit\n"
+           "  -h           show this help and exit\n",
+           prog, reps, iterations, depth, deep_depth);
+  exit (status);
+}
+
+int
+main (int argc, char **argv)
+{
+  struct sigaction sa;
+  int opt, cpu = -1, n;
+  size_t p;
+
+  max_threads = sysconf (_SC_NPROCESSORS_ONLN);
+  while ((opt = getopt (argc, argv, "r:i:d:R:t:D:n:c:s:a:Ch")) != -1)
+    switch (opt)
+      {
+      case 'r': reps = atoi (optarg); break;
+      case 'i': iterations = atol (optarg); break;
+      case 'd': depth = atoi (optarg); break;
+      case 'R': deep_depth = atoi (optarg); break;
+      case 't': max_threads = atoi (optarg); break;
+      case 'D': dso_dir = optarg; break;
+      case 'n': ndsos = atoi (optarg); break;
+      case 'c': core_file = optarg; break;
+      case 's': scenarios = optarg; break;
+      case 'a': cpu = atoi (optarg); break;
+      case 'C': make_core (); return 1;
+      case 'h': usage (argv[0], 0); break;
+      default: usage (argv[0], 2);
+      }
+  if (reps < 1 || reps > MAX_REPS || iterations < 1 || depth < 0
+      || deep_depth < 0 || depth + 16 > MAX_FRAMES
+      || deep_depth + 16 > MAX_FRAMES || optind != argc)
+    usage (argv[0], 2);
+  if (max_threads < 1)
+    max_threads = 1;
+  if (max_threads > MAX_THREADS)
+    max_threads = MAX_THREADS;
+
+  if (cpu >= 0)
+    {
+      cpu_set_t set;
+
+      CPU_ZERO (&set);
+      CPU_SET (cpu, &set);
+      if (sched_setaffinity (0, sizeof (set), &set) < 0)
+        panic ("sched_setaffinity() failed: %s\n", strerror (errno));
+    }
+
+  if (dso_dir && ndsos > 0 && ndsos + 16 <= MAX_FRAMES && want ("dso"))
+    load_dsos ();
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = signal_handler;
+  sigaction (SIGUSR1, &sa, NULL);
+
+  print_header ();
+
+  if (want ("stack"))
+    {
+      bench_local ("stack", OP_BACKTRACE, depth, 1, 1, enter_stack);
+      bench_local ("stack", OP_STEP, depth, 1, 1, enter_stack);
+    }
+  if (want ("deep"))
+    {
+      bench_local ("deep", OP_BACKTRACE, deep_depth, 10, 1, enter_stack);
+      bench_local ("deep", OP_STEP, deep_depth, 10, 1, enter_stack);
+    }
+  if (want ("signal"))
+    {
+      bench_local ("signal", OP_BACKTRACE, depth, 1, 1, enter_signal);
+      bench_local ("signal", OP_STEP, depth, 1, 1, enter_signal);
+    }
+  if (want ("symbolize"))
+    bench_local ("symbolize", OP_SYMBOLIZE, depth, 10, 0, enter_stack);
+  if (dso_chain)
+    {
+      bench_local ("dso", OP_BACKTRACE, ndsos, 10, 1, enter_dso);
+      bench_local ("dso", OP_STEP, ndsos, 10, 1, enter_dso);
+    }
+  if (want ("threads"))
+    for (p = 1; p < sizeof (policies) / sizeof (policies[0]); ++p)
+      for (n = 1; n <= max_threads; n = n < max_threads && 2 * n > max_threads
+                                           ? max_threads : 2 * n)
+        bench_threads (n, p);
+#ifdef BENCH_PTRACE
+  if (want ("ptrace"))
+    bench_ptrace ();
+#endif
+#ifdef BENCH_COREDUMP
+  if (core_file && want ("coredump"))
+    bench_coredump ();
+#endif
+
+  print_footer ();
+  return 0;
+}
@@ -0,0 +1,276 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test verifies that unwinding with compact unwind tables gives
+   the same frames as interpreting the CFI.  The tables are enabled
+   with UNW_COMPACT_UNWIND_TABLES and are bypassed while the caching
+   policy is UNW_CACHE_NONE, so the same stack is unwound under both
+   policies and the results are compared.  The stack runs through
+   libc (qsort) and, in a second round, through a signal frame.
+
+   Finally, several threads unwind over and over while the main thread
+   keeps flushing the tables they are using.  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+#define MAX_FRAMES      64
+#define PASSES          3
+#define UNWINDERS       8
+#define FLUSHES         100
+/* collect() and compare() themselves; compare() may call collect()
+   from a different site in each pass.  */
+#define SKIP_FRAMES     2
+
+struct frame
+  {
+    unw_word_t ip;
+    unw_word_t sp;
+  };
+
+struct pass
+  {
+    struct frame frames[MAX_FRAMES];
+    void *trace[MAX_FRAMES];
+    int nframes;
+    int ntrace;
+  };
+
+int verbose;
+static int depth;
+static struct pass passes[PASSES];
+static volatile int flushing;
+
+static void NOINLINE
+collect (struct pass *p)
+{
+  unw_context_t uc;
+  unw_cursor_t c;
+
+  p->ntrace = unw_backtrace (p->trace, MAX_FRAMES);
+
+  UNW_TEST_ASSERT (unw_getcontext (&uc) == 0, "unw_getcontext failed\n");
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  p->nframes = 0;
+  do
+    {
+      struct frame *f = &p->frames[p->nframes++];
+
+      unw_get_reg (&c, UNW_REG_IP, &f->ip);
+      unw_get_reg (&c, UNW_REG_SP, &f->sp);
+    }
+  while (p->nframes < MAX_FRAMES && unw_step (&c) > 0);
+}
+
+/* Unwind the current stack once with compact tables being built, once
+   with them in use and once without them, and compare.  */
+static void NOINLINE
+compare (const char *what)
+{
+  static const unw_caching_policy_t policy[PASSES] =
+    {
+      UNW_CACHE_GLOBAL, UNW_CACHE_GLOBAL, UNW_CACHE_NONE
+    };
+  int i, j;
+
+  for (i = 0; i < PASSES; ++i)
+    {
+      unw_set_caching_policy (unw_local_addr_space, policy[i]);
+      collect (&passes[i]);
+    }
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_GLOBAL);
+
+  UNW_TEST_ASSERT (passes[0].nframes > depth, "%s: only %d frames\n",
+                   what, passes[0].nframes);
+  for (i = 1; i < PASSES; ++i)
+    {
+      UNW_TEST_ASSERT (passes[i].nframes == passes[0].nframes,
+                       "%s: %d frames in pass %d, %d in pass 0\n", what,
+                       passes[i].nframes, i, passes[0].nframes);
+      UNW_TEST_ASSERT (passes[i].ntrace == passes[0].ntrace,
+                       "%s: backtrace of %d frames in pass %d, %d in pass 0\n",
+                       what, passes[i].ntrace, i, passes[0].ntrace);
+      for (j = SKIP_FRAMES; j < passes[0].nframes; ++j)
+        UNW_TEST_ASSERT (memcmp (&passes[i].frames[j], &passes[0].frames[j],
+                                 sizeof (passes[0].frames[j])) == 0,
+                         "%s: frame %d differs in pass %d: ip=0x%lx sp=0x%lx,"
+                         " expected ip=0x%lx sp=0x%lx\n", what, j, i,
+                         (long) passes[i].frames[j].ip,
+                         (long) passes[i].frames[j].sp,
+                         (long) passes[0].frames[j].ip,
+                         (long) passes[0].frames[j].sp);
+      for (j = SKIP_FRAMES; j < passes[0].ntrace; ++j)
+        UNW_TEST_ASSERT (passes[i].trace[j] == passes[0].trace[j],
+                         "%s: backtrace frame %d differs in pass %d\n",
+                         what, j, i);
+    }
+
+  if (verbose)
+    printf ("%s: %d frames, backtrace of %d\n", what, passes[0].nframes,
+            passes[0].ntrace);
+}
+
+static void
+handler (int sig UNUSED)
+{
+  compare ("signal handler");
+}
+
+static int
+compare_ints (const void *a, const void *b)
+{
+  static int done;
+
+  /* qsort calls this many times; once is enough.  */
+  if (!done)
+    {
+      done = 1;
+      compare ("qsort callback");
+    }
+  return *(const int *) a - *(const int *) b;
+}
+
+static int NOINLINE
+recurse (int n, int use_signal)
+{
+  if (n > 0)
+    return recurse (n - 1, use_signal) + 1;
+
+  if (use_signal)
+    raise (SIGUSR1);
+  else
+    {
+      int values[] = { 3, 1, 2 };
+
+      qsort (values, 3, sizeof (values[0]), compare_ints);
+    }
+  return 0;
+}
+
+static int NOINLINE
+count_frames (int n)
+{
+  void *trace[MAX_FRAMES];
+  unw_context_t uc;
+  unw_cursor_t c;
+  int nframes = 0;
+
+  if (n > 0)
+    return count_frames (n - 1);
+
+  unw_backtrace (trace, MAX_FRAMES);
+  UNW_TEST_ASSERT (unw_getcontext (&uc) == 0, "unw_getcontext failed\n");
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  do
+    ++nframes;
+  while (nframes < MAX_FRAMES && unw_step (&c) > 0);
+  return nframes;
+}
+
+/* Unwind over and over while the main thread keeps flushing.  */
+static void *
+unwinder (void *arg UNUSED)
+{
+  int expected = count_frames (depth), nframes;
+
+  do
+    {
+      nframes = count_frames (depth);
+      UNW_TEST_ASSERT (nframes == expected, "%d frames while flushing,"
+                       " %d before\n", nframes, expected);
+    }
+  while (flushing);
+  return NULL;
+}
+
+static void
+flush_while_unwinding (void)
+{
+  pthread_t th[UNWINDERS];
+  int i;
+
+  flushing = 1;
+  for (i = 0; i < UNWINDERS; ++i)
+    UNW_TEST_ASSERT (pthread_create (&th[i], NULL, unwinder, NULL) == 0,
+                     "pthread_create failed\n");
+  for (i = 0; i < FLUSHES; ++i)
+    {
+      unw_flush_cache (unw_local_addr_space, 0, 0);
+      sched_yield ();
+    }
+  flushing = 0;
+  for (i = 0; i < UNWINDERS; ++i)
+    pthread_join (th[i], NULL);
+
+  if (verbose)
+    printf ("%d flushes while unwinding\n", FLUSHES);
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  struct sigaction sa;
+
+  verbose = argc > 1;
+  setenv ("UNW_COMPACT_UNWIND_TABLES", "1", 1);
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = handler;
+  sigaction (SIGUSR1, &sa, NULL);
+
+  depth = 8;
+  recurse (depth, 0);
+  recurse (depth, 1);
+  flush_while_unwinding ();
+
+  if (verbose)
+    printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
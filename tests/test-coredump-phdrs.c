@@ -0,0 +1,195 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test writes a corefile whose segments overlap and enclose one
+   another, and checks that every address is read from the segment that
+   comes first in program header order among those that contain it, no
+   matter which segment was read from before.  */
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <elf.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/procfs.h>
+#include <unistd.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#include <libunwind-coredump.h>
+
+/* The PT_LOAD segments, in program header order, each filled with its
+   own byte.  B lies inside A, and D starts inside C.  */
+static const struct
+  {
+    unw_word_t vaddr, memsz;
+    char fill;
+  } segments[] =
+  {
+    { 0x10000, 0x4000, 'A' },
+    { 0x11000, 0x1000, 'B' },
+    { 0x20000, 0x1000, 'C' },
+    { 0x20800, 0x1000, 'D' },
+  };
+#define NSEGMENTS (sizeof (segments) / sizeof (segments[0]))
+
+/* Addresses in the order they are read, with the byte expected there,
+   or 0 if the address is not in the core.  */
+static const struct
+  {
+    unw_word_t addr;
+    char fill;
+  } reads[] =
+  {
+    { 0x11100, 'A' },           /* in B too, but A comes first */
+    { 0x13000, 'A' },           /* above B, which starts closer */
+    { 0x10100, 'A' },
+    { 0x11100, 'A' },
+    { 0x20100, 'C' },
+    { 0x21400, 'D' },
+    { 0x20900, 'C' },           /* in D too, which was read last */
+    { 0x21400, 'D' },
+    { 0x14000, 0 },
+    { 0x30000, 0 },
+  };
+#define NREADS (sizeof (reads) / sizeof (reads[0]))
+
+struct note
+  {
+    ElfW(Nhdr) nhdr;
+    char name[8];
+    struct elf_prstatus prstatus;
+  };
+
+int verbose;
+
+/* Write the corefile to FD: the ELF header, the program headers, a
+   note with one thread and then the contents of each segment.  */
+static void
+write_core (int fd)
+{
+  ElfW(Ehdr) ehdr;
+  ElfW(Phdr) phdrs[NSEGMENTS + 1];
+  struct note note;
+  char contents[0x4000];        /* as big as the largest segment */
+  off_t offset;
+  unsigned i;
+
+  memset (&ehdr, 0, sizeof (ehdr));
+  memcpy (ehdr.e_ident, ELFMAG, SELFMAG);
+  ehdr.e_ident[EI_CLASS] = sizeof (void *) == 8 ? ELFCLASS64 : ELFCLASS32;
+  ehdr.e_ident[EI_DATA] = __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                          ? ELFDATA2MSB : ELFDATA2LSB;
+  ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+  ehdr.e_type = ET_CORE;
+  ehdr.e_version = EV_CURRENT;
+  ehdr.e_ehsize = sizeof (ehdr);
+  ehdr.e_phoff = sizeof (ehdr);
+  ehdr.e_phentsize = sizeof (phdrs[0]);
+  ehdr.e_phnum = NSEGMENTS + 1;
+
+  memset (&note, 0, sizeof (note));
+  note.nhdr.n_namesz = sizeof ("CORE");
+  note.nhdr.n_descsz = sizeof (note.prstatus);
+  note.nhdr.n_type = NT_PRSTATUS;
+  strcpy (note.name, "CORE");
+  note.prstatus.pr_pid = getpid ();
+
+  memset (phdrs, 0, sizeof (phdrs));
+  offset = sizeof (ehdr) + sizeof (phdrs);
+  phdrs[0].p_type = PT_NOTE;
+  phdrs[0].p_offset = offset;
+  phdrs[0].p_filesz = sizeof (note);
+  offset += sizeof (note);
+  for (i = 0; i < NSEGMENTS; i++)
+    {
+      phdrs[i + 1].p_type = PT_LOAD;
+      phdrs[i + 1].p_flags = PF_R;
+      phdrs[i + 1].p_offset = offset;
+      phdrs[i + 1].p_vaddr = segments[i].vaddr;
+      phdrs[i + 1].p_filesz = segments[i].memsz;
+      phdrs[i + 1].p_memsz = segments[i].memsz;
+      offset += segments[i].memsz;
+    }
+
+  UNW_TEST_ASSERT (write (fd, &ehdr, sizeof (ehdr)) == sizeof (ehdr)
+                   && write (fd, phdrs, sizeof (phdrs)) == sizeof (phdrs)
+                   && write (fd, &note, sizeof (note)) == sizeof (note),
+                   "cannot write corefile headers\n");
+  for (i = 0; i < NSEGMENTS; i++)
+    {
+      memset (contents, segments[i].fill, segments[i].memsz);
+      UNW_TEST_ASSERT (write (fd, contents, segments[i].memsz)
+                       == (ssize_t) segments[i].memsz,
+                       "cannot write segment %u\n", i);
+    }
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  char path[] = "/tmp/libunwind-test-XXXXXX";
+  unw_addr_space_t as;
+  struct UCD_info *ui;
+  unw_word_t val;
+  unsigned i;
+  int fd, ret;
+
+  verbose = argc > 1;
+
+  fd = mkstemp (path);
+  UNW_TEST_ASSERT (fd >= 0, "cannot create corefile\n");
+  write_core (fd);
+  close (fd);
+
+  as = unw_create_addr_space (&_UCD_accessors, 0);
+  UNW_TEST_ASSERT (as != NULL, "unw_create_addr_space failed\n");
+  ui = _UCD_create (path);
+  unlink (path);
+  UNW_TEST_ASSERT (ui != NULL, "_UCD_create failed\n");
+
+  for (i = 0; i < NREADS; i++)
+    {
+      /* Only the segments of the core can be read, as it has no
+         backing files.  */
+      ret = _UCD_access_mem (as, reads[i].addr, &val, 0, ui);
+      if (verbose)
+        printf ("%#lx: %d '%c'\n", (unsigned long) reads[i].addr, ret,
+                ret == 0 ? (char) val : ' ');
+      if (!reads[i].fill)
+        UNW_TEST_ASSERT (ret < 0, "%#lx is not in the core\n",
+                         (unsigned long) reads[i].addr);
+      else
+        UNW_TEST_ASSERT (ret == 0 && (char) val == reads[i].fill,
+                         "%#lx was not read from segment %c\n",
+                         (unsigned long) reads[i].addr, reads[i].fill);
+    }
+
+  _UCD_destroy (ui);
+  unw_destroy_addr_space (as);
+  return UNW_TEST_EXIT_PASS;
+}
@@ -0,0 +1,243 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test makes a child with several threads dump core, then unwinds
+   all threads of the core at the same time, each from a handle made
+   with _UCD_create_for_thread(), and checks that every thread gives the
+   same frames as unwinding it alone through the handle of _UCD_create().
+   The test is skipped if the child does not leave a core file in the
+   temporary directory it runs in.  */
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <dirent.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#include <libunwind-coredump.h>
+
+#define NPARKED         8       /* threads of the child besides main */
+#define NWORKERS        4       /* threads unwinding the core */
+#define MAX_FRAMES      32
+#define MAX_THREADS     (NPARKED + 1)
+
+struct trace
+  {
+    unw_word_t ips[MAX_FRAMES];
+    int nframes;
+    int parked;                 /* went through park() */
+  };
+
+static pthread_barrier_t parked;
+static volatile sig_atomic_t stop;
+static char tmpdir[] = "/tmp/libunwind-test-XXXXXX";
+static unw_addr_space_t as;
+static struct UCD_info *core;
+static struct trace serial[MAX_THREADS], concurrent[MAX_THREADS];
+static int nthreads;
+
+int verbose;
+
+/* The child: park NPARKED threads a few frames deep, then crash.  */
+static int NOINLINE
+park (int depth)
+{
+  if (depth > 0)
+    return park (depth - 1) + 1;
+  pthread_barrier_wait (&parked);
+  while (!stop)
+    pause ();
+  return 0;
+}
+
+static void *
+parked_thread (void *arg)
+{
+  return (void *) (intptr_t) park ((int) (intptr_t) arg);
+}
+
+static void
+child (void)
+{
+  struct rlimit rl = { RLIM_INFINITY, RLIM_INFINITY };
+  pthread_t t;
+  int i;
+
+  setrlimit (RLIMIT_CORE, &rl);
+  pthread_barrier_init (&parked, NULL, NPARKED + 1);
+  for (i = 0; i < NPARKED; ++i)
+    pthread_create (&t, NULL, parked_thread, (void *) (intptr_t) (i % 4));
+  pthread_barrier_wait (&parked);
+  signal (SIGABRT, SIG_DFL);
+  abort ();
+}
+
+/* Return the name of the core file the child left in tmpdir, or NULL.  */
+static char *
+find_core (void)
+{
+  static char path[sizeof (tmpdir) + 256];
+  struct dirent *d;
+  DIR *dir;
+  int found = 0;
+
+  if (!(dir = opendir (tmpdir)))
+    return NULL;
+  while (!found && (d = readdir (dir)))
+    if (strncmp (d->d_name, "core", 4) == 0)
+      {
+        snprintf (path, sizeof (path), "%s/%s", tmpdir, d->d_name);
+        found = 1;
+      }
+  closedir (dir);
+  return found ? path : NULL;
+}
+
+static void
+remove_tmpdir (void)
+{
+  char *path;
+
+  while ((path = find_core ()))
+    unlink (path);
+  rmdir (tmpdir);
+}
+
+static void
+unwind (struct UCD_info *ui, struct trace *t)
+{
+  unw_cursor_t c;
+  unw_word_t off;
+  char name[64];
+
+  UNW_TEST_ASSERT (unw_init_remote (&c, as, ui) == 0,
+                   "unw_init_remote failed\n");
+  t->nframes = 0;
+  t->parked = 0;
+  do
+    {
+      unw_get_reg (&c, UNW_REG_IP, &t->ips[t->nframes++]);
+      if (unw_get_proc_name (&c, name, sizeof (name), &off) == 0
+          && strcmp (name, "park") == 0)
+        t->parked = 1;
+    }
+  while (t->nframes < MAX_FRAMES && unw_step (&c) > 0);
+}
+
+static void *
+worker (void *arg)
+{
+  struct UCD_info *ui;
+  int i;
+
+  for (i = (int) (intptr_t) arg; i < nthreads; i += NWORKERS)
+    {
+      ui = _UCD_create_for_thread (core, i);
+      UNW_TEST_ASSERT (ui != NULL, "_UCD_create_for_thread failed\n");
+      unwind (ui, &concurrent[i]);
+      _UCD_destroy (ui);
+    }
+  return NULL;
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  pthread_t workers[NWORKERS];
+  char *corefile;
+  pid_t pid;
+  int i, n, status, nparked = 0;
+
+  verbose = argc > 1;
+
+  UNW_TEST_ASSERT (mkdtemp (tmpdir) != NULL, "mkdtemp failed\n");
+  pid = fork ();
+  UNW_TEST_ASSERT (pid >= 0, "fork failed\n");
+  if (pid == 0)
+    {
+      if (chdir (tmpdir) == 0)
+        child ();
+      _exit (1);
+    }
+  waitpid (pid, &status, 0);
+  if (!(corefile = find_core ()))
+    {
+      printf ("child did not leave a core file, test skipped\n");
+      remove_tmpdir ();
+      return UNW_TEST_EXIT_SKIP;
+    }
+
+  UNW_TEST_ASSERT ((core = _UCD_create (corefile)) != NULL,
+                   "_UCD_create failed\n");
+  nthreads = _UCD_get_num_threads (core);
+  UNW_TEST_ASSERT (nthreads == MAX_THREADS, "%d threads in the core\n",
+                   nthreads);
+  UNW_TEST_ASSERT (_UCD_create_for_thread (core, nthreads) == NULL,
+                   "handle for a thread that does not exist\n");
+
+  as = unw_create_addr_space (&_UCD_accessors, 0);
+  UNW_TEST_ASSERT (as != NULL, "unw_create_addr_space failed\n");
+  unw_set_caching_policy (as, UNW_CACHE_GLOBAL);
+
+  /* All threads at once, through one shared address space...  */
+  for (i = 0; i < NWORKERS; ++i)
+    pthread_create (&workers[i], NULL, worker, (void *) (intptr_t) i);
+  for (i = 0; i < NWORKERS; ++i)
+    pthread_join (workers[i], NULL);
+
+  /* ...must give what unwinding them one by one gives.  */
+  for (i = 0; i < nthreads; ++i)
+    {
+      _UCD_select_thread (core, i);
+      unwind (core, &serial[i]);
+      if (verbose)
+        printf ("thread %d: %d frames%s\n", i, serial[i].nframes,
+                serial[i].parked ? ", parked" : "");
+      UNW_TEST_ASSERT (concurrent[i].nframes == serial[i].nframes,
+                       "thread %d: %d frames instead of %d\n", i,
+                       concurrent[i].nframes, serial[i].nframes);
+      for (n = 0; n < serial[i].nframes; ++n)
+        UNW_TEST_ASSERT (concurrent[i].ips[n] == serial[i].ips[n],
+                         "thread %d: frame %d differs\n", i, n);
+      UNW_TEST_ASSERT (concurrent[i].parked == serial[i].parked,
+                       "thread %d: procedure names differ\n", i);
+      nparked += serial[i].parked;
+    }
+  UNW_TEST_ASSERT (nparked == NPARKED, "%d of %d threads found in park()\n",
+                   nparked, NPARKED);
+
+  unw_destroy_addr_space (as);
+  _UCD_destroy (core);
+  remove_tmpdir ();
+  return UNW_TEST_EXIT_PASS;
+}
@@ -0,0 +1,214 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+
+/* This test verifies lookups of dynamically registered unwind info
+   while many regions are registered and cancelled in random order,
+   with another thread looking up addresses at the same time.  It also
+   checks that an overlapping region registered later takes precedence,
+   as it always has, also when several regions are nested in one.  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+#define NREGIONS        4096
+#define REGION_SIZE     16
+#define REGION_STRIDE   32
+#define NESTED_SIZE     256
+
+int verbose;
+static unw_dyn_info_t regions[NREGIONS];
+static unw_dyn_info_t overlap;
+static unw_dyn_info_t nested[3];
+static char *base;
+static atomic_int done;
+
+/* Return the start of the dynamic region covering IP, or 0.  */
+static unw_word_t
+lookup (unw_word_t ip)
+{
+  unw_proc_info_t pi;
+
+  if (unw_get_proc_info_by_ip (unw_local_addr_space, ip, &pi, NULL) < 0
+      || pi.format != UNW_INFO_FORMAT_DYNAMIC)
+    return 0;
+  return pi.start_ip;
+}
+
+static void
+check (int i, int registered)
+{
+  unw_word_t start = regions[i].start_ip;
+  unw_word_t expected = registered ? start : 0;
+
+  UNW_TEST_ASSERT (lookup (start) == expected,
+                   "region %d: lookup of start gave 0x%lx\n", i,
+                   (long) lookup (start));
+  UNW_TEST_ASSERT (lookup (start + REGION_SIZE - 1) == expected,
+                   "region %d: lookup of end gave 0x%lx\n", i,
+                   (long) lookup (start + REGION_SIZE - 1));
+  UNW_TEST_ASSERT (lookup (start + REGION_SIZE) == 0,
+                   "region %d: lookup past end gave 0x%lx\n", i,
+                   (long) lookup (start + REGION_SIZE));
+}
+
+static void *
+reader (void *arg UNUSED)
+{
+  unsigned int seed = 1;
+  unw_word_t ip, start;
+
+  while (! atomic_load (&done))
+    {
+      ip = (unw_word_t) base + rand_r (&seed) % (NREGIONS * REGION_STRIDE);
+      start = lookup (ip);
+      /* The overlapping region starts at BASE and covers everything. */
+      UNW_TEST_ASSERT (start == 0 || start == (unw_word_t) base
+                       || (start <= ip && ip < start + REGION_SIZE),
+                       "lookup of 0x%lx gave region at 0x%lx\n", (long) ip,
+                       (long) start);
+    }
+  return NULL;
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  int order[NREGIONS];
+  pthread_t thread;
+  char *nest_base;
+  int i, j, tmp;
+
+  verbose = argc > 1;
+
+  /* Reserve the address range so that it cannot belong to any object. */
+  base = mmap (NULL, NREGIONS * REGION_STRIDE, PROT_NONE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  UNW_TEST_ASSERT (base != MAP_FAILED, "mmap failed\n");
+
+  for (i = 0; i < NREGIONS; ++i)
+    {
+      regions[i].start_ip = (unw_word_t) base + i * REGION_STRIDE;
+      regions[i].end_ip = regions[i].start_ip + REGION_SIZE;
+      regions[i].format = UNW_INFO_FORMAT_DYNAMIC;
+      order[i] = i;
+    }
+  srand (42);
+  for (i = NREGIONS - 1; i > 0; --i)
+    {
+      j = rand () % (i + 1);
+      tmp = order[i];
+      order[i] = order[j];
+      order[j] = tmp;
+    }
+
+  pthread_create (&thread, NULL, reader, NULL);
+
+  for (i = 0; i < NREGIONS; ++i)
+    _U_dyn_register (&regions[order[i]]);
+  for (i = 0; i < NREGIONS; ++i)
+    check (i, 1);
+
+  for (i = 0; i < NREGIONS; i += 2)
+    _U_dyn_cancel (&regions[order[i]]);
+  for (i = 0; i < NREGIONS; ++i)
+    check (order[i], i & 1);
+
+  /* A later region covering the others wins wherever it applies.  */
+  overlap.start_ip = (unw_word_t) base;
+  overlap.end_ip = (unw_word_t) base + NREGIONS * REGION_STRIDE;
+  overlap.format = UNW_INFO_FORMAT_DYNAMIC;
+  _U_dyn_register (&overlap);
+  for (i = 0; i < NREGIONS; ++i)
+    UNW_TEST_ASSERT (lookup (regions[i].start_ip) == overlap.start_ip,
+                     "region %d: not covered by the overlapping region\n", i);
+  _U_dyn_cancel (&overlap);
+  for (i = 0; i < NREGIONS; ++i)
+    check (order[i], i & 1);
+
+  /* Two regions nested in a third: the second is not next to the first,
+     but still overlaps the outer one, which must be found beside the
+     inner ones whichever is cancelled first.  */
+  nest_base = mmap (NULL, NESTED_SIZE, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  UNW_TEST_ASSERT (nest_base != MAP_FAILED, "mmap failed\n");
+  for (i = 0; i < 3; ++i)
+    {
+      nested[i].start_ip = (unw_word_t) nest_base + (i ? 20 * i - 10 : 0);
+      nested[i].end_ip = nested[i].start_ip + (i ? 10 : 100);
+      nested[i].format = UNW_INFO_FORMAT_DYNAMIC;
+      _U_dyn_register (&nested[i]);
+    }
+  UNW_TEST_ASSERT (lookup (nested[0].start_ip + 50) == nested[0].start_ip
+                   && lookup (nested[1].start_ip) == nested[1].start_ip
+                   && lookup (nested[2].start_ip) == nested[2].start_ip,
+                   "nested regions not found\n");
+  _U_dyn_cancel (&nested[1]);
+  UNW_TEST_ASSERT (lookup (nested[0].start_ip + 50) == nested[0].start_ip
+                   && lookup (nested[1].start_ip) == nested[0].start_ip
+                   && lookup (nested[2].start_ip) == nested[2].start_ip,
+                   "outer region lost after cancelling an inner one\n");
+  _U_dyn_cancel (&nested[2]);
+  _U_dyn_cancel (&nested[0]);
+  UNW_TEST_ASSERT (lookup (nested[0].start_ip + 50) == 0,
+                   "cancelled region still found\n");
+
+  atomic_store (&done, 1);
+  pthread_join (thread, NULL);
+
+  for (i = 1; i < NREGIONS; i += 2)
+    _U_dyn_cancel (&regions[order[i]]);
+  for (i = 0; i < NREGIONS; ++i)
+    check (i, 0);
+
+  if (verbose)
+    printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
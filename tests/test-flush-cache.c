@@ -36,15 +36,15 @@ int verbose;
 int
 f257 (void)
 {
-  void *buffer[300];
-  int i, n;
+  void *buffer[300], *first[300];
+  int i, n, first_n;
 
   if (verbose)
     printf ("First backtrace:\n");
-  n = unw_backtrace (buffer, 300);
+  n = first_n = unw_backtrace (first, 300);
   if (verbose)
     for (i = 0; i < n; ++i)
-      printf ("[%d] ip=%p\n", i, buffer[i]);
+      printf ("[%d] ip=%p\n", i, first[i]);
 
   unw_set_cache_size (unw_local_addr_space, 1023, 0);
   unw_flush_cache (unw_local_addr_space, 0, 0);
@@ -55,6 +55,29 @@ f257 (void)
   if (verbose)
     for (i = 0; i < n; ++i)
       printf ("[%d] ip=%p\n", i, buffer[i]);
+  /* Frame 0 is the unw_backtrace() call site and naturally differs.  */
+  if (n != first_n
+      || memcmp (buffer + 1, first + 1, (n - 1) * sizeof (buffer[0])) != 0)
+    {
+      printf ("FAILURE: second backtrace differs from the first\n");
+      return 1;
+    }
+
+  /* More entries than 16-bit cache indices could address.  */
+  unw_set_cache_size (unw_local_addr_space, 1 << 17, 0);
+
+  if (verbose)
+    printf ("\nThird backtrace:\n");
+  n = unw_backtrace (buffer, 300);
+  if (verbose)
+    for (i = 0; i < n; ++i)
+      printf ("[%d] ip=%p\n", i, buffer[i]);
+  if (n != first_n
+      || memcmp (buffer + 1, first + 1, (n - 1) * sizeof (buffer[0])) != 0)
+    {
+      printf ("FAILURE: third backtrace differs from the first\n");
+      return 1;
+    }
   return 0;
 }
 
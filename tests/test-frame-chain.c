@@ -0,0 +1,178 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test verifies unw_update_frame_chain(): that a second sample
+   further down the same stack keeps the outer frames of the first one,
+   that the result always equals a walk from scratch, and that frames
+   which were popped and rebuilt at the same place under a different
+   caller are not taken over.  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+#define DEPTH           100
+#define MAX_FRAMES      512
+
+int verbose;
+volatile int calls;  /* keeps the calls below from becoming jumps */
+
+static unw_chain_frame_t frames[MAX_FRAMES];
+static unw_chain_frame_t ref_frames[MAX_FRAMES];
+static unw_frame_chain_t chain = { frames, MAX_FRAMES, 0, 0, 0 };
+static unw_frame_chain_t ref = { ref_frames, MAX_FRAMES, 0, 0, 0 };
+
+/* Update CHAIN from the current stack, then walk the same stack from
+   scratch into REF and compare the two.  */
+static void NOINLINE
+sample (const char *what)
+{
+  unw_context_t uc;
+  unw_cursor_t c;
+  int depth, i;
+
+  UNW_TEST_ASSERT (unw_getcontext (&uc) == 0, "unw_getcontext failed\n");
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  depth = unw_update_frame_chain (&c, &chain);
+  UNW_TEST_ASSERT (depth > 0, "%s: unw_update_frame_chain returned %d\n",
+                   what, depth);
+
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  ref.depth = 0;
+  UNW_TEST_ASSERT (unw_update_frame_chain (&c, &ref) == ref.depth
+                   && ref.reused == 0, "%s: walk from scratch failed\n", what);
+
+  if (verbose)
+    printf ("%s: %d frames, %d reused\n", what, chain.depth, chain.reused);
+  if (chain.truncated)
+    UNW_TEST_ASSERT (chain.depth == chain.size && ref.depth > chain.depth,
+                     "%s: cut off at %d frames of %d\n",
+                     what, chain.depth, ref.depth);
+  else
+    UNW_TEST_ASSERT (chain.depth == ref.depth, "%s: %d frames, expected %d\n",
+                     what, chain.depth, ref.depth);
+  for (i = 0; i < chain.depth; ++i)
+    UNW_TEST_ASSERT (chain.frames[i].ip == ref.frames[i].ip
+                     && chain.frames[i].sp == ref.frames[i].sp,
+                     "%s: frame %d is %#lx/%#lx, expected %#lx/%#lx\n", what, i,
+                     (long) chain.frames[i].ip, (long) chain.frames[i].sp,
+                     (long) ref.frames[i].ip, (long) ref.frames[i].sp);
+}
+
+static void NOINLINE
+leaf (int n)
+{
+  if (n > 0)
+    leaf (n - 1);
+  else
+    sample ("leaf");
+  ++calls;
+}
+
+static void NOINLINE
+recurse (int n, int mode)
+{
+  if (n > 0)
+    recurse (n - 1, mode);
+  else if (mode == 0)
+    {
+      sample ("first");
+      UNW_TEST_ASSERT (chain.reused == 0, "nothing to reuse yet\n");
+
+      sample ("same place");
+      UNW_TEST_ASSERT (chain.reused >= DEPTH,
+                       "only %d frames reused at the same place\n",
+                       chain.reused);
+
+      leaf (5);
+      UNW_TEST_ASSERT (chain.reused >= DEPTH,
+                       "only %d frames reused below the first sample\n",
+                       chain.reused);
+    }
+  else
+    sample ("other caller");
+  ++calls;
+}
+
+static void NOINLINE
+run_a (void)
+{
+  recurse (DEPTH, 0);
+  ++calls;
+}
+
+static void NOINLINE
+run_b (void)
+{
+  recurse (DEPTH, 1);
+  ++calls;
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  verbose = (argc > 1);
+
+  run_a ();
+
+  /* The recursion is rebuilt at the same addresses, but under run_b. */
+  run_b ();
+  UNW_TEST_ASSERT (chain.reused < DEPTH,
+                   "%d frames reused under a different caller\n", chain.reused);
+
+  /* A chain which is too short for the stack is cut off.  */
+  chain.size = 8;
+  chain.depth = 0;
+  run_b ();
+  run_b ();
+  UNW_TEST_ASSERT (chain.depth == 8 && chain.truncated,
+                   "short chain: %d frames, truncated %d\n",
+                   chain.depth, chain.truncated);
+
+  if (verbose)
+    printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
@@ -0,0 +1,156 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test verifies that procedure info for local IPs stays correct
+   while objects are loaded and unloaded.  Local lookups go through a
+   snapshot of the loaded objects that is only refreshed when the
+   loader's object list changes, so a stale snapshot would show up as
+   missing or wrong procedure info after dlopen() or dlclose().  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+static const char *libraries[] =
+  {
+    "libm.so.6", "libresolv.so.2", "libutil.so.1", "libz.so.1"
+  };
+
+static const char *symbols[] =
+  {
+    "cos", "res_query", "openpty", "crc32"
+  };
+
+int verbose;
+
+void NOINLINE
+local_function (void)
+{
+  if (verbose)
+    printf ("%s\n", __func__);
+}
+
+static void
+check_ip (const char *what, unw_word_t ip)
+{
+  unw_proc_info_t pi;
+  int ret;
+
+  ret = unw_get_proc_info_by_ip (unw_local_addr_space, ip, &pi, NULL);
+  UNW_TEST_ASSERT (ret == 0, "no proc info for %s at 0x%lx (%d)\n",
+                   what, (long) ip, ret);
+  UNW_TEST_ASSERT (pi.start_ip <= ip && ip < pi.end_ip,
+                   "proc info for %s at 0x%lx covers 0x%lx-0x%lx\n",
+                   what, (long) ip, (long) pi.start_ip, (long) pi.end_ip);
+  if (verbose)
+    printf ("%s: 0x%lx in 0x%lx-0x%lx\n", what, (long) ip,
+            (long) pi.start_ip, (long) pi.end_ip);
+}
+
+static void
+check_local_ips (void)
+{
+  void *libc_function = dlsym (RTLD_DEFAULT, "qsort");
+
+  check_ip ("local_function", (unw_word_t) (uintptr_t) &local_function);
+  if (libc_function)
+    check_ip ("qsort", (unw_word_t) (uintptr_t) libc_function);
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  unw_proc_info_t pi;
+  void *handles[sizeof (libraries) / sizeof (libraries[0])];
+  size_t i;
+  int round;
+
+  verbose = argc > 1;
+
+  check_local_ips ();
+
+  /* An address outside of every object must not be attributed to one. */
+  UNW_TEST_ASSERT (unw_get_proc_info_by_ip (unw_local_addr_space, 16,
+                                            &pi, NULL) < 0,
+                   "found proc info for an unmapped address\n");
+
+  /* The second round typically loads the objects at the addresses
+     they had in the first one, which must not be mistaken for the
+     objects the snapshot still remembers.  */
+  for (round = 0; round < 2; ++round)
+    {
+      for (i = 0; i < sizeof (libraries) / sizeof (libraries[0]); ++i)
+        {
+          void *sym;
+
+          handles[i] = dlopen (libraries[i], RTLD_NOW | RTLD_LOCAL);
+          if (!handles[i])
+            {
+              if (verbose)
+                printf ("could not load %s, skipping\n", libraries[i]);
+              continue;
+            }
+
+          sym = dlsym (handles[i], symbols[i]);
+          if (sym)
+            check_ip (symbols[i], (unw_word_t) (uintptr_t) sym);
+          check_local_ips ();
+        }
+
+      for (i = 0; i < sizeof (libraries) / sizeof (libraries[0]); ++i)
+        {
+          if (!handles[i])
+            continue;
+          dlclose (handles[i]);
+          check_local_ips ();
+        }
+    }
+
+  if (verbose)
+    printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
@@ -0,0 +1,432 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test checks that what a libunwind-ptrace address space caches
+   about its targets never outlives what it describes.  A forked copy
+   of the test stops in two different functions and is resumed with
+   ptrace() directly in between, so each unwind has to see the target's
+   current registers and memory, while the unwind tables of its objects
+   are kept when it is resumed with _UPT_resume().  The two programs named on the command line, if
+   any, are started with address space randomisation disabled, so that
+   their code lands at the same addresses, and the names found for
+   those addresses by unw_get_proc_names_by_ip() in one shared address
+   space must be the ones of the right program.  */
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/personality.h>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#include <libunwind-ptrace.h>
+
+#define MAX_IPS         1024
+#define ARENA_SIZE      (64 * 1024)
+#define MAX_FRAMES      64
+
+struct target
+  {
+    const char *path;
+    pid_t pid;
+    struct UPT_info *ui;
+    unw_word_t text_start, text_end;
+  };
+
+extern char **environ;
+
+static struct target targets[2];
+static struct target self = { "self", 0, NULL, 0, 0 };
+static unw_addr_space_t as;
+static volatile unw_word_t stops;
+
+int verbose;
+
+static void
+kill_targets (void)
+{
+  unsigned int i;
+
+  for (i = 0; i < sizeof (targets) / sizeof (targets[0]); ++i)
+    if (targets[i].pid > 0)
+      {
+        kill (targets[i].pid, SIGKILL);
+        waitpid (targets[i].pid, NULL, 0);
+        targets[i].pid = 0;
+      }
+  if (self.pid > 0)
+    {
+      kill (self.pid, SIGKILL);
+      waitpid (self.pid, NULL, 0);
+      self.pid = 0;
+    }
+}
+
+static void NOINLINE
+stop_a (void)
+{
+  raise (SIGSTOP);
+  ++stops;
+}
+
+static void NOINLINE
+stop_b (void)
+{
+  raise (SIGSTOP);
+  stops += 2;
+}
+
+/* Wait for T to stop with SIG.  */
+static void
+wait_stop (struct target *t, int sig)
+{
+  int status;
+
+  UNW_TEST_ASSERT (waitpid (t->pid, &status, 0) == t->pid,
+                   "waitpid() failed: %s\n", strerror (errno));
+  if (WIFEXITED (status) && WEXITSTATUS (status) == UNW_TEST_EXIT_SKIP)
+    {
+      fprintf (stderr, "ptrace() is not permitted, skipping\n");
+      t->pid = 0;
+      exit (UNW_TEST_EXIT_SKIP);
+    }
+  UNW_TEST_ASSERT (WIFSTOPPED (status) && WSTOPSIG (status) == sig,
+                   "%s did not stop with signal %d (status %#x)\n",
+                   t->path, sig, status);
+}
+
+/* Start a copy of this program which stops in stop_a(), then in
+   stop_b().  */
+static void
+start_self (struct target *t)
+{
+  t->pid = fork ();
+  UNW_TEST_ASSERT (t->pid >= 0, "fork() failed: %s\n", strerror (errno));
+  if (t->pid == 0)
+    {
+      if (ptrace (PTRACE_TRACEME, 0, 0, 0) == -1)
+        _exit (UNW_TEST_EXIT_SKIP);
+      stop_a ();
+      stop_b ();
+      _exit (UNW_TEST_EXIT_PASS);
+    }
+
+  wait_stop (t, SIGSTOP);
+  t->ui = _UPT_create (t->pid);
+  UNW_TEST_ASSERT (t->ui != NULL, "_UPT_create() failed\n");
+}
+
+static void
+finish_target (struct target *t)
+{
+  _UPT_destroy (t->ui);
+  t->ui = NULL;
+  kill (t->pid, SIGKILL);
+  waitpid (t->pid, NULL, 0);
+  t->pid = 0;
+}
+
+/* Let T run to its next stop without telling libunwind.  */
+static void
+continue_target (struct target *t)
+{
+  UNW_TEST_ASSERT (ptrace (PTRACE_CONT, t->pid, 0, 0) == 0,
+                   "PTRACE_CONT failed: %s\n", strerror (errno));
+  wait_stop (t, SIGSTOP);
+}
+
+/* Unwind the stopped target T and report whether a frame is in FUNC.  */
+static int
+has_frame (struct target *t, const char *func)
+{
+  unw_cursor_t c;
+  unw_word_t off;
+  char buf[512];
+  int ret, n = 0, found = 0;
+
+  ret = unw_init_remote (&c, as, t->ui);
+  UNW_TEST_ASSERT (ret == 0, "unw_init_remote() failed: %d\n", ret);
+  do
+    {
+      if (unw_get_proc_name (&c, buf, sizeof (buf), &off) == 0)
+        {
+          if (verbose)
+            printf ("%s: frame %d in %s+%#lx\n", t->path, n, buf, (long) off);
+          if (strcmp (buf, func) == 0)
+            found = 1;
+        }
+    }
+  while (++n < MAX_FRAMES && unw_step (&c) > 0);
+  return found;
+}
+
+static void
+check_stops (void)
+{
+  start_self (&self);
+  UNW_TEST_ASSERT (has_frame (&self, "stop_a"), "stop_a() not found\n");
+  continue_target (&self);
+  UNW_TEST_ASSERT (has_frame (&self, "stop_b"), "stop_b() not found\n");
+  UNW_TEST_ASSERT (!has_frame (&self, "stop_a"), "stale frame stop_a()\n");
+  finish_target (&self);
+}
+
+/* Unwinding the target again after _UPT_resume() must not map and
+   parse its objects again.  */
+static void
+check_tables (void)
+{
+  unw_stats_t before, after;
+  int ret;
+
+  /* Earlier checks unwound the same addresses; make them look up their
+     unwind info again.  */
+  unw_flush_cache (as, 0, 0);
+  start_self (&self);
+  UNW_TEST_ASSERT (has_frame (&self, "stop_a"), "stop_a() not found\n");
+  if (unw_get_stats (as, &before) < 0)
+    {
+      printf ("statistics are disabled, not counting table rebuilds\n");
+      finish_target (&self);
+      return;
+    }
+  ret = _UPT_resume (as, NULL, self.ui);
+  UNW_TEST_ASSERT (ret == 0, "_UPT_resume() failed: %d\n", ret);
+  wait_stop (&self, SIGSTOP);
+  UNW_TEST_ASSERT (has_frame (&self, "stop_b"), "stop_b() not found\n");
+  unw_get_stats (as, &after);
+  UNW_TEST_ASSERT (after.elf_maps == before.elf_maps,
+                   "%lu objects mapped again after _UPT_resume()\n",
+                   after.elf_maps - before.elf_maps);
+  finish_target (&self);
+}
+
+/* Read the counter of the stopped target at the start of an unwind.  */
+static unw_word_t
+read_stops (struct target *t)
+{
+  unw_accessors_t *a = unw_get_accessors (as);
+  unw_cursor_t c;
+  unw_word_t val;
+  int ret;
+
+  ret = unw_init_remote (&c, as, t->ui);
+  UNW_TEST_ASSERT (ret == 0, "unw_init_remote() failed: %d\n", ret);
+  ret = (*a->access_mem) (as, (unw_word_t) (uintptr_t) &stops, &val, 0,
+                          t->ui);
+  UNW_TEST_ASSERT (ret == 0, "access_mem() failed: %d\n", ret);
+  return val;
+}
+
+static void
+check_memory (void)
+{
+  unw_word_t before, after;
+
+  start_self (&self);
+  before = read_stops (&self);
+  continue_target (&self);
+  after = read_stops (&self);
+  UNW_TEST_ASSERT (before == 0 && after == 1,
+                   "read %lu and %lu, expected 0 and 1\n",
+                   (unsigned long) before, (unsigned long) after);
+  finish_target (&self);
+}
+
+/* Start T->path stopped right after its exec.  */
+static void
+start_target (struct target *t)
+{
+  char *args[2] = { (char *) t->path, NULL };
+
+  t->pid = fork ();
+  UNW_TEST_ASSERT (t->pid >= 0, "fork() failed: %s\n", strerror (errno));
+  if (t->pid == 0)
+    {
+      if (ptrace (PTRACE_TRACEME, 0, 0, 0) == -1)
+        _exit (UNW_TEST_EXIT_SKIP);
+      personality (ADDR_NO_RANDOMIZE);
+      dup2 (open ("/dev/null", O_WRONLY), 1);
+      execve (t->path, args, environ);
+      _exit (UNW_TEST_EXIT_HARD_ERROR);
+    }
+
+  wait_stop (t, SIGTRAP);
+  t->ui = _UPT_create (t->pid);
+  UNW_TEST_ASSERT (t->ui != NULL, "_UPT_create() failed\n");
+}
+
+/* Find the first executable mapping of T->path in the target.  */
+static void
+find_text (struct target *t)
+{
+  char maps[64], line[PATH_MAX + 128], path[PATH_MAX], real[PATH_MAX];
+  unsigned long start, end;
+  char perm[5];
+  FILE *f;
+
+  UNW_TEST_ASSERT (realpath (t->path, real) != NULL,
+                   "cannot resolve %s\n", t->path);
+  snprintf (maps, sizeof (maps), "/proc/%d/maps", (int) t->pid);
+  UNW_TEST_ASSERT ((f = fopen (maps, "r")) != NULL,
+                   "cannot open %s\n", maps);
+  while (fgets (line, sizeof (line), f))
+    if (sscanf (line, "%lx-%lx %4s %*s %*s %*s %s",
+                &start, &end, perm, path) == 4
+        && perm[2] == 'x' && strcmp (path, real) == 0)
+      {
+        t->text_start = start;
+        t->text_end = end;
+        break;
+      }
+  fclose (f);
+  UNW_TEST_ASSERT (t->text_start != 0, "no text mapping of %s\n", real);
+}
+
+/* Resolve IPS for target T in one batch and compare every name with
+   what unw_get_proc_name_by_ip() finds for the same address.  Returns
+   the number of names found.  */
+static int
+check_batch (struct target *t, const unw_word_t *ips, size_t n,
+             const char **names)
+{
+  static char arena[ARENA_SIZE];
+  unw_word_t offs[MAX_IPS], off;
+  char buf[512];
+  size_t i;
+  int ret;
+
+  ret = unw_get_proc_names_by_ip (as, ips, n, names, offs, arena,
+                                  sizeof (arena), t->ui);
+  UNW_TEST_ASSERT (ret >= 0, "unw_get_proc_names_by_ip() failed: %d\n", ret);
+
+  for (i = 0; i < n; ++i)
+    {
+      if (unw_get_proc_name_by_ip (as, ips[i], buf, sizeof (buf), &off,
+                                   t->ui) != 0)
+        {
+          UNW_TEST_ASSERT (names[i] == NULL,
+                           "%s: %#lx resolved to %s, expected no name\n",
+                           t->path, (long) ips[i], names[i]);
+          continue;
+        }
+      UNW_TEST_ASSERT (names[i] != NULL && strcmp (names[i], buf) == 0
+                       && offs[i] == off,
+                       "%s: %#lx resolved to %s+%#lx, expected %s+%#lx\n",
+                       t->path, (long) ips[i],
+                       names[i] ? names[i] : "(null)", (long) offs[i],
+                       buf, (long) off);
+      if (verbose)
+        printf ("%s: %#lx %s+%#lx\n", t->path, (long) ips[i], buf, (long) off);
+    }
+  return ret;
+}
+
+static void
+check_names (void)
+{
+  static const char *names[2][MAX_IPS];
+  unw_word_t ips[MAX_IPS], start, end, step;
+  size_t i, n, differ = 0;
+
+  find_text (&targets[0]);
+  find_text (&targets[1]);
+  start = targets[0].text_start > targets[1].text_start
+          ? targets[0].text_start : targets[1].text_start;
+  end = targets[0].text_end < targets[1].text_end
+        ? targets[0].text_end : targets[1].text_end;
+  if (start >= end)
+    {
+      fprintf (stderr, "the targets share no code addresses, skipping\n");
+      exit (UNW_TEST_EXIT_SKIP);
+    }
+
+  step = (end - start) / MAX_IPS;
+  if (step == 0)
+    step = 1;
+  for (n = 0; n < MAX_IPS && start + n * step < end; ++n)
+    ips[n] = start + n * step;
+
+  /* The first batch leaves a symbol table of the first target on the
+     address space, which must not serve the second one.  */
+  UNW_TEST_ASSERT (check_batch (&targets[0], ips, n, names[0]) > 0,
+                   "no names found in %s\n", targets[0].path);
+  UNW_TEST_ASSERT (check_batch (&targets[1], ips, n, names[1]) > 0,
+                   "no names found in %s\n", targets[1].path);
+
+  for (i = 0; i < n; ++i)
+    if (!names[0][i] || !names[1][i] || strcmp (names[0][i], names[1][i]))
+      ++differ;
+  UNW_TEST_CHECK (differ > 0, "the targets have the same names\n");
+}
+
+int
+main (int argc, char **argv)
+{
+  int optind = 1;
+
+  if (optind < argc && strcmp (argv[optind], "-v") == 0)
+    ++optind, verbose = 1;
+  if (argc - optind != 0 && argc - optind != 2)
+    {
+      fprintf (stderr, "usage: %s [-v] [program1 program2]\n", argv[0]);
+      return UNW_TEST_EXIT_BAD_COMMAND;
+    }
+
+  as = unw_create_addr_space (&_UPT_accessors, 0);
+  UNW_TEST_ASSERT (as != NULL, "unw_create_addr_space() failed\n");
+  unw_set_caching_policy (as, UNW_CACHE_GLOBAL);
+
+  atexit (kill_targets);
+  check_stops ();
+  check_memory ();
+  check_tables ();
+
+  if (argc - optind == 2)
+    {
+      targets[0].path = argv[optind];
+      targets[1].path = argv[optind + 1];
+      start_target (&targets[0]);
+      start_target (&targets[1]);
+      check_names ();
+      finish_target (&targets[0]);
+      finish_target (&targets[1]);
+    }
+
+  unw_destroy_addr_space (as);
+  printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
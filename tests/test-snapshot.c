@@ -0,0 +1,276 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test checks libunwind-snapshot on samples of its own stack: it
+   records the registers and a copy of the top of the stack the way a
+   profiler would, adds the file mappings from /proc/self/maps and
+   checks that unwinding the sample finds the same frames as unwinding
+   the live stack.  A mapping with the wrong build-id must not be
+   used.  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#include <libunwind.h>
+#include <libunwind-snapshot.h>
+
+#define NREGS           (UNW_REG_LAST + 1)
+#define MAX_STACK       (64 * 1024)
+#define MAX_FRAMES      64
+
+struct sample
+  {
+    unw_word_t regs[NREGS];
+    unw_word_t stack_addr;
+    size_t stack_size;
+    char stack[MAX_STACK];
+    unw_word_t ips[MAX_FRAMES];         /* from the live stack */
+    int nframes;
+  };
+
+static struct sample samples[2];
+static char exe_name[4096];
+static unw_word_t exe_start, exe_end, exe_offset;
+
+int verbose;
+
+/* Return the end of the mapping of /proc/self/maps containing ADDR.  */
+static unw_word_t
+mapping_end (unw_word_t addr)
+{
+  unsigned long start, end;
+  char line[4096];
+  FILE *f;
+
+  UNW_TEST_ASSERT ((f = fopen ("/proc/self/maps", "r")) != NULL,
+                   "cannot open /proc/self/maps\n");
+  while (fgets (line, sizeof (line), f))
+    if (sscanf (line, "%lx-%lx", &start, &end) == 2
+        && start <= addr && addr < end)
+      {
+        fclose (f);
+        return end;
+      }
+  fclose (f);
+  return addr;
+}
+
+/* Record the registers of this frame and the stack above it in S, then
+   unwind the live stack for comparison.  */
+static void NOINLINE
+capture (struct sample *s)
+{
+  unw_context_t uc;
+  unw_cursor_t c;
+  unw_word_t sp, end;
+  int r;
+
+  UNW_TEST_ASSERT (unw_getcontext (&uc) == 0, "unw_getcontext failed\n");
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+
+  for (r = 0; r < NREGS; ++r)
+    if (unw_get_reg (&c, r, &s->regs[r]) < 0)
+      s->regs[r] = 0;
+
+  unw_get_reg (&c, UNW_REG_SP, &sp);
+  end = mapping_end (sp);
+  if (end - sp > MAX_STACK)
+    end = sp + MAX_STACK;
+  s->stack_addr = sp;
+  s->stack_size = end - sp;
+  memcpy (s->stack, (void *) (uintptr_t) sp, s->stack_size);
+
+  s->nframes = 0;
+  do
+    unw_get_reg (&c, UNW_REG_IP, &s->ips[s->nframes++]);
+  while (s->nframes < MAX_FRAMES && unw_step (&c) > 0);
+}
+
+static void NOINLINE
+recurse (struct sample *s, int depth)
+{
+  if (depth > 0)
+    recurse (s, depth - 1);
+  else
+    capture (s);
+  __asm__ __volatile__ ("" ::: "memory");
+}
+
+/* Add the file mappings of this process to UI.  */
+static void
+add_mappings (struct USN_info *ui)
+{
+  unsigned long start, end, offset;
+  char line[4096], perms[8], path[4096];
+  FILE *f;
+  int n;
+
+  UNW_TEST_ASSERT ((f = fopen ("/proc/self/maps", "r")) != NULL,
+                   "cannot open /proc/self/maps\n");
+  while (fgets (line, sizeof (line), f))
+    {
+      n = sscanf (line, "%lx-%lx %7s %lx %*s %*s %4095s",
+                  &start, &end, perms, &offset, path);
+      if (n != 5 || path[0] != '/')
+        continue;
+      UNW_TEST_ASSERT (_USN_add_mapping (ui, start, end, offset, path,
+                                         NULL, 0) == 0,
+                       "_USN_add_mapping failed for %s\n", path);
+      if (start <= (uintptr_t) &capture && (uintptr_t) &capture < end)
+        {
+          strcpy (exe_name, path);
+          exe_start = start;
+          exe_end = end;
+          exe_offset = offset;
+        }
+    }
+  fclose (f);
+}
+
+/* Unwind sample S through AS and compare with the live unwind.  */
+static void
+check_sample (unw_addr_space_t as, struct USN_info *ui, struct sample *s)
+{
+  unw_cursor_t c;
+  unw_word_t ip, off;
+  char name[64];
+  int n = 0, ret;
+
+  UNW_TEST_ASSERT (_USN_set_sample (ui, s->regs, NREGS, s->stack_addr,
+                                    s->stack, s->stack_size) == 0,
+                   "_USN_set_sample failed\n");
+  UNW_TEST_ASSERT (unw_init_remote (&c, as, ui) == 0,
+                   "unw_init_remote failed\n");
+  UNW_TEST_ASSERT (unw_get_proc_name (&c, name, sizeof (name), &off) == 0
+                   && strcmp (name, "capture") == 0,
+                   "frame 0 is not in capture()\n");
+  do
+    {
+      unw_get_reg (&c, UNW_REG_IP, &ip);
+      if (verbose)
+        printf ("  frame %d: %#" PRIxPTR " (live %#" PRIxPTR ")\n", n,
+                (uintptr_t) ip, n < s->nframes ? (uintptr_t) s->ips[n] : 0);
+      UNW_TEST_ASSERT (n < s->nframes && ip == s->ips[n],
+                       "frame %d: ip %#lx differs from the live stack\n",
+                       n, (long) ip);
+      ++n;
+    }
+  while ((ret = unw_step (&c)) > 0 && n < s->nframes);
+  UNW_TEST_ASSERT (n >= 4, "only %d frames unwound (%d)\n", n, ret);
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  static const char bogus_id[20] = "not the build-id";
+  unw_addr_space_t as;
+  struct USN_info *ui;
+  unw_stats_t s1, s2;
+  unw_cursor_t c;
+  unw_word_t off, page;
+  char name[64];
+  int have_stats;
+
+  verbose = argc > 1;
+
+  recurse (&samples[0], 2);
+  recurse (&samples[1], 5);
+
+  UNW_TEST_ASSERT ((ui = _USN_create ()) != NULL, "_USN_create failed\n");
+  add_mappings (ui);
+  UNW_TEST_ASSERT (exe_name[0] != '\0', "executable mapping not found\n");
+
+  as = unw_create_addr_space (&_USN_accessors, 0);
+  UNW_TEST_ASSERT (as != NULL, "unw_create_addr_space failed\n");
+  unw_set_caching_policy (as, UNW_CACHE_GLOBAL);
+
+  if (verbose)
+    printf ("sample 0\n");
+  check_sample (as, ui, &samples[0]);
+  have_stats = unw_get_stats (as, &s1) == 0;
+
+  /* The second sample reuses the images and tables of the first.  */
+  if (verbose)
+    printf ("sample 1\n");
+  check_sample (as, ui, &samples[1]);
+  if (have_stats)
+    {
+      unw_get_stats (as, &s2);
+      UNW_TEST_ASSERT (s2.elf_maps == s1.elf_maps,
+                       "%lu images mapped again\n",
+                       (unsigned long) (s2.elf_maps - s1.elf_maps));
+    }
+
+  /* A mapping that covers only part of another one leaves the rest of
+     it in place: extend the mapping of capture() by a page, then map
+     that page again on its own.  */
+  page = exe_end;
+  UNW_TEST_ASSERT (_USN_add_mapping (ui, exe_start, page + getpagesize (),
+                                     exe_offset, exe_name, NULL, 0) == 0
+                   && _USN_add_mapping (ui, page, page + getpagesize (),
+                                        exe_offset + (page - exe_start),
+                                        exe_name, NULL, 0) == 0,
+                   "_USN_add_mapping failed\n");
+  unw_flush_cache (as, 0, 0);
+  if (verbose)
+    printf ("sample 1 with %#lx remapped\n", (long) page);
+  check_sample (as, ui, &samples[1]);
+
+  /* With a build-id that does not match, the executable is not used.  */
+  UNW_TEST_ASSERT (_USN_add_mapping (ui, exe_start, exe_end, exe_offset,
+                                     exe_name, bogus_id,
+                                     sizeof (bogus_id)) == 0,
+                   "_USN_add_mapping failed\n");
+  unw_flush_cache (as, 0, 0);
+  UNW_TEST_ASSERT (unw_init_remote (&c, as, ui) == 0,
+                   "unw_init_remote failed\n");
+  UNW_TEST_ASSERT (unw_get_proc_name (&c, name, sizeof (name), &off) < 0,
+                   "executable used despite the wrong build-id\n");
+
+  unw_destroy_addr_space (as);
+  _USN_destroy (ui);
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
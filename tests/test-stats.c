@@ -0,0 +1,186 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test verifies the counters reported by unw_get_stats(): that
+   unwinding the same stack twice turns rs-cache misses into hits, that
+   uncached lookups walk the loaded objects and map ELF images, that
+   unw_reset_stats() clears everything and that no event is lost while
+   several threads count at the same time.  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+#define NTHREADS        8
+#define NUNWINDS        200
+
+int verbose;
+
+/* Unwind the current stack and return the number of lookups done:
+   one for each successful or final step.  */
+static unsigned long NOINLINE
+unwind (int get_names)
+{
+  unw_context_t uc;
+  unw_cursor_t c;
+  unsigned long steps = 0;
+  unw_word_t off;
+  char name[128];
+  int ret;
+
+  UNW_TEST_ASSERT (unw_getcontext (&uc) == 0, "unw_getcontext failed\n");
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  do
+    {
+      if (get_names)
+        unw_get_proc_name (&c, name, sizeof (name), &off);
+      ret = unw_step (&c);
+      ++steps;
+    }
+  while (ret > 0);
+  return steps;
+}
+
+static unsigned long lookups[NTHREADS];
+
+static void *
+worker (void *arg)
+{
+  unsigned long *n = arg;
+  int i;
+
+  for (i = 0; i < NUNWINDS; ++i)
+    *n += unwind (0);
+  return NULL;
+}
+
+static unsigned long
+total (const unw_stats_t *s)
+{
+  return s->rs_cache_hits + s->rs_cache_misses + s->compact_table_hits
+         + s->trace_cache_expansions + s->phdr_walks + s->validate_syscalls
+         + s->elf_maps;
+}
+
+static void
+print_stats (const char *what, const unw_stats_t *s)
+{
+  if (verbose)
+    printf ("%s: rs hits %lu misses %lu, compact hits %lu, trace expansions"
+            " %lu, phdr walks %lu, validate syscalls %lu, elf maps %lu\n",
+            what, s->rs_cache_hits, s->rs_cache_misses, s->compact_table_hits,
+            s->trace_cache_expansions, s->phdr_walks, s->validate_syscalls,
+            s->elf_maps);
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  pthread_t threads[NTHREADS];
+  unsigned long expected;
+  unw_stats_t s;
+  int i;
+
+  verbose = argc > 1;
+
+  unw_reset_stats (unw_local_addr_space);
+  if (unw_get_stats (unw_local_addr_space, &s) < 0)
+    {
+      printf ("statistics are disabled\n");
+      return UNW_TEST_EXIT_SKIP;
+    }
+  UNW_TEST_ASSERT (total (&s) == 0, "counters not cleared\n");
+
+  /* Without a cache every lookup is a miss, walks the objects and every
+     name lookup maps an image.  */
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_NONE);
+  expected = unwind (1);
+  unw_get_stats (unw_local_addr_space, &s);
+  print_stats ("uncached", &s);
+  UNW_TEST_ASSERT (s.rs_cache_misses >= expected,
+                   "%lu misses for %lu lookups\n", s.rs_cache_misses, expected);
+  UNW_TEST_ASSERT (s.rs_cache_hits == 0, "%lu hits without a cache\n",
+                   s.rs_cache_hits);
+  UNW_TEST_ASSERT (s.phdr_walks > 0, "no walks over the objects\n");
+  UNW_TEST_ASSERT (s.elf_maps > 0, "no ELF images mapped\n");
+
+  /* The second unwind of the same stack hits the cache.  */
+  unw_set_caching_policy (unw_local_addr_space, UNW_CACHE_GLOBAL);
+  unwind (0);
+  unw_reset_stats (unw_local_addr_space);
+  expected = unwind (0);
+  unw_get_stats (unw_local_addr_space, &s);
+  print_stats ("cached", &s);
+  UNW_TEST_ASSERT (s.rs_cache_hits + s.compact_table_hits >= expected - 1,
+                   "%lu hits for %lu lookups\n",
+                   s.rs_cache_hits + s.compact_table_hits, expected);
+
+  unw_reset_stats (unw_local_addr_space);
+  unw_get_stats (unw_local_addr_space, &s);
+  UNW_TEST_ASSERT (total (&s) == 0, "counters not cleared\n");
+
+  for (i = 0; i < NTHREADS; ++i)
+    UNW_TEST_ASSERT (pthread_create (&threads[i], NULL, worker,
+                                     &lookups[i]) == 0,
+                     "pthread_create failed\n");
+  for (expected = 0, i = 0; i < NTHREADS; ++i)
+    {
+      pthread_join (threads[i], NULL);
+      expected += lookups[i];
+    }
+  unw_get_stats (unw_local_addr_space, &s);
+  print_stats ("threads", &s);
+  UNW_TEST_ASSERT (s.rs_cache_hits + s.rs_cache_misses + s.compact_table_hits
+                   >= expected,
+                   "%lu lookups counted, %lu done\n",
+                   s.rs_cache_hits + s.rs_cache_misses + s.compact_table_hits,
+                   expected);
+
+  if (verbose)
+    printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
@@ -0,0 +1,273 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+/* This test verifies that unw_backtrace() gives the same frames as a
+   unw_step() loop through each kind of frame that the fast traces of
+   tdep_trace() handle: ordinary frames, frames whose CFA is based on
+   the frame pointer, signal trampolines, a leaf interrupted by a
+   signal, which returns through the live return address register, and
+   on ppc64 a frame without unwind info, which is left through the
+   back chain.
+
+   Every call site is traced twice.  The second trace finds all frames
+   in the frame cache, so on targets with a fast trace it must not need
+   any unwind info; a frame the fast trace cannot follow would make it
+   fall back to unw_step() and show up here.  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+#if defined(UNW_TARGET_X86_64) || defined(UNW_TARGET_AARCH64) \
+    || defined(UNW_TARGET_RISCV) || defined(UNW_TARGET_LOONGARCH64) \
+    || defined(UNW_TARGET_PPC64) || defined(UNW_TARGET_S390X)
+# define HAVE_FAST_TRACE 1
+#endif
+
+#if defined(__powerpc64__) && defined(_CALL_ELF) && _CALL_ELF == 2
+/* Calls FN from a minimal ELFv2 frame that has no CFI, so the only
+   way out of it is the back chain at 0(r1) and the LR save slot of the
+   caller's frame.  */
+# define HAVE_NOCFI_CALL 1
+void nocfi_call (void (*fn) (void));
+__asm__ (
+"        .text\n"
+"        .align  2\n"
+"        .type   nocfi_call, @function\n"
+"nocfi_call:\n"
+"        mflr    0\n"
+"        std     0, 16(1)\n"
+"        stdu    1, -32(1)\n"
+"        std     2, 24(1)\n"
+"        mtctr   3\n"
+"        mr      12, 3\n"
+"        bctrl\n"
+"        ld      2, 24(1)\n"
+"        addi    1, 1, 32\n"
+"        ld      0, 16(1)\n"
+"        mtlr    0\n"
+"        blr\n"
+"        .size   nocfi_call, . - nocfi_call\n");
+#endif
+
+#define MAX_FRAMES      64
+
+int verbose;
+int checks;
+
+static volatile sig_atomic_t interrupted;
+/* Not a constant, so that the compiler can't give each pass its own
+   call to trace_from_here().  */
+static volatile int passes = 2;
+
+
+/* The only call site of unw_backtrace(), so that a second trace finds
+   every frame in the cache.  */
+static int NOINLINE
+trace_from_here (void **trace)
+{
+  return unw_backtrace (trace, MAX_FRAMES);
+}
+
+
+/* TRACE starts with trace_from_here(), IP with check().  */
+static void
+compare (const char *where, const char *what, void **trace, int ntrace,
+         unw_word_t *ip, int nsteps)
+{
+  int i;
+
+  UNW_TEST_ASSERT (ntrace == nsteps + 1, "%s: %s unw_backtrace gave %d"
+                   " frames, unw_step %d\n", where, what, ntrace - 1, nsteps);
+  /* Frame 0 is check() itself, at different call sites.  */
+  for (i = 1; i < nsteps; ++i)
+    UNW_TEST_ASSERT ((unw_word_t) trace[i + 1] == ip[i],
+                     "%s: %s frame %d is 0x%lx, unw_step has 0x%lx\n",
+                     where, what, i, (long) trace[i + 1], (long) ip[i]);
+}
+
+
+static void NOINLINE
+check (const char *where)
+{
+  void *trace[2][MAX_FRAMES];
+  unw_word_t ip[MAX_FRAMES];
+  unw_context_t uc;
+  unw_cursor_t c;
+  unw_stats_t stats;
+  int ntrace[2], nsteps = 0, pass;
+
+  /* Only the last pass leaves its counts in STATS.  */
+  for (pass = 0; pass < passes; ++pass)
+    {
+      unw_reset_stats (unw_local_addr_space);
+      ntrace[pass] = trace_from_here (trace[pass]);
+      if (unw_get_stats (unw_local_addr_space, &stats) < 0)
+        memset (&stats, 0, sizeof (stats));
+    }
+
+  UNW_TEST_ASSERT (unw_getcontext (&uc) == 0, "unw_getcontext failed\n");
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  do
+    unw_get_reg (&c, UNW_REG_IP, &ip[nsteps++]);
+  while (nsteps < MAX_FRAMES && unw_step (&c) > 0);
+
+  if (verbose)
+    {
+      int i;
+
+      printf ("%s: %d frames, %lu unwind info lookups when warm\n", where,
+              nsteps, stats.rs_cache_hits + stats.rs_cache_misses
+                      + stats.compact_table_hits);
+      for (i = 0; i < nsteps; ++i)
+        printf ("  %2d 0x%lx\n", i, (long) ip[i]);
+    }
+
+  compare (where, "cold", trace[0], ntrace[0], ip, nsteps);
+  compare (where, "warm", trace[1], ntrace[1], ip, nsteps);
+#ifdef HAVE_FAST_TRACE
+  UNW_TEST_ASSERT (stats.rs_cache_hits + stats.rs_cache_misses
+                   + stats.compact_table_hits == 0,
+                   "%s: warm unw_backtrace looked up unwind info\n", where);
+#endif
+  ++checks;
+}
+
+
+/* The CFA of this frame is based on the frame pointer.  */
+static void NOINLINE
+check_vla (const char *where, long n)
+{
+  volatile char buf[n];
+
+  buf[0] = 0;
+  check (where);
+  buf[n - 1] = buf[0];
+}
+
+
+static void NOINLINE
+check_plain (const char *where)
+{
+  check (where);
+  check_vla (where, 64 + strlen (where));
+}
+
+
+#ifdef HAVE_NOCFI_CALL
+static void NOINLINE
+check_back_chain (void)
+{
+  check ("back chain");
+}
+#endif
+
+
+static void
+sync_handler (int sig UNUSED)
+{
+  check_plain ("signal");
+}
+
+
+static void
+leaf_handler (int sig UNUSED)
+{
+  check ("interrupted leaf");
+  interrupted = 1;
+}
+
+
+/* Makes no calls, so the signal finds its return address in the
+   return address register on targets that have one.  */
+static void NOINLINE
+spin (void)
+{
+  while (!interrupted)
+    ;
+}
+
+
+int
+main (int argc, char **argv UNUSED)
+{
+  struct sigaction sa;
+  struct itimerval it;
+  int i;
+
+  verbose = argc > 1;
+
+  memset (&sa, 0, sizeof (sa));
+  sigemptyset (&sa.sa_mask);
+
+  check_plain ("plain");
+#ifdef HAVE_NOCFI_CALL
+  nocfi_call (check_back_chain);
+#endif
+
+  sa.sa_handler = sync_handler;
+  UNW_TEST_ASSERT (sigaction (SIGUSR1, &sa, NULL) == 0, "sigaction failed\n");
+  raise (SIGUSR1);
+
+  /* The timer may hit before spin() runs; try again then.  */
+  sa.sa_handler = leaf_handler;
+  UNW_TEST_ASSERT (sigaction (SIGALRM, &sa, NULL) == 0, "sigaction failed\n");
+  for (i = 0; i < 3; ++i)
+    {
+      interrupted = 0;
+      memset (&it, 0, sizeof (it));
+      it.it_value.tv_usec = 10000;
+      UNW_TEST_ASSERT (setitimer (ITIMER_REAL, &it, NULL) == 0,
+                       "setitimer failed\n");
+      spin ();
+    }
+
+  if (verbose)
+    printf ("SUCCESS: %d call sites\n", checks);
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */
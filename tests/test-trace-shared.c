@@ -0,0 +1,228 @@
+/* libunwind - a platform-independent unwind library
+
+This file is part of libunwind.
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.  */
+
+
+/* This test verifies that unw_backtrace() with the process-wide trace
+   cache (UNW_TRACE_CACHE=shared) and with per-thread caches in front of
+   it (UNW_TRACE_CACHE=shared,thread) gives the same frames as a
+   unw_step() loop, while several threads fill the cache concurrently.
+   Meanwhile one thread backtraces from thousands of distinct call
+   sites, so that the shared table has to grow under the other threads.
+   The mode is read once per process, so each mode runs in a child.  */
+
+#if !defined(UNW_REMOTE_ONLY)
+
+#if defined(HAVE_CONFIG_H)
+# include "config.h"
+#endif
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "compiler.h"
+#include "unw_test.h"
+
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+
+#define MAX_FRAMES      64
+#define NTHREADS        8
+#define ITERS           200
+
+int verbose;
+
+static volatile int filling;
+
+static void NOINLINE
+check (void)
+{
+  void *trace[MAX_FRAMES];
+  unw_word_t ip[MAX_FRAMES];
+  unw_context_t uc;
+  unw_cursor_t c;
+  int ntrace, nsteps = 0, i;
+
+  ntrace = unw_backtrace (trace, MAX_FRAMES);
+
+  UNW_TEST_ASSERT (unw_getcontext (&uc) == 0, "unw_getcontext failed\n");
+  UNW_TEST_ASSERT (unw_init_local (&c, &uc) == 0, "unw_init_local failed\n");
+  do
+    unw_get_reg (&c, UNW_REG_IP, &ip[nsteps++]);
+  while (nsteps < MAX_FRAMES && unw_step (&c) > 0);
+
+  UNW_TEST_ASSERT (ntrace == nsteps, "unw_backtrace gave %d frames,"
+                   " unw_step %d\n", ntrace, nsteps);
+  /* Frame 0 is check() itself, at two different call sites.  */
+  for (i = 1; i < nsteps; ++i)
+    UNW_TEST_ASSERT ((unw_word_t) trace[i] == ip[i],
+                     "frame %d differs: %p vs. 0x%lx\n", i, trace[i],
+                     (long) ip[i]);
+}
+
+/* Recurse through a mix of functions so that the threads share some
+   frames and race to publish them.  */
+static int NOINLINE recurse_b (int n);
+
+static int NOINLINE
+recurse_a (int n)
+{
+  if (n <= 0)
+    {
+      check ();
+      return 0;
+    }
+  return (n & 1 ? recurse_a (n - 1) : recurse_b (n - 1)) + 1;
+}
+
+static int NOINLINE
+recurse_b (int n)
+{
+  if (n <= 0)
+    {
+      check ();
+      return 0;
+    }
+  return (n & 2 ? recurse_b (n - 1) : recurse_a (n - 1)) + 1;
+}
+
+static void *
+worker (void *arg)
+{
+  long id = (long) arg;
+  int i;
+
+  for (i = 0; i < ITERS || filling; ++i)
+    recurse_a ((int) (id + i) % 16);
+  return NULL;
+}
+
+/* 4096 call sites of check(), more than half the initial size of the
+   shared table.  The asm after each call keeps the compiler from
+   merging the calls.  */
+#define SITE(k)         case (k): check (); \
+                          __asm__ __volatile__ ("" : : "i" (k) : "memory"); \
+                          break;
+#define SITES4(k)       SITE (k) SITE ((k) + 1) SITE ((k) + 2) SITE ((k) + 3)
+#define SITES16(k)      SITES4 (k) SITES4 ((k) + 4) SITES4 ((k) + 8) \
+                        SITES4 ((k) + 12)
+#define SITES64(k)      SITES16 (k) SITES16 ((k) + 16) SITES16 ((k) + 32) \
+                        SITES16 ((k) + 48)
+#define SITES256(k)     SITES64 (k) SITES64 ((k) + 64) SITES64 ((k) + 128) \
+                        SITES64 ((k) + 192)
+#define SITES1024(k)    SITES256 (k) SITES256 ((k) + 256) \
+                        SITES256 ((k) + 512) SITES256 ((k) + 768)
+#define NSITES          4096
+
+static void NOINLINE
+call_site (int k)
+{
+  switch (k)
+    {
+      SITES1024 (0)
+      SITES1024 (1024)
+      SITES1024 (2048)
+      SITES1024 (3072)
+    }
+}
+
+static void
+fill (void)
+{
+  int k;
+
+  for (k = 0; k < NSITES; ++k)
+    call_site (k);
+}
+
+static int
+run (const char *mode)
+{
+  pthread_t threads[NTHREADS];
+  int status;
+  long i;
+  pid_t pid;
+
+  fflush (stdout);
+  if ((pid = fork ()) < 0)
+    return UNW_TEST_EXIT_HARD_ERROR;
+  if (pid == 0)
+    {
+      unw_stats_t stats;
+
+      setenv ("UNW_TRACE_CACHE", mode, 1);
+      filling = 1;
+      for (i = 0; i < NTHREADS; ++i)
+        pthread_create (&threads[i], NULL, worker, (void *) i);
+      fill ();
+      filling = 0;
+      for (i = 0; i < NTHREADS; ++i)
+        pthread_join (threads[i], NULL);
+
+      /* Only the shared table grows in "shared" mode.  */
+      if (strcmp (mode, "shared") == 0
+          && unw_get_stats (unw_local_addr_space, &stats) == 0)
+        UNW_TEST_ASSERT (stats.trace_cache_expansions > 0,
+                         "the shared table did not grow\n");
+      exit (UNW_TEST_EXIT_PASS);
+    }
+
+  if (waitpid (pid, &status, 0) != pid || ! WIFEXITED (status))
+    {
+      fprintf (stderr, "%s: child did not exit normally\n", mode);
+      return UNW_TEST_EXIT_FAIL;
+    }
+  if (verbose)
+    printf ("%s: exit status %d\n", mode, WEXITSTATUS (status));
+  return WEXITSTATUS (status);
+}
+
+int
+main (int argc, char **argv UNUSED)
+{
+  int ret;
+
+  verbose = argc > 1;
+  if ((ret = run ("shared")) != UNW_TEST_EXIT_PASS)
+    return ret;
+  if ((ret = run ("shared,thread")) != UNW_TEST_EXIT_PASS)
+    return ret;
+
+  if (verbose)
+    printf ("SUCCESS\n");
+  return UNW_TEST_EXIT_PASS;
+}
+
+#else /* defined(UNW_REMOTE_ONLY) */
+
+#include "unw_test.h"
+
+int
+main (void)
+{
+  return UNW_TEST_EXIT_SKIP;
+}
+
+#endif /* defined(UNW_REMOTE_ONLY) */